@@ -0,0 +1,624 @@
+#include "Converter.h"
+#include "MeshGenerator.h"
+#include "SubsetDecoder.h"
+#include "ChunkWriter.h"
+#include "JSONWriter.h"
+#include "MappedFile.h"
+#include "CommandLine.h"
+#include "Log.h"
+
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Throughput benchmark of the export pipeline on generated meshes (MeshGenerator).
+// Each case is timed per phase (best of -repeat runs):
+//   load    SDKMesh::Create (read + pointer fixup)
+//   remap   SubsetDecoder::Remap of every subset
+//   decode  positions, normals & texcoords of the remapped vertices
+//   format  OBJ text of the decoded subsets (ChunkWriter::Print), discarded
+//   write   the formatted text written to a file
+//   total   convert() to OBJ, end to end
+// and the heap calls of the total conversion (HeapCounter.cpp counts every operator new).
+// The results (-json FILE) can be stored and passed back with -baseline FILE: phases whose
+// triangles/s dropped more than -tolerance (default 0.1) are reported and the exit code is 1.
+
+#define BENCHMARK_VERSION 1
+
+// vertices decoded per chunk
+#define BENCHMARK_CHUNK_VERTICES 1024
+
+struct BenchmarkCase
+{
+	const char *Name;
+	GeneratorOptions Options;
+};
+
+struct PhaseResult
+{
+	const char *Name;
+	double Seconds;
+	UINT64 Bytes;
+};
+
+// decoded streams of a subset
+struct DecodedSubset
+{
+	std::vector<float> Positions;
+	std::vector<float> Normals;
+	std::vector<float> Texcoords;
+};
+
+static double getTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// -------------------------------------------------------------------------------------
+// minimal JSON reader: numbers of the document by dotted path (cases.NAME.load.seconds)
+
+static void skipSpace(const char *&p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+		p++;
+}
+
+static bool parseString(const char *&p, std::string& s)
+{
+	if (*p != '"')
+		return false;
+	p++;
+
+	s.clear();
+	while (*p != 0 && *p != '"')
+	{
+		if (*p == '\\' && p[1] != 0)
+			p++;
+		s += *p++;
+	}
+
+	if (*p != '"')
+		return false;
+	p++;
+	return true;
+}
+
+static bool parseValue(const char *&p, const std::string& path, std::map<std::string, double>& values)
+{
+	skipSpace(p);
+
+	if (*p == '{' || *p == '[')
+	{
+		bool object = *p == '{';
+		char close = object ? '}' : ']';
+		p++;
+
+		for (int i = 0; ; i++)
+		{
+			skipSpace(p);
+			if (*p == close)
+			{
+				p++;
+				return true;
+			}
+
+			std::string key;
+			if (object)
+			{
+				if (!parseString(p, key))
+					return false;
+				skipSpace(p);
+				if (*p != ':')
+					return false;
+				p++;
+			}
+			else
+				key = std::to_string(i);
+
+			if (!parseValue(p, path.empty() ? key : path + "." + key, values))
+				return false;
+
+			skipSpace(p);
+			if (*p == ',')
+				p++;
+			else if (*p != close)
+				return false;
+		}
+	}
+
+	if (*p == '"')
+	{
+		std::string s;
+		return parseString(p, s);
+	}
+
+	const char *literals[] = { "true", "false", "null" };
+	for (int i = 0; i < 3; i++)
+	{
+		size_t length = strlen(literals[i]);
+		if (strncmp(p, literals[i], length) == 0)
+		{
+			p += length;
+			return true;
+		}
+	}
+
+	char *end = NULL;
+	double value = strtod(p, &end);
+	if (end == p)
+		return false;
+
+	values[path] = value;
+	p = end;
+	return true;
+}
+
+static bool readJSON(const char *path, std::map<std::string, double>& values)
+{
+	MappedFile file;
+	if (!file.Open(path))
+		return false;
+
+	std::string text((const char*)file.GetData(), file.GetSize());
+	const char *p = text.c_str();
+	return parseValue(p, "", values);
+}
+
+// -------------------------------------------------------------------------------------
+
+static void formatSubset(ChunkWriter& out, const DecodedSubset& decoded, const SubsetRemap& remap, UINT64 firstVertex)
+{
+	size_t numVertices = remap.Vertices.size();
+
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		const float *p = &decoded.Positions[i * 3];
+		out.Print("v %f %f %f\n", p[0], p[1], p[2]);
+	}
+
+	for (size_t i = 0; i < numVertices && !decoded.Normals.empty(); i++)
+	{
+		const float *n = &decoded.Normals[i * 3];
+		out.Print("vn %f %f %f\n", n[0], n[1], n[2]);
+	}
+
+	for (size_t i = 0; i < numVertices && !decoded.Texcoords.empty(); i++)
+	{
+		const float *t = &decoded.Texcoords[i * 2];
+		out.Print("vt %f %f\n", t[0], t[1]);
+	}
+
+	const std::vector<UINT>& indices = remap.Indices;
+	for (size_t i = 0, n = indices.size(); i < n; i += 3)
+	{
+		UINT64 m0 = indices[i] + firstVertex;
+		UINT64 m1 = indices[i + 1] + firstVertex;
+		UINT64 m2 = indices[i + 2] + firstVertex;
+
+		out.Print("f %llu/%llu/%llu %llu/%llu/%llu %llu/%llu/%llu\n",
+			m0, m0, m0,
+			m1, m1, m1,
+			m2, m2, m2);
+	}
+}
+
+static void formatMesh(ChunkWriter& out, const std::vector<std::vector<DecodedSubset> >& decoded, const std::vector<std::vector<SubsetRemap> >& remaps)
+{
+	UINT64 firstVertex = 1;
+	for (size_t i = 0; i < remaps.size(); i++)
+	{
+		for (size_t j = 0; j < remaps[i].size(); j++)
+		{
+			formatSubset(out, decoded[i][j], remaps[i][j], firstVertex);
+			firstVertex += remaps[i][j].Vertices.size();
+		}
+	}
+}
+
+// one run of every phase, the best time of each phase is kept in 'phases'
+static bool runPhases(const char *input, const char *output, std::vector<PhaseResult>& phases, UINT64& allocations)
+{
+	double times[6];
+	UINT64 bytes[6] = { 0 };
+
+	// load
+	double start = getTime();
+
+	SDKMesh sdkMesh;
+	if (sdkMesh.Create(input) != S_OK)
+		return false;
+
+	times[0] = getTime() - start;
+	bytes[0] = sdkMesh.GetHeader()->HeaderSize + sdkMesh.GetHeader()->NonBufferDataSize + sdkMesh.GetHeader()->BufferDataSize;
+
+	// remap
+	start = getTime();
+
+	UINT numMeshes = sdkMesh.GetNumMeshes();
+	std::vector<std::vector<SubsetRemap> > remaps(numMeshes);
+	for (UINT i = 0; i < numMeshes; i++)
+	{
+		SubsetDecoder decoder(&sdkMesh, i);
+
+		UINT numSubsets = sdkMesh.GetNumSubsets(i);
+		remaps[i].resize(numSubsets);
+		for (UINT j = 0; j < numSubsets; j++)
+		{
+			SDKMESH_SUBSET *subset = sdkMesh.GetSubset(i, j);
+			decoder.Remap(subset, remaps[i][j]);
+			bytes[1] += subset->IndexCount * (sdkMesh.GetIndexType(i) == IT_32BIT ? 4 : 2);
+		}
+	}
+
+	times[1] = getTime() - start;
+
+	// decode
+	start = getTime();
+
+	std::vector<std::vector<DecodedSubset> > decoded(numMeshes);
+	for (UINT i = 0; i < numMeshes; i++)
+	{
+		SubsetDecoder decoder(&sdkMesh, i);
+		UINT stride = sdkMesh.GetVertexStride(i, 0);
+
+		decoded[i].resize(remaps[i].size());
+		for (size_t j = 0; j < remaps[i].size(); j++)
+		{
+			const std::vector<UINT>& vertices = remaps[i][j].Vertices;
+			DecodedSubset& subset = decoded[i][j];
+
+			subset.Positions.resize(vertices.size() * 3);
+			if (decoder.HasNormal())
+				subset.Normals.resize(vertices.size() * 3);
+			if (decoder.HasTexcoord())
+				subset.Texcoords.resize(vertices.size() * 2);
+
+			for (size_t begin = 0, n = vertices.size(); begin < n; begin += BENCHMARK_CHUNK_VERTICES)
+			{
+				UINT count = (UINT)(n - begin < BENCHMARK_CHUNK_VERTICES ? n - begin : BENCHMARK_CHUNK_VERTICES);
+				const UINT *chunk = vertices.data() + begin;
+
+				decoder.DecodePositions(chunk, count, &subset.Positions[begin * 3]);
+				if (!subset.Normals.empty())
+					decoder.DecodeNormals(chunk, count, &subset.Normals[begin * 3]);
+				if (!subset.Texcoords.empty())
+					decoder.DecodeTexcoords(chunk, count, &subset.Texcoords[begin * 2]);
+			}
+
+			bytes[2] += vertices.size() * stride;
+		}
+	}
+
+	times[2] = getTime() - start;
+
+	// format, counted and discarded
+	start = getTime();
+
+	UINT64 formatted = 0;
+	CallbackSink counter([&formatted](const void *, size_t size)
+	{
+		formatted += size;
+		return true;
+	});
+
+	{
+		ChunkWriter out(&counter);
+		formatMesh(out, decoded, remaps);
+	}
+
+	times[3] = getTime() - start;
+	bytes[3] = formatted;
+
+	// write
+	MemorySink text;
+	{
+		ChunkWriter out(&text);
+		formatMesh(out, decoded, remaps);
+	}
+
+	start = getTime();
+
+	FileSink file;
+	if (!file.Open(output, "wb") || !file.Write(text.GetData(), text.GetSize()) || !file.Close())
+		return false;
+
+	times[4] = getTime() - start;
+	bytes[4] = text.GetSize();
+
+	// total, without the conversion log
+	start = getTime();
+
+	ConvertStats stats;
+	ConvertOptions options;
+	ConvertResult result;
+	result.Stats = &stats;
+
+	LOG_LEVEL level = Log::GetLevel();
+	Log::SetLevel(LOG_NONE);
+	int r = convert(input, output, options, result);
+	Log::SetLevel(level);
+
+	if (r != 0)
+		return false;
+
+	allocations = stats.GetCounter(SC_ALLOCATIONS);
+
+	times[5] = getTime() - start;
+	bytes[5] = bytes[0];
+
+	static const char *names[] = { "load", "remap", "decode", "format", "write", "total" };
+	if (phases.empty())
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			PhaseResult phase = { names[i], times[i], bytes[i] };
+			phases.push_back(phase);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			if (times[i] < phases[i].Seconds)
+				phases[i].Seconds = times[i];
+		}
+	}
+
+	return true;
+}
+
+static void getCases(UINT64 numTriangles, std::vector<BenchmarkCase>& cases)
+{
+	BenchmarkCase c;
+
+	// 16 bit indices: each mesh under 65535 vertices up to ~1M triangles
+	c.Name = "ordered-16";
+	c.Options = GeneratorOptions();
+	c.Options.NumTriangles = numTriangles;
+	c.Options.NumMeshes = 8;
+	c.Options.NumSubsets = 4;
+	cases.push_back(c);
+
+	c.Name = "shuffled-32";
+	c.Options = GeneratorOptions();
+	c.Options.NumTriangles = numTriangles;
+	c.Options.NumSubsets = 4;
+	c.Options.Index32 = true;
+	c.Options.Locality = GL_SHUFFLED;
+	cases.push_back(c);
+
+	c.Name = "scattered-compact";
+	c.Options = GeneratorOptions();
+	c.Options.NumTriangles = numTriangles;
+	c.Options.Index32 = true;
+	c.Options.Declaration = GD_COMPACT;
+	c.Options.Locality = GL_SCATTERED;
+	cases.push_back(c);
+
+	c.Name = "many-meshes";
+	c.Options = GeneratorOptions();
+	c.Options.NumTriangles = numTriangles;
+	c.Options.NumMeshes = 256;
+	c.Options.NumSubsets = 8;
+	c.Options.Declaration = GD_POSITION;
+	cases.push_back(c);
+}
+
+static int generate(int argc, char** argv, const char *output)
+{
+	GeneratorOptions options;
+
+	std::string value = getCmdOption(argc, argv, "-triangles");
+	if (!value.empty())
+		options.NumTriangles = strtoull(value.c_str(), NULL, 10);
+
+	value = getCmdOption(argc, argv, "-meshes");
+	if (!value.empty())
+		options.NumMeshes = (UINT)atoi(value.c_str());
+
+	value = getCmdOption(argc, argv, "-subsets");
+	if (!value.empty())
+		options.NumSubsets = (UINT)atoi(value.c_str());
+
+	value = getCmdOption(argc, argv, "-seed");
+	if (!value.empty())
+		options.Seed = (UINT)atoi(value.c_str());
+
+	options.Index32 = hasCmdOption(argc, argv, "-index32");
+
+	value = getCmdOption(argc, argv, "-decl");
+	if (!value.empty() && !MeshGenerator::ParseDeclaration(value.c_str(), &options.Declaration))
+	{
+		std::cout << "Error: -decl position|full|compact\n";
+		return 1;
+	}
+
+	value = getCmdOption(argc, argv, "-locality");
+	if (!value.empty() && !MeshGenerator::ParseLocality(value.c_str(), &options.Locality))
+	{
+		std::cout << "Error: -locality ordered|shuffled|scattered\n";
+		return 1;
+	}
+
+	MeshGenerator generator(options);
+	if (!generator.Write(output))
+	{
+		std::cout << "Can not write: " << output << "\n";
+		return 1;
+	}
+
+	std::cout << "Generated: " << output << "\n";
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	std::string generateOutput = getCmdOption(argc, argv, "-generate");
+	if (!generateOutput.empty())
+		return generate(argc, argv, generateOutput.c_str());
+
+	std::string folder = getCmdOption(argc, argv, "-o");
+	if (folder.empty())
+		folder = "benchmark";
+
+	std::string value = getCmdOption(argc, argv, "-triangles");
+	UINT64 numTriangles = value.empty() ? 1000000 : strtoull(value.c_str(), NULL, 10);
+
+	value = getCmdOption(argc, argv, "-repeat");
+	int repeat = value.empty() ? 3 : atoi(value.c_str());
+	if (repeat < 1)
+		repeat = 1;
+
+	value = getCmdOption(argc, argv, "-tolerance");
+	double tolerance = value.empty() ? 0.1 : atof(value.c_str());
+
+	std::string only = getCmdOption(argc, argv, "-case");
+	std::string json = getCmdOption(argc, argv, "-json");
+	std::string baseline = getCmdOption(argc, argv, "-baseline");
+
+	std::map<std::string, double> baselineValues;
+	if (!baseline.empty() && !readJSON(baseline.c_str(), baselineValues))
+	{
+		std::cout << "Can not read baseline: " << baseline << "\n";
+		return 1;
+	}
+
+	std::vector<BenchmarkCase> cases;
+	getCases(numTriangles, cases);
+
+	FILE *jsonFile = NULL;
+	if (!json.empty())
+	{
+		MappedFile::CreateFolders(json.c_str());
+		jsonFile = fopen(json.c_str(), "wt");
+		if (jsonFile == NULL)
+		{
+			std::cout << "Can not write: " << json << "\n";
+			return 1;
+		}
+	}
+
+	JSONWriter writer(jsonFile);
+	if (jsonFile != NULL)
+	{
+		writer.BeginObject();
+		writer.Write("version", BENCHMARK_VERSION);
+		writer.Write("triangles", (unsigned long long)numTriangles);
+		writer.Write("repeat", repeat);
+		writer.BeginObject("cases");
+	}
+
+	int numRegressions = 0;
+
+	for (size_t i = 0; i < cases.size(); i++)
+	{
+		const BenchmarkCase& c = cases[i];
+		if (!only.empty() && only != c.Name)
+			continue;
+
+		std::string input = folder + "/" + c.Name + ".sdkmesh";
+		std::string output = folder + "/" + c.Name + ".obj";
+		MappedFile::CreateFolders(input.c_str());
+
+		SDKMeshWriter meshWriter;
+		MeshGenerator generator(c.Options);
+		generator.Build(meshWriter);
+
+		UINT64 triangles = 0;
+		SDKMesh check;
+		if (!meshWriter.Write(input.c_str()) || check.Create(input.c_str()) != S_OK)
+		{
+			std::cout << "Can not write: " << input << "\n";
+			return 1;
+		}
+
+		for (UINT j = 0; j < check.GetNumMeshes(); j++)
+			triangles += check.GetNumIndices(j) / 3;
+
+		std::cout << "\n# " << c.Name << ": " << triangles << " triangles, " << meshWriter.GetNumMeshes() << " meshes, " << meshWriter.GetNumSubsets() << " subsets, "
+			<< MeshGenerator::GetDeclarationName(c.Options.Declaration) << ", " << MeshGenerator::GetLocalityName(c.Options.Locality) << ", "
+			<< (c.Options.Index32 ? "32" : "16") << " bit\n";
+
+		std::vector<PhaseResult> phases;
+		UINT64 allocations = 0;
+		for (int r = 0; r < repeat; r++)
+		{
+			if (!runPhases(input.c_str(), output.c_str(), phases, allocations))
+			{
+				std::cout << "Error: " << c.Name << " failed!\n";
+				return 1;
+			}
+		}
+
+		if (jsonFile != NULL)
+			writer.BeginObject(c.Name);
+
+		for (size_t j = 0; j < phases.size(); j++)
+		{
+			const PhaseResult& phase = phases[j];
+			double seconds = phase.Seconds > 0.0 ? phase.Seconds : 1e-9;
+			double mbPerSecond = phase.Bytes / seconds / (1024.0 * 1024.0);
+			double trianglesPerSecond = triangles / seconds;
+
+			char line[256];
+			sprintf(line, " %-7s %9.4f s %10.1f MB/s %10.2f M triangles/s", phase.Name, phase.Seconds, mbPerSecond, trianglesPerSecond / 1e6);
+			std::cout << line;
+
+			std::string key = std::string("cases.") + c.Name + "." + phase.Name + ".triangles_per_s";
+			std::map<std::string, double>::iterator it = baselineValues.find(key);
+			if (it != baselineValues.end() && it->second > 0.0)
+			{
+				double change = trianglesPerSecond / it->second - 1.0;
+				sprintf(line, " %+6.1f%%", change * 100.0);
+				std::cout << line;
+
+				if (change < -tolerance)
+				{
+					std::cout << " REGRESSION";
+					numRegressions++;
+				}
+			}
+			std::cout << "\n";
+
+			if (jsonFile != NULL)
+			{
+				writer.BeginObject(phase.Name);
+				writer.Write("seconds", phase.Seconds);
+				writer.Write("mb_per_s", mbPerSecond);
+				writer.Write("triangles_per_s", trianglesPerSecond);
+				writer.EndObject();
+			}
+		}
+
+		std::cout << " allocations " << allocations << "\n";
+
+		if (jsonFile != NULL)
+		{
+			writer.Write("triangles", (unsigned long long)triangles);
+			writer.Write("allocations", (unsigned long long)allocations);
+			writer.EndObject();
+		}
+	}
+
+	if (jsonFile != NULL)
+	{
+		writer.EndObject();
+		writer.EndObject();
+		writer.Finish();
+		fclose(jsonFile);
+	}
+
+	if (!baseline.empty())
+	{
+		if (numRegressions > 0)
+			std::cout << "\n" << numRegressions << " phases are slower than the baseline (tolerance " << tolerance * 100.0 << "%)!\n";
+		else
+			std::cout << "\nNo regression against the baseline.\n";
+	}
+
+	return numRegressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,53 @@
+#include "Arena.h"
+
+#include <stdlib.h>
+#include <new>
+
+// The benchmark counts every operator new of its threads (the allocations of each case):
+// the replacements live in the executable, libsdkmesh only counts its own arena & scratch calls.
+
+void* operator new(size_t size)
+{
+	Arena::CountHeapCall();
+
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	Arena::CountHeapCall();
+	return malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+	free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) throw()
+{
+	free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) throw()
+{
+	free(p);
+}
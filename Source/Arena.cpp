@@ -0,0 +1,100 @@
+#include "Arena.h"
+
+#include <stdlib.h>
+#include <new>
+
+#define ARENA_ALIGNMENT 16
+
+static thread_local unsigned long long s_heapCalls = 0;
+
+Arena::Arena(size_t blockSize)
+	:m_block(0),
+	m_offset(0),
+	m_blockSize(blockSize)
+{
+}
+
+Arena::~Arena()
+{
+	for (size_t i = 0; i < m_blocks.size(); i++)
+		free(m_blocks[i].Data);
+}
+
+void* Arena::Allocate(size_t size)
+{
+	size = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+
+	// the next block that fits, a new one after the current block if none does
+	while (m_block < m_blocks.size() && m_offset + size > m_blocks[m_block].Size)
+	{
+		m_block++;
+		m_offset = 0;
+	}
+
+	if (m_block == m_blocks.size())
+	{
+		Block block;
+		block.Size = size > m_blockSize ? size : m_blockSize;
+		block.Data = (char*)malloc(block.Size);
+		if (block.Data == NULL)
+			throw std::bad_alloc();
+
+		CountHeapCall();
+
+		m_blocks.push_back(block);
+	}
+
+	void *p = m_blocks[m_block].Data + m_offset;
+	m_offset += size;
+	return p;
+}
+
+Arena::Mark Arena::GetMark()
+{
+	Mark mark;
+	mark.Block = m_block;
+	mark.Offset = m_offset;
+	return mark;
+}
+
+void Arena::Rewind(const Mark& mark)
+{
+	m_block = mark.Block;
+	m_offset = mark.Offset;
+}
+
+void Arena::Reset()
+{
+	m_block = 0;
+	m_offset = 0;
+}
+
+static thread_local Arena *s_current = NULL;
+
+Arena* Arena::GetCurrent()
+{
+	return s_current;
+}
+
+Arena* Arena::SetCurrent(Arena *arena)
+{
+	Arena *previous = s_current;
+	s_current = arena;
+	return previous;
+}
+
+Arena& Arena::GetThreadArena()
+{
+	static thread_local Arena arena;
+	return arena;
+}
+
+void Arena::CountHeapCall()
+{
+	s_heapCalls++;
+}
+
+unsigned long long Arena::GetNumHeapCalls()
+{
+	return s_heapCalls;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <new>
+#include <vector>
+
+// Monotonic allocator of a conversion session: allocations are pointer bumps in large blocks
+// and nothing is freed one by one. Reset rewinds the blocks but keeps them, so once the first
+// files have grown the arena, the next conversions of the thread make no heap calls for it.
+class Arena
+{
+public:
+	struct Mark
+	{
+		size_t Block;
+		size_t Offset;
+	};
+
+protected:
+	struct Block
+	{
+		char *Data;
+		size_t Size;
+	};
+
+	std::vector<Block> m_blocks;
+	size_t m_block;
+	size_t m_offset;
+	size_t m_blockSize;
+
+public:
+	Arena(size_t blockSize = 1024 * 1024);
+
+	virtual ~Arena();
+
+	// never NULL, aligned to 16 bytes, not initialized
+	void* Allocate(size_t size);
+
+	template<class T>
+	T* Allocate(size_t count)
+	{
+		return (T*)Allocate(sizeof(T) * count);
+	}
+
+	Mark GetMark();
+
+	// free everything allocated after the mark
+	void Rewind(const Mark& mark);
+
+	void Reset();
+
+	size_t GetNumBlocks()
+	{
+		return m_blocks.size();
+	}
+
+	// arena of the session running on this thread, NULL outside a session
+	static Arena* GetCurrent();
+
+	// returns the previous one
+	static Arena* SetCurrent(Arena *arena);
+
+	// arena kept by this thread for its sessions
+	static Arena& GetThreadArena();
+
+	// a heap call of this thread: the arena blocks and the scratch arrays outside a session count
+	// theirs, an executable that replaces operator new can count every other one (SDKMeshBenchmark)
+	static void CountHeapCall();
+
+	// heap calls counted on this thread so far
+	static unsigned long long GetNumHeapCalls();
+};
+
+// A session on this thread (one conversion): the arena is the current one until the scope ends
+// and is reset then. Sessions nest, the inner one uses the same arena from its mark.
+class ArenaScope
+{
+protected:
+	Arena *m_arena;
+	Arena *m_previous;
+	Arena::Mark m_mark;
+
+public:
+	ArenaScope(Arena& arena)
+		:m_arena(&arena),
+		m_previous(Arena::SetCurrent(&arena))
+	{
+		m_mark = arena.GetMark();
+	}
+
+	~ArenaScope()
+	{
+		m_arena->Rewind(m_mark);
+		Arena::SetCurrent(m_previous);
+	}
+};
+
+// Scratch array of plain data from the session arena, or from the heap outside a session
+template<class T>
+class ArenaArray
+{
+protected:
+	T *m_data;
+	size_t m_size;
+	bool m_owned;
+
+public:
+	ArenaArray()
+		:m_data(NULL),
+		m_size(0),
+		m_owned(false)
+	{
+	}
+
+	~ArenaArray()
+	{
+		Free();
+	}
+
+	// the content is not kept
+	void Resize(size_t size)
+	{
+		if (size == m_size)
+			return;
+
+		Free();
+		if (size == 0)
+			return;
+
+		Arena *arena = Arena::GetCurrent();
+		if (arena != NULL)
+		{
+			m_data = arena->Allocate<T>(size);
+		}
+		else
+		{
+			m_data = (T*)malloc(sizeof(T) * size);
+			if (m_data == NULL)
+				throw std::bad_alloc();
+
+			Arena::CountHeapCall();
+			m_owned = true;
+		}
+		m_size = size;
+	}
+
+	void Free()
+	{
+		if (m_owned)
+			free(m_data);
+
+		m_data = NULL;
+		m_size = 0;
+		m_owned = false;
+	}
+
+	T* Data()
+	{
+		return m_data;
+	}
+
+	size_t Size()
+	{
+		return m_size;
+	}
+
+	T& operator[](size_t i)
+	{
+		return m_data[i];
+	}
+
+private:
+	ArenaArray(const ArenaArray&);
+	ArenaArray& operator=(const ArenaArray&);
+};
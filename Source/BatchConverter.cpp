@@ -0,0 +1,406 @@
+#include "BatchConverter.h"
+#include "TaskPool.h"
+#include "ParallelFor.h"
+#include "MappedFile.h"
+#include "CStringImp.h"
+#include "Log.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+BatchConverter::BatchConverter()
+	:m_numThreads(0),
+	m_seconds(0.0),
+	m_steals(0)
+{
+}
+
+BatchConverter::~BatchConverter()
+{
+}
+
+bool BatchConverter::MatchWildcard(const char *pattern, const char *name)
+{
+	// '*' any run, '?' one char, case insensitive; backtrack to the last '*'
+	const char *star = NULL;
+	const char *resume = NULL;
+
+	while (*name)
+	{
+		if (*pattern == '*')
+		{
+			star = pattern++;
+			resume = name;
+		}
+		else if (*pattern == '?' || tolower((unsigned char)*pattern) == tolower((unsigned char)*name))
+		{
+			pattern++;
+			name++;
+		}
+		else if (star != NULL)
+		{
+			pattern = star + 1;
+			name = ++resume;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	while (*pattern == '*')
+		pattern++;
+
+	return *pattern == 0;
+}
+
+static std::string RemoveExt(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return path;
+	return path.substr(0, dot);
+}
+
+void BatchConverter::AddFile(const std::string& path, const std::string& relative)
+{
+	BatchItem item;
+	item.Input = path;
+	item.Relative = relative;
+	item.Size = 0;
+	item.Success = false;
+	item.Cached = false;
+	item.Triangles = 0;
+	item.Seconds = 0.0;
+
+	struct stat st;
+	if (stat(path.c_str(), &st) == 0)
+		item.Size = (UINT64)st.st_size;
+
+	m_items.push_back(item);
+}
+
+void BatchConverter::AddDirectory(const std::string& dir, const std::string& relative, const char *pattern, bool recursive)
+{
+	std::vector<std::string> files;
+	std::vector<std::string> folders;
+
+#if defined(_WIN32)
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((dir + "\\*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		std::string name = data.cFileName;
+		if (name == "." || name == "..")
+			continue;
+
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			folders.push_back(name);
+		else if (MatchWildcard(pattern, name.c_str()))
+			files.push_back(name);
+	} while (FindNextFileA(find, &data));
+
+	FindClose(find);
+#else
+	DIR *d = opendir(dir.c_str());
+	if (d == NULL)
+		return;
+
+	struct dirent *entry;
+	while ((entry = readdir(d)) != NULL)
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+			continue;
+
+		if (MappedFile::IsDirectory((dir + "/" + name).c_str()))
+			folders.push_back(name);
+		else if (MatchWildcard(pattern, name.c_str()))
+			files.push_back(name);
+	}
+
+	closedir(d);
+#endif
+
+	// stable order whatever the file system returns
+	std::sort(files.begin(), files.end());
+	std::sort(folders.begin(), folders.end());
+
+	std::string prefix = relative.empty() ? "" : relative + "/";
+
+	for (size_t i = 0; i < files.size(); i++)
+		AddFile(dir + "/" + files[i], prefix + RemoveExt(files[i]));
+
+	if (recursive)
+	{
+		for (size_t i = 0; i < folders.size(); i++)
+			AddDirectory(dir + "/" + folders[i], prefix + folders[i], pattern, true);
+	}
+}
+
+bool BatchConverter::AddInputs(const char *source)
+{
+	size_t count = m_items.size();
+	std::string path = source;
+
+	if (path.find_first_of("*?") != std::string::npos)
+	{
+		// glob on the file names of one folder
+		size_t slash = path.find_last_of("/\\");
+		std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+		std::string pattern = slash == std::string::npos ? path : path.substr(slash + 1);
+
+		AddDirectory(dir, "", pattern.c_str(), false);
+	}
+	else if (MappedFile::IsDirectory(source))
+	{
+		AddDirectory(path, "", "*.sdkmesh", true);
+	}
+	else if (MatchWildcard("*.sdkmesh", source))
+	{
+		char name[MAX_PATH];
+		Skylicht::CStringImp::getFileNameNoExt(name, source);
+		AddFile(path, name);
+	}
+	else
+	{
+		// list file: one input per line, # comments
+		FILE *file = fopen(source, "rt");
+		if (file == NULL)
+			return false;
+
+		char line[MAX_PATH * 2];
+		while (fgets(line, sizeof(line), file) != NULL)
+		{
+			Skylicht::CStringImp::trim(line);
+			if (line[0] == 0 || line[0] == '#')
+				continue;
+
+			std::string input = line;
+			std::string relative = RemoveExt(input);
+			if (relative.compare(0, 2, "./") == 0)
+				relative = relative.substr(2);
+
+			// outside of the current folder: keep the name only
+			if (relative.empty() || relative[0] == '/' || relative[0] == '\\' || relative.find(':') != std::string::npos || relative.find("..") != std::string::npos)
+			{
+				char name[MAX_PATH];
+				Skylicht::CStringImp::getFileNameNoExt(name, line);
+				relative = name;
+			}
+
+			AddFile(input, relative);
+		}
+
+		fclose(file);
+	}
+
+	return m_items.size() > count;
+}
+
+static void ReplaceAll(std::string& s, const char *search, const std::string& replace)
+{
+	size_t len = strlen(search);
+	size_t pos = 0;
+	while ((pos = s.find(search, pos)) != std::string::npos)
+	{
+		s.replace(pos, len, replace);
+		pos += replace.size();
+	}
+}
+
+bool BatchConverter::SetOutputTemplate(const char *outputTemplate)
+{
+	std::string t = outputTemplate;
+	if (t.find("{name}") == std::string::npos && t.find("{path}") == std::string::npos)
+		return false;
+
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		BatchItem& item = m_items[i];
+
+		size_t slash = item.Relative.find_last_of("/\\");
+		std::string name = slash == std::string::npos ? item.Relative : item.Relative.substr(slash + 1);
+
+		item.Output = t;
+		ReplaceAll(item.Output, "{name}", name);
+		ReplaceAll(item.Output, "{path}", item.Relative);
+	}
+
+	return true;
+}
+
+UINT BatchConverter::Run(const ConvertFunc& convert, int numThreads)
+{
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+	m_numThreads = numThreads;
+
+	// largest first: the long files start early and the small ones fill the gaps at the end
+	std::vector<size_t> order(m_items.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		return m_items[a].Size > m_items[b].Size;
+	});
+
+	// two inputs must not write the same file
+	std::set<std::string> outputs;
+	std::vector<BYTE> skip(m_items.size(), 0);
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		if (!outputs.insert(m_items[i].Output).second)
+		{
+			LogError() << "Error: " << m_items[i].Input << " writes the same output " << m_items[i].Output << "\n";
+			skip[i] = 1;
+		}
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	{
+		TaskPool pool(numThreads);
+		TaskGroup group;
+
+		for (size_t k = 0; k < order.size(); k++)
+		{
+			BatchItem& item = m_items[order[k]];
+			if (skip[order[k]])
+				continue;
+
+			pool.Run(group, [&item, &convert]()
+			{
+				std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+				item.Success = MappedFile::CreateFolders(item.Output.c_str()) && convert(item);
+
+				item.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+			});
+		}
+
+		pool.Wait(group);
+		m_steals = pool.GetNumSteals();
+	}
+
+	m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	UINT numFailed = 0;
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		if (!m_items[i].Success)
+			numFailed++;
+	}
+	return numFailed;
+}
+
+void BatchConverter::PrintStats()
+{
+	UINT64 bytes = 0;
+	UINT64 triangles = 0;
+	UINT numFailed = 0;
+	UINT numCached = 0;
+	size_t slowest = 0;
+
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		const BatchItem& item = m_items[i];
+		if (!item.Success)
+		{
+			numFailed++;
+			LogError() << "Failed: " << item.Input << "\n";
+			continue;
+		}
+
+		if (item.Cached)
+			numCached++;
+
+		bytes += item.Size;
+		triangles += item.Triangles;
+
+		if (item.Seconds > m_items[slowest].Seconds)
+			slowest = i;
+	}
+
+	double seconds = m_seconds > 0.0 ? m_seconds : 1e-9;
+	double mb = (double)bytes / (1024.0 * 1024.0);
+
+	LogInfo() << "\n# Batch:\n";
+	LogInfo() << " Files: " << m_items.size() - numFailed << " converted (" << numCached << " from cache), " << numFailed << " failed\n";
+	LogInfo() << " Threads: " << m_numThreads << ", steals: " << m_steals << "\n";
+	LogInfo() << " Time: " << m_seconds << " s\n";
+	LogInfo() << " Throughput: " << (m_items.size() - numFailed) / seconds << " files/s, "
+		<< mb / seconds << " MB/s, " << (double)triangles / seconds << " triangles/s\n";
+	LogInfo() << " Input: " << mb << " MB, " << triangles << " triangles\n";
+
+	if (!m_items.empty() && m_items[slowest].Success)
+		LogInfo() << " Slowest: " << m_items[slowest].Input << " (" << m_items[slowest].Seconds << " s)\n";
+}
+
+bool BatchConverter::WriteStats(const char *path)
+{
+	remove(path);
+	FILE *file = fopen(path, "wt");
+	if (file == NULL)
+		return false;
+
+	std::vector<ConvertStats*> runs;
+	UINT numFailed = 0;
+	UINT numCached = 0;
+
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		BatchItem& item = m_items[i];
+		if (!item.Success)
+			numFailed++;
+		else if (item.Cached)
+			numCached++;
+		else
+			runs.push_back(&item.Stats);
+	}
+
+	JSONWriter json(file);
+	json.BeginObject();
+	json.Write("seconds", m_seconds);
+	json.Write("threads", m_numThreads);
+	json.Write("failed", numFailed);
+	json.Write("cached", numCached);
+	ConvertStats::WritePercentiles(json, runs);
+
+	json.BeginArray("items");
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		BatchItem& item = m_items[i];
+		if (!item.Success || item.Cached)
+			continue;
+
+		json.BeginObject();
+		json.Write("input", item.Input.c_str());
+		item.Stats.WriteJSON(json);
+		json.EndObject();
+	}
+	json.EndArray();
+
+	json.EndObject();
+	json.Finish();
+
+	bool success = ferror(file) == 0;
+	return fclose(file) == 0 && success;
+}
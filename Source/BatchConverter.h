@@ -0,0 +1,82 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "ConvertStats.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+struct BatchItem
+{
+	std::string Input;
+
+	// path relative to the scanned directory or list file, without extension
+	std::string Relative;
+
+	std::string Output;
+	UINT64 Size;
+
+	bool Success;
+	bool Cached;
+	UINT64 Triangles;
+	double Seconds;
+
+	// phases of the conversion, filled when the batch reports stats
+	ConvertStats Stats;
+};
+
+// Converts many files on one work-stealing pool: a task per file, the largest files first.
+// The subset stages inside a conversion (ParallelFor) become nested tasks of the same pool,
+// so idle workers help on a giant mesh while the small files keep flowing.
+class BatchConverter
+{
+public:
+	// converts item.Input to item.Output, returns false on error; sets Triangles and Cached
+	typedef std::function<bool(BatchItem& item)> ConvertFunc;
+
+protected:
+	std::vector<BatchItem> m_items;
+
+	int m_numThreads;
+	double m_seconds;
+	unsigned long long m_steals;
+
+public:
+	BatchConverter();
+
+	virtual ~BatchConverter();
+
+	// a directory (*.sdkmesh, recursive), a glob (DIR/*.sdkmesh), a .sdkmesh file
+	// or a text file listing one input per line
+	bool AddInputs(const char *source);
+
+	// {name}: input file name without extension, {path}: with its sub folder
+	// e.g. out/{path}.obj, the folders are created
+	bool SetOutputTemplate(const char *outputTemplate);
+
+	UINT GetNumItems()
+	{
+		return (UINT)m_items.size();
+	}
+
+	BatchItem& GetItem(UINT i)
+	{
+		return m_items[i];
+	}
+
+	// returns the number of failed files
+	UINT Run(const ConvertFunc& convert, int numThreads);
+
+	void PrintStats();
+
+	// percentiles of the phase times over the converted (not cached) files, then each file
+	bool WriteStats(const char *path);
+
+	static bool MatchWildcard(const char *pattern, const char *name);
+
+protected:
+	void AddFile(const std::string& path, const std::string& relative);
+
+	void AddDirectory(const std::string& dir, const std::string& relative, const char *pattern, bool recursive);
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "OutputSink.h"
+#include "ConvertStats.h"
+#include "Arena.h"
+
+// Buffered output, flushed to the file or sink in fixed-size chunks.
+// The chunk comes from the session arena during a conversion.
+class ChunkWriter
+{
+protected:
+	FileSink m_fileSink;
+	OutputSink *m_sink;
+
+	ArenaArray<char> m_chunk;
+	char *m_buffer;
+	size_t m_size;
+	size_t m_capacity;
+
+	bool m_error;
+
+	// flush time & written bytes, optional
+	ConvertStats *m_stats;
+
+public:
+	ChunkWriter(FILE *file, size_t chunkSize = 64 * 1024)
+		:m_fileSink(file),
+		m_size(0),
+		m_capacity(chunkSize),
+		m_error(false),
+		m_stats(NULL)
+	{
+		m_sink = &m_fileSink;
+		m_chunk.Resize(chunkSize);
+		m_buffer = m_chunk.Data();
+	}
+
+	ChunkWriter(OutputSink *sink, size_t chunkSize = 64 * 1024)
+		:m_sink(sink),
+		m_size(0),
+		m_capacity(chunkSize),
+		m_error(false),
+		m_stats(NULL)
+	{
+		m_chunk.Resize(chunkSize);
+		m_buffer = m_chunk.Data();
+	}
+
+	~ChunkWriter()
+	{
+		Flush();
+	}
+
+	inline void Write(const void *data, size_t size)
+	{
+		if (m_size + size > m_capacity)
+		{
+			Flush();
+
+			if (size > m_capacity)
+			{
+				WriteSink(data, size);
+				return;
+			}
+		}
+
+		memcpy(m_buffer + m_size, data, size);
+		m_size += size;
+	}
+
+	// formatted text, straight into the chunk
+	void Print(const char *format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		int n = vsnprintf(m_buffer + m_size, m_capacity - m_size, format, args);
+		va_end(args);
+
+		if (n < 0)
+		{
+			m_error = true;
+			return;
+		}
+
+		if ((size_t)n < m_capacity - m_size)
+		{
+			m_size += (size_t)n;
+			return;
+		}
+
+		// did not fit: flush and format again
+		Flush();
+
+		if ((size_t)n < m_capacity)
+		{
+			va_start(args, format);
+			vsnprintf(m_buffer, m_capacity, format, args);
+			va_end(args);
+			m_size = (size_t)n;
+			return;
+		}
+
+		char *text = new char[n + 1];
+		va_start(args, format);
+		vsnprintf(text, (size_t)n + 1, format, args);
+		va_end(args);
+		Write(text, (size_t)n);
+		delete[] text;
+	}
+
+	void Flush()
+	{
+		if (m_size > 0 && m_sink != NULL)
+			WriteSink(m_buffer, m_size);
+		m_size = 0;
+	}
+
+	// flushes to the previous sink first
+	void SetSink(OutputSink *sink)
+	{
+		Flush();
+		m_sink = sink;
+	}
+
+	void SetStats(ConvertStats *stats)
+	{
+		m_stats = stats;
+	}
+
+	bool HasError()
+	{
+		return m_error;
+	}
+
+protected:
+	void WriteSink(const void *data, size_t size)
+	{
+		StatsScope scope(m_stats, SP_FLUSH);
+		if (m_stats != NULL)
+			m_stats->Add(SC_BYTES_WRITTEN, size);
+
+		if (!m_sink->Write(data, size))
+			m_error = true;
+	}
+};
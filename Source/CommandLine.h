@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+// Command line options of the front ends (SDKMeshObjExporter, SDKMeshBenchmark):
+// "-option VALUE" or "-option=VALUE", an option matches the whole argument
+// so "-o" does not take "-optimize"
+
+inline std::string getCmdOption(int argc, char* argv[], const std::string& option)
+{
+	std::string cmd;
+	for (int i = 0; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == option)
+		{
+			if (i + 1 < argc)
+				cmd = argv[i + 1];
+			return cmd;
+		}
+
+		// -option=VALUE
+		if (arg.size() > option.size() && arg.compare(0, option.size(), option) == 0 && arg[option.size()] == '=')
+			return arg.substr(option.size() + 1);
+	}
+	return cmd;
+}
+
+inline bool hasCmdOption(int argc, char* argv[], const std::string& option)
+{
+	for (int i = 0; i < argc; ++i)
+	{
+		if (option == argv[i])
+			return true;
+	}
+	return false;
+}
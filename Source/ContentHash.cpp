@@ -0,0 +1,147 @@
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+
+#include <cstring>
+
+// bytes per chunk of a file hash
+#define CONTENTHASH_CHUNK (4 * 1024 * 1024)
+
+static const UINT64 PRIME1 = 0x9E3779B185EBCA87ULL;
+static const UINT64 PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const UINT64 PRIME3 = 0x165667B19E3779F9ULL;
+static const UINT64 PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const UINT64 PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline UINT64 Rotl(UINT64 x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline UINT64 Read64(const BYTE *p)
+{
+	UINT64 v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline UINT Read32(const BYTE *p)
+{
+	UINT v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static inline UINT64 Round(UINT64 acc, UINT64 input)
+{
+	acc += input * PRIME2;
+	acc = Rotl(acc, 31);
+	return acc * PRIME1;
+}
+
+static inline UINT64 MergeRound(UINT64 acc, UINT64 val)
+{
+	acc ^= Round(0, val);
+	return acc * PRIME1 + PRIME4;
+}
+
+UINT64 ContentHash::Hash(const void *data, size_t size, UINT64 seed)
+{
+	const BYTE *p = (const BYTE*)data;
+	const BYTE *end = p + size;
+	UINT64 h;
+
+	if (size >= 32)
+	{
+		// 4 independent lanes of 8 bytes
+		UINT64 v1 = seed + PRIME1 + PRIME2;
+		UINT64 v2 = seed + PRIME2;
+		UINT64 v3 = seed;
+		UINT64 v4 = seed - PRIME1;
+
+		const BYTE *limit = end - 32;
+		do
+		{
+			v1 = Round(v1, Read64(p));
+			v2 = Round(v2, Read64(p + 8));
+			v3 = Round(v3, Read64(p + 16));
+			v4 = Round(v4, Read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+		h = MergeRound(h, v1);
+		h = MergeRound(h, v2);
+		h = MergeRound(h, v3);
+		h = MergeRound(h, v4);
+	}
+	else
+	{
+		h = seed + PRIME5;
+	}
+
+	h += (UINT64)size;
+
+	// tail
+	for (; p + 8 <= end; p += 8)
+	{
+		h ^= Round(0, Read64(p));
+		h = Rotl(h, 27) * PRIME1 + PRIME4;
+	}
+
+	if (p + 4 <= end)
+	{
+		h ^= (UINT64)Read32(p) * PRIME1;
+		h = Rotl(h, 23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+
+	for (; p < end; p++)
+	{
+		h ^= (*p) * PRIME5;
+		h = Rotl(h, 11) * PRIME1;
+	}
+
+	// avalanche
+	h ^= h >> 33;
+	h *= PRIME2;
+	h ^= h >> 29;
+	h *= PRIME3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+bool ContentHash::HashFile(const char *path, int numThreads, UINT64 *hash)
+{
+	MappedFile file;
+	if (!file.Open(path))
+		return false;
+
+	const BYTE *data = file.GetData();
+	size_t size = file.GetSize();
+
+	size_t numChunks = (size + CONTENTHASH_CHUNK - 1) / CONTENTHASH_CHUNK;
+	std::vector<UINT64> chunks(numChunks);
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	ParallelFor(numChunks, numThreads, [&](size_t i, int)
+	{
+		size_t begin = i * CONTENTHASH_CHUNK;
+		size_t count = size - begin < CONTENTHASH_CHUNK ? size - begin : CONTENTHASH_CHUNK;
+		chunks[i] = Hash(data + begin, count, i);
+	});
+
+	*hash = Hash(chunks.data(), chunks.size() * sizeof(UINT64), (UINT64)size);
+	return true;
+}
+
+void ContentHash::ToString(UINT64 hash, char *out)
+{
+	const char *digits = "0123456789abcdef";
+	for (int i = 0; i < 16; i++)
+		out[i] = digits[(hash >> ((15 - i) * 4)) & 15];
+	out[16] = 0;
+}
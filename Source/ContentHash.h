@@ -0,0 +1,18 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+// 64-bit content hash (XXH64) of memory and files.
+// Files are mapped and hashed in fixed-size chunks in parallel, the chunk hashes are then hashed
+// together: the result is stable for a given file whatever the number of threads.
+class ContentHash
+{
+public:
+	static UINT64 Hash(const void *data, size_t size, UINT64 seed = 0);
+
+	// false if the file can not be mapped
+	static bool HashFile(const char *path, int numThreads, UINT64 *hash);
+
+	// 16 hex digits
+	static void ToString(UINT64 hash, char *out);
+};
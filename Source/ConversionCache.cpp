@@ -0,0 +1,222 @@
+#include "ConversionCache.h"
+#include "ContentHash.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <direct.h>
+#else
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+#endif
+
+ConversionCache::ConversionCache(const char *folder)
+	:m_folder(folder)
+{
+}
+
+ConversionCache::~ConversionCache()
+{
+}
+
+std::string ConversionCache::GetEntryFolder(UINT64 key)
+{
+	char name[32];
+	ContentHash::ToString(key, name);
+	return m_folder + "/" + name;
+}
+
+static std::string GetFileName(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool ConversionCache::GetKey(const char *source, const std::string& options, int numThreads, UINT64 *key)
+{
+	UINT64 content;
+	if (!ContentHash::HashFile(source, numThreads, &content))
+		return false;
+
+	char version[32];
+	sprintf(version, "%d|", CONVERSIONCACHE_VERSION);
+
+	std::string text = version + options;
+	*key = ContentHash::Hash(text.c_str(), text.size(), content);
+	return true;
+}
+
+bool ConversionCache::Restore(UINT64 key, const char *output, UINT64 *numTriangles)
+{
+	std::string entry = GetEntryFolder(key);
+
+	FILE *file = fopen((entry + "/files.txt").c_str(), "rt");
+	if (file == NULL)
+		return false;
+
+	std::string path = output;
+	size_t slash = path.find_last_of("/\\");
+	std::string folder = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+
+	bool success = true;
+	char line[MAX_PATH];
+	unsigned long long triangles = 0;
+
+	while (success && fgets(line, sizeof(line), file) != NULL)
+	{
+		line[strcspn(line, "\r\n")] = 0;
+
+		if (strncmp(line, "triangles ", 10) == 0)
+		{
+			triangles = strtoull(line + 10, NULL, 10);
+		}
+		else if (strncmp(line, "file ", 5) == 0)
+		{
+			// replace, an old output must not be written through
+			std::string target = folder + (line + 5);
+			remove(target.c_str());
+			success = LinkFile((entry + "/" + (line + 5)).c_str(), target.c_str());
+		}
+	}
+
+	fclose(file);
+
+	if (numTriangles != NULL)
+		*numTriangles = triangles;
+
+	return success;
+}
+
+bool ConversionCache::Store(UINT64 key, const std::vector<std::string>& files, UINT64 numTriangles)
+{
+	std::string entry = GetEntryFolder(key);
+	if (MappedFile::GetFileInfo((entry + "/files.txt").c_str(), NULL, NULL))
+		return true;
+
+	// filled in a temporary folder and renamed: concurrent tasks or processes never see half an entry
+	static std::atomic<unsigned int> s_counter(0);
+	char suffix[64];
+	sprintf(suffix, ".tmp%x_%x_%x",
+		(unsigned int)std::hash<std::thread::id>()(std::this_thread::get_id()),
+		(unsigned int)std::chrono::steady_clock::now().time_since_epoch().count(),
+		s_counter++);
+
+	std::string temp = entry + suffix;
+	std::vector<std::string> names;
+
+	bool success = MappedFile::CreateFolders((temp + "/files.txt").c_str());
+
+	for (size_t i = 0; success && i < files.size(); i++)
+	{
+		names.push_back(GetFileName(files[i]));
+		success = LinkFile(files[i].c_str(), (temp + "/" + names.back()).c_str());
+	}
+
+	if (success)
+	{
+		FILE *file = fopen((temp + "/files.txt").c_str(), "wt");
+		if (file != NULL)
+		{
+			fprintf(file, "triangles %llu\n", (unsigned long long)numTriangles);
+			for (size_t i = 0; i < names.size(); i++)
+				fprintf(file, "file %s\n", names[i].c_str());
+
+			success = ferror(file) == 0;
+			fclose(file);
+		}
+		else
+		{
+			success = false;
+		}
+	}
+
+	if (success && rename(temp.c_str(), entry.c_str()) == 0)
+		return true;
+
+	// failed, or the same entry was stored meanwhile
+	names.push_back("files.txt");
+	RemoveFolder(temp, names);
+
+	return MappedFile::GetFileInfo((entry + "/files.txt").c_str(), NULL, NULL);
+}
+
+void ConversionCache::RemoveFolder(const std::string& folder, const std::vector<std::string>& files)
+{
+	for (size_t i = 0; i < files.size(); i++)
+		remove((folder + "/" + files[i]).c_str());
+
+#if defined(_WIN32)
+	_rmdir(folder.c_str());
+#else
+	rmdir(folder.c_str());
+#endif
+}
+
+bool ConversionCache::LinkFile(const char *source, const char *target)
+{
+#if defined(_WIN32)
+	if (CreateHardLinkA(target, source, NULL))
+		return true;
+#else
+	if (link(source, target) == 0)
+		return true;
+#endif
+
+	// an other volume, or links are not supported
+	return CopyFileData(source, target);
+}
+
+bool ConversionCache::CopyFileData(const char *source, const char *target)
+{
+	FILE *in = fopen(source, "rb");
+	if (in == NULL)
+		return false;
+
+	FILE *out = fopen(target, "wb");
+	if (out == NULL)
+	{
+		fclose(in);
+		return false;
+	}
+
+	bool success = true;
+
+#if defined(__linux__) && defined(FICLONE)
+	// copy-on-write clone (btrfs, xfs)
+	if (ioctl(fileno(out), FICLONE, fileno(in)) == 0)
+	{
+		fclose(in);
+		fclose(out);
+		return true;
+	}
+#endif
+
+	std::vector<char> buffer(1024 * 1024);
+	size_t n;
+	while ((n = fread(buffer.data(), 1, buffer.size(), in)) > 0)
+	{
+		if (fwrite(buffer.data(), 1, n, out) != n)
+		{
+			success = false;
+			break;
+		}
+	}
+
+	if (ferror(in))
+		success = false;
+
+	fclose(in);
+	if (fclose(out) != 0)
+		success = false;
+
+	return success;
+}
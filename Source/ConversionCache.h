@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+#include <string>
+#include <vector>
+
+// bump when the written files change for the same source and options
+#define CONVERSIONCACHE_VERSION 1
+
+// Incremental conversion cache: the output files of a conversion, stored under a key made of the
+// content hash of the source and of the export options. On a hit the previous outputs are linked
+// (or copied) back next to the output without parsing the source.
+// Layout: FOLDER/KEY/ with the files by name and files.txt, written last to mark a complete entry.
+class ConversionCache
+{
+protected:
+	std::string m_folder;
+
+public:
+	ConversionCache(const char *folder);
+
+	virtual ~ConversionCache();
+
+	// options: every setting that changes the written files (output path included)
+	bool GetKey(const char *source, const std::string& options, int numThreads, UINT64 *key);
+
+	// link the files of the entry in the folder of output, false on a miss
+	bool Restore(UINT64 key, const char *output, UINT64 *numTriangles);
+
+	// files: the written outputs, all in the same folder
+	bool Store(UINT64 key, const std::vector<std::string>& files, UINT64 numTriangles);
+
+	// hard link, else a copy (clone when the file system supports it)
+	static bool LinkFile(const char *source, const char *target);
+
+	static bool CopyFileData(const char *source, const char *target);
+
+protected:
+	std::string GetEntryFolder(UINT64 key);
+
+	static void RemoveFolder(const std::string& folder, const std::vector<std::string>& files);
+};
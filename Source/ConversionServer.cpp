@@ -0,0 +1,434 @@
+#include "ConversionServer.h"
+#include "TaskPool.h"
+#include "ParallelFor.h"
+
+#include <chrono>
+#include <deque>
+
+#if defined(_WIN32)
+#include <direct.h>
+#endif
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+// one client connection: the accept thread reads its lines, the pool answers them one at a time
+struct ServerConnection
+{
+	int Socket;
+	std::string Pending;
+
+	// complete lines waiting for the previous answer, an empty line: the line was too long
+	std::deque<std::string> Lines;
+
+	// the rest of a too long line is discarded up to its end
+	bool Skipping;
+
+	// the client stopped sending: the queued lines are answered, then the socket is closed
+	bool Closed;
+
+	// a worker answers a line of this connection / an answer could not be sent
+	std::atomic<bool> Busy;
+	std::atomic<bool> Failed;
+
+	ServerConnection(int socket)
+		:Socket(socket),
+		Skipping(false),
+		Closed(false),
+		Busy(false),
+		Failed(false)
+	{
+	}
+};
+
+ConversionServer::ConversionServer(const char *path)
+	:m_path(path),
+	m_socket(-1),
+	m_exit(false),
+	m_numRequests(0),
+	m_numFailed(0),
+	m_totalTime(0)
+{
+}
+
+ConversionServer::~ConversionServer()
+{
+#if !defined(_WIN32)
+	if (m_socket >= 0)
+	{
+		close(m_socket);
+		unlink(m_path.c_str());
+	}
+#endif
+}
+
+void ConversionServer::Split(const std::string& line, std::vector<std::string>& fields)
+{
+	fields.clear();
+
+	size_t begin = 0;
+	while (begin <= line.size())
+	{
+		size_t end = line.find('\t', begin);
+		if (end == std::string::npos)
+			end = line.size();
+
+		fields.push_back(line.substr(begin, end - begin));
+		begin = end + 1;
+	}
+}
+
+std::string ConversionServer::GetAbsolutePath(const char *path)
+{
+	std::string s = path;
+	if (s.empty() || s[0] == '/' || s[0] == '\\' || s.find(':') != std::string::npos)
+		return s;
+
+	char folder[MAX_PATH];
+#if defined(_WIN32)
+	if (_getcwd(folder, MAX_PATH) == NULL)
+		return s;
+#else
+	if (getcwd(folder, MAX_PATH) == NULL)
+		return s;
+#endif
+
+	return std::string(folder) + "/" + s;
+}
+
+std::string ConversionServer::Handle(const std::string& line, const ConvertFunc& convert)
+{
+	std::vector<std::string> fields;
+	Split(line, fields);
+
+	char answer[512];
+	const std::string& command = fields[0];
+
+	if (command == "ping")
+		return "ok";
+
+	if (command == "stats")
+	{
+		sprintf(answer, "ok\t%llu\t%llu\t%llu", m_numRequests.load(), m_numFailed.load(), m_totalTime.load());
+		return answer;
+	}
+
+	if (command == "shutdown")
+	{
+		m_exit = true;
+		return "ok";
+	}
+
+	if (command != "convert")
+		return "error\t0\tunknown command";
+
+	if (fields.size() < 3 || fields[1].empty() || fields[2].empty())
+		return "error\t0\tconvert needs an input and an output";
+
+	ServerRequest request;
+	request.Input = fields[1];
+	request.Output = fields[2];
+	request.Options.assign(fields.begin() + 3, fields.end());
+
+	ServerResponse response;
+	response.Success = false;
+	response.Cached = false;
+	response.Triangles = 0;
+
+	// the read buffer stays with the worker thread
+	static thread_local std::vector<BYTE> s_buffer;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	convert(request, s_buffer, response);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	m_numRequests++;
+	m_totalTime += (unsigned long long)ms;
+
+	if (!response.Success)
+	{
+		m_numFailed++;
+		sprintf(answer, "error\t%.3f\tconversion failed", ms);
+		return answer;
+	}
+
+	sprintf(answer, "ok\t%.3f\t%llu\t%d", ms, (unsigned long long)response.Triangles, response.Cached ? 1 : 0);
+	return answer;
+}
+
+#if defined(_WIN32)
+
+bool ConversionServer::Run(const ConvertFunc& convert, int numThreads)
+{
+	// not ported: Unix domain sockets only
+	return false;
+}
+
+bool ConversionServer::Send(const char *path, const std::string& request, std::string& answer)
+{
+	return false;
+}
+
+void ConversionServer::Read(ServerConnection *connection, const char *data, size_t size)
+{
+}
+
+#else
+
+static bool InitAddress(const char *path, sockaddr_un& address)
+{
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (strlen(path) >= sizeof(address.sun_path))
+		return false;
+
+	strcpy(address.sun_path, path);
+	return true;
+}
+
+static bool SendAll(int fd, const std::string& data)
+{
+	size_t sent = 0;
+	while (sent < data.size())
+	{
+		ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+		if (n <= 0)
+			return false;
+		sent += (size_t)n;
+	}
+	return true;
+}
+
+void ConversionServer::Read(ServerConnection *connection, const char *data, size_t size)
+{
+	std::string& pending = connection->Pending;
+	pending.append(data, size);
+
+	size_t begin = 0;
+	size_t end;
+	while ((end = pending.find('\n', begin)) != std::string::npos)
+	{
+		std::string line = pending.substr(begin, end - begin);
+		begin = end + 1;
+
+		// the end of a line that was already answered as too long
+		if (connection->Skipping)
+		{
+			connection->Skipping = false;
+			continue;
+		}
+
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+
+		if (line.size() > SERVER_MAX_LINE)
+			connection->Lines.push_back(std::string());
+		else if (!line.empty())
+			connection->Lines.push_back(line);
+	}
+
+	pending.erase(0, begin);
+
+	// no line end in sight: answer now and drop the rest of the line
+	if (pending.size() > SERVER_MAX_LINE)
+	{
+		if (!connection->Skipping)
+			connection->Lines.push_back(std::string());
+
+		connection->Skipping = true;
+		pending.clear();
+	}
+}
+
+bool ConversionServer::Run(const ConvertFunc& convert, int numThreads)
+{
+	sockaddr_un address;
+	if (!InitAddress(m_path.c_str(), address))
+		return false;
+
+	// a closed client must not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_socket < 0)
+		return false;
+
+	// left by a server that did not exit cleanly
+	unlink(m_path.c_str());
+
+	if (bind(m_socket, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_socket, 64) != 0)
+	{
+		close(m_socket);
+		m_socket = -1;
+		return false;
+	}
+
+	// a worker that answered a line wakes up the accept thread to dispatch the next one
+	int wake[2];
+	if (pipe(wake) != 0)
+		return false;
+
+	fcntl(wake[0], F_SETFL, O_NONBLOCK);
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	TaskPool pool(numThreads);
+	TaskGroup group;
+
+	std::vector<ServerConnection*> connections;
+	std::vector<pollfd> fds;
+	char buffer[4096];
+
+	while (!m_exit)
+	{
+		// the next line of each idle connection goes to the pool, the finished connections are closed
+		for (size_t i = 0; i < connections.size();)
+		{
+			ServerConnection *connection = connections[i];
+			if (connection->Busy)
+			{
+				i++;
+				continue;
+			}
+
+			if (connection->Failed || (connection->Closed && connection->Lines.empty()))
+			{
+				close(connection->Socket);
+				delete connection;
+				connections.erase(connections.begin() + i);
+				continue;
+			}
+
+			if (!connection->Lines.empty())
+			{
+				std::string line = connection->Lines.front();
+				connection->Lines.pop_front();
+				connection->Busy = true;
+
+				int wakeUp = wake[1];
+				pool.Run(group, [this, connection, line, wakeUp, &convert]()
+				{
+					std::string answer = line.empty() ? "error\t0\trequest line too long" : Handle(line, convert);
+					if (!SendAll(connection->Socket, answer + "\n"))
+						connection->Failed = true;
+
+					connection->Busy = false;
+
+					char c = 0;
+					ssize_t written = write(wakeUp, &c, 1);
+					(void)written;
+				});
+			}
+
+			i++;
+		}
+
+		// wake up regularly to see a shutdown request
+		fds.clear();
+
+		pollfd p;
+		p.events = POLLIN;
+		p.revents = 0;
+
+		p.fd = m_socket;
+		fds.push_back(p);
+		p.fd = wake[0];
+		fds.push_back(p);
+
+		for (size_t i = 0; i < connections.size(); i++)
+		{
+			p.fd = connections[i]->Closed || connections[i]->Failed ? -1 : connections[i]->Socket;
+			fds.push_back(p);
+		}
+
+		if (poll(fds.data(), (nfds_t)fds.size(), 200) <= 0)
+			continue;
+
+		if (fds[1].revents != 0)
+		{
+			while (read(wake[0], buffer, sizeof(buffer)) > 0)
+				;
+		}
+
+		for (size_t i = 0; i < connections.size(); i++)
+		{
+			if (fds[i + 2].revents == 0)
+				continue;
+
+			ServerConnection *connection = connections[i];
+
+			ssize_t n = recv(connection->Socket, buffer, sizeof(buffer), 0);
+			if (n <= 0)
+				connection->Closed = true;
+			else
+				Read(connection, buffer, (size_t)n);
+		}
+
+		if (fds[0].revents != 0)
+		{
+			int client = accept(m_socket, NULL, NULL);
+			if (client >= 0)
+				connections.push_back(new ServerConnection(client));
+		}
+	}
+
+	// the requests in progress are answered
+	pool.Wait(group);
+
+	for (size_t i = 0; i < connections.size(); i++)
+	{
+		close(connections[i]->Socket);
+		delete connections[i];
+	}
+
+	close(wake[0]);
+	close(wake[1]);
+	return true;
+}
+
+bool ConversionServer::Send(const char *path, const std::string& request, std::string& answer)
+{
+	sockaddr_un address;
+	if (!InitAddress(path, address))
+		return false;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return false;
+
+	if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0 || !SendAll(fd, request + "\n"))
+	{
+		close(fd);
+		return false;
+	}
+
+	answer.clear();
+	char buffer[512];
+	ssize_t n;
+	while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+	{
+		answer.append(buffer, (size_t)n);
+
+		size_t end = answer.find('\n');
+		if (end != std::string::npos)
+		{
+			answer.erase(end);
+			close(fd);
+			return true;
+		}
+	}
+
+	close(fd);
+	return false;
+}
+
+#endif
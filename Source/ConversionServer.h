@@ -0,0 +1,77 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ServerRequest
+{
+	std::string Input;
+	std::string Output;
+
+	// command line options of the conversion (-optimize, -lod 0.5...)
+	std::vector<std::string> Options;
+};
+
+struct ServerResponse
+{
+	bool Success;
+	bool Cached;
+	UINT64 Triangles;
+};
+
+// Long-running conversion server on a local (Unix domain) socket.
+// One request per line, fields separated by tabs, one answer line per request:
+//   convert INPUT OUTPUT [OPTION...]  ->  ok MS TRIANGLES CACHED | error MS MESSAGE
+//   ping                              ->  ok
+//   stats                             ->  ok REQUESTS FAILED MS
+//   shutdown                          ->  ok
+// The accept thread polls the client sockets and hands each complete request line to a fixed
+// pool of workers: an idle connection holds no worker, the requests of one connection are answered
+// in order (open more connections for parallel requests). The workers stay alive between requests
+// and keep their file read buffer. A line longer than SERVER_MAX_LINE is answered by an error.
+#define SERVER_MAX_LINE (64 * 1024)
+
+struct ServerConnection;
+
+class ConversionServer
+{
+public:
+	// buffer: the read buffer of the worker, reused between its requests
+	typedef std::function<void(const ServerRequest& request, std::vector<BYTE>& buffer, ServerResponse& response)> ConvertFunc;
+
+protected:
+	std::string m_path;
+	int m_socket;
+
+	std::atomic<bool> m_exit;
+	std::atomic<unsigned long long> m_numRequests;
+	std::atomic<unsigned long long> m_numFailed;
+	std::atomic<unsigned long long> m_totalTime;
+
+public:
+	ConversionServer(const char *path);
+
+	virtual ~ConversionServer();
+
+	// accept connections until a shutdown request, false if the socket can not be created
+	bool Run(const ConvertFunc& convert, int numThreads);
+
+	// send one request line, answer without the line end
+	static bool Send(const char *path, const std::string& request, std::string& answer);
+
+	// the server runs in its own folder: the client sends absolute paths
+	static std::string GetAbsolutePath(const char *path);
+
+	// tab separated fields
+	static void Split(const std::string& line, std::vector<std::string>& fields);
+
+protected:
+	// complete lines of the data received on a connection
+	void Read(ServerConnection *connection, const char *data, size_t size);
+
+	std::string Handle(const std::string& line, const ConvertFunc& convert);
+};
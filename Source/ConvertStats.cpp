@@ -0,0 +1,192 @@
+#include "ConvertStats.h"
+
+#include <algorithm>
+#include <math.h>
+
+// nearest rank of a sorted list
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0.0;
+
+	size_t rank = (size_t)ceil(p * sorted.size());
+	rank = rank < 1 ? 1 : (rank > sorted.size() ? sorted.size() : rank);
+	return sorted[rank - 1];
+}
+
+ConvertStats::ConvertStats()
+{
+	Reset();
+}
+
+void ConvertStats::Reset()
+{
+	for (int i = 0; i < SP_COUNT; i++)
+		m_seconds[i] = 0.0;
+
+	for (int i = 0; i < SC_COUNT; i++)
+		m_counters[i] = 0;
+
+	m_phase = -1;
+}
+
+int ConvertStats::Enter(STATS_PHASE phase)
+{
+	Clock::time_point now = Clock::now();
+	if (m_phase >= 0)
+		m_seconds[m_phase] += std::chrono::duration<double>(now - m_start).count();
+
+	int previous = m_phase;
+	m_phase = phase;
+	m_start = now;
+	return previous;
+}
+
+void ConvertStats::Leave(int previous)
+{
+	Clock::time_point now = Clock::now();
+	if (m_phase >= 0)
+		m_seconds[m_phase] += std::chrono::duration<double>(now - m_start).count();
+
+	m_phase = previous;
+	m_start = now;
+}
+
+void ConvertStats::AddCounters(const ConvertStats& other)
+{
+	for (int i = 0; i < SC_COUNT; i++)
+		m_counters[i] += other.m_counters[i];
+}
+
+double ConvertStats::GetTotalSeconds()
+{
+	double seconds = 0.0;
+	for (int i = 0; i < SP_COUNT; i++)
+		seconds += m_seconds[i];
+	return seconds;
+}
+
+void ConvertStats::WriteJSON(JSONWriter& json)
+{
+	json.Write("seconds", GetTotalSeconds());
+
+	json.BeginObject("phases");
+	for (int i = 0; i < SP_COUNT; i++)
+		json.Write(GetPhaseName((STATS_PHASE)i), m_seconds[i]);
+	json.EndObject();
+
+	json.BeginObject("counters");
+	for (int i = 0; i < SC_COUNT; i++)
+		json.Write(GetCounterName((STATS_COUNTER)i), (unsigned long long)m_counters[i]);
+	json.EndObject();
+}
+
+bool ConvertStats::WriteReport(const char *path, const char *input, const char *output, int result)
+{
+	remove(path);
+	FILE *file = fopen(path, "wt");
+	if (file == NULL)
+		return false;
+
+	JSONWriter json(file);
+	json.BeginObject();
+	json.Write("input", input);
+	json.Write("output", output);
+	json.Write("result", result);
+	WriteJSON(json);
+	json.EndObject();
+	json.Finish();
+
+	bool success = ferror(file) == 0;
+	return fclose(file) == 0 && success;
+}
+
+void ConvertStats::WritePercentiles(JSONWriter& json, const std::vector<ConvertStats*>& runs)
+{
+	std::vector<double> seconds(runs.size());
+
+	json.Write("files", (unsigned int)runs.size());
+
+	json.BeginObject("phases");
+	for (int phase = 0; phase <= SP_COUNT; phase++)
+	{
+		// the last entry is the total of each run
+		double total = 0.0;
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			seconds[i] = phase < SP_COUNT ? runs[i]->m_seconds[phase] : runs[i]->GetTotalSeconds();
+			total += seconds[i];
+		}
+
+		std::sort(seconds.begin(), seconds.end());
+
+		json.BeginObject(phase < SP_COUNT ? GetPhaseName((STATS_PHASE)phase) : "total");
+		json.Write("p50", Percentile(seconds, 0.5));
+		json.Write("p90", Percentile(seconds, 0.9));
+		json.Write("p99", Percentile(seconds, 0.99));
+		json.Write("max", seconds.empty() ? 0.0 : seconds.back());
+		json.Write("total", total);
+		json.EndObject();
+	}
+	json.EndObject();
+
+	json.BeginObject("counters");
+	for (int counter = 0; counter < SC_COUNT; counter++)
+	{
+		UINT64 total = 0;
+		for (size_t i = 0; i < runs.size(); i++)
+			total += runs[i]->m_counters[counter];
+		json.Write(GetCounterName((STATS_COUNTER)counter), (unsigned long long)total);
+	}
+	json.EndObject();
+}
+
+const char* ConvertStats::GetPhaseName(STATS_PHASE phase)
+{
+	switch (phase)
+	{
+	case SP_OTHER:
+		return "other";
+	case SP_LOAD:
+		return "load";
+	case SP_FIXUP:
+		return "fixup";
+	case SP_PROCESS:
+		return "process";
+	case SP_REMAP:
+		return "remap";
+	case SP_DECODE:
+		return "decode";
+	case SP_FORMAT:
+		return "format";
+	case SP_FLUSH:
+		return "flush";
+	default:
+		break;
+	}
+	return "";
+}
+
+const char* ConvertStats::GetCounterName(STATS_COUNTER counter)
+{
+	switch (counter)
+	{
+	case SC_BYTES_READ:
+		return "bytesRead";
+	case SC_BYTES_WRITTEN:
+		return "bytesWritten";
+	case SC_SUBSETS:
+		return "subsets";
+	case SC_VERTICES:
+		return "vertices";
+	case SC_FACES:
+		return "faces";
+	case SC_REMAP_HITS:
+		return "remapHits";
+	case SC_ALLOCATIONS:
+		return "allocations";
+	default:
+		break;
+	}
+	return "";
+}
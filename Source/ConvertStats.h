@@ -0,0 +1,146 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "JSONWriter.h"
+#include "Arena.h"
+
+#include <chrono>
+#include <vector>
+
+enum STATS_PHASE
+{
+	// not in a phase below: logs, options, cache writes
+	SP_OTHER = 0,
+	// input file read (or mesh cache open)
+	SP_LOAD,
+	// SDKMesh::Create: static data copy and pointer fixup
+	SP_FIXUP,
+	// MeshProcessor & MeshBounds
+	SP_PROCESS,
+	// subset indices renumbered in first-use order
+	SP_REMAP,
+	// vertex attributes decoded to floats
+	SP_DECODE,
+	// records formatted into the output chunks
+	SP_FORMAT,
+	// chunks written to the sinks
+	SP_FLUSH,
+	SP_COUNT
+};
+
+enum STATS_COUNTER
+{
+	SC_BYTES_READ = 0,
+	SC_BYTES_WRITTEN,
+	SC_SUBSETS,
+	SC_VERTICES,
+	SC_FACES,
+	// indices of a subset that reuse an already remapped vertex
+	SC_REMAP_HITS,
+	// heap calls of the converting thread (Arena::CountHeapCall)
+	SC_ALLOCATIONS,
+	SC_COUNT
+};
+
+// Time per phase and counters of one conversion. The phase times are exclusive:
+// entering a phase pauses the running one, so they add up to the instrumented time.
+// One clock read per phase change; not thread safe, a conversion owns its stats.
+class ConvertStats
+{
+protected:
+	typedef std::chrono::steady_clock Clock;
+
+	double m_seconds[SP_COUNT];
+	UINT64 m_counters[SC_COUNT];
+
+	int m_phase;
+	Clock::time_point m_start;
+
+public:
+	ConvertStats();
+
+	void Reset();
+
+	// returns the running phase (-1: none), passed back to Leave
+	int Enter(STATS_PHASE phase);
+
+	void Leave(int previous);
+
+	inline void Add(STATS_COUNTER counter, UINT64 value)
+	{
+		m_counters[counter] += value;
+	}
+
+	double GetSeconds(STATS_PHASE phase)
+	{
+		return m_seconds[phase];
+	}
+
+	UINT64 GetCounter(STATS_COUNTER counter)
+	{
+		return m_counters[counter];
+	}
+
+	// counters of another conversion part (its phase times are not added)
+	void AddCounters(const ConvertStats& other);
+
+	// sum of the phases
+	double GetTotalSeconds();
+
+	// { "seconds", "phases": {...}, "counters": {...} } as a member of the current scope
+	void WriteJSON(JSONWriter& json);
+
+	// report of a single conversion
+	bool WriteReport(const char *path, const char *input, const char *output, int result);
+
+	// p50, p90, p99, max & total of each phase and the counter totals over many conversions
+	static void WritePercentiles(JSONWriter& json, const std::vector<ConvertStats*>& runs);
+
+	static const char* GetPhaseName(STATS_PHASE phase);
+
+	static const char* GetCounterName(STATS_COUNTER counter);
+};
+
+// Times a scope as a phase, nothing when stats is NULL
+class StatsScope
+{
+protected:
+	ConvertStats *m_stats;
+	int m_previous;
+
+public:
+	StatsScope(ConvertStats *stats, STATS_PHASE phase)
+		:m_stats(stats),
+		m_previous(-1)
+	{
+		if (m_stats != NULL)
+			m_previous = m_stats->Enter(phase);
+	}
+
+	~StatsScope()
+	{
+		if (m_stats != NULL)
+			m_stats->Leave(m_previous);
+	}
+};
+
+// Counts the heap calls of this thread during a scope, nothing when stats is NULL
+class AllocationScope
+{
+protected:
+	ConvertStats *m_stats;
+	unsigned long long m_start;
+
+public:
+	AllocationScope(ConvertStats *stats)
+		:m_stats(stats),
+		m_start(Arena::GetNumHeapCalls())
+	{
+	}
+
+	~AllocationScope()
+	{
+		if (m_stats != NULL)
+			m_stats->Add(SC_ALLOCATIONS, Arena::GetNumHeapCalls() - m_start);
+	}
+};
@@ -0,0 +1,775 @@
+#include "Converter.h"
+#include "OBJWriter.h"
+#include "OBJImporter.h"
+#include "SDKMeshWriter.h"
+#include "PLYWriter.h"
+#include "STLWriter.h"
+#include "MeshCache.h"
+#include "MeshProcessor.h"
+#include "SequenceWriter.h"
+#include "SplitWriter.h"
+#include "MeshBounds.h"
+#include "ConversionCache.h"
+#include "ContentHash.h"
+#include "MemoryBudget.h"
+#include "MeshFilter.h"
+#include "MappedFile.h"
+#include "VertexTransform.h"
+#include "CStringImp.h"
+#include "Log.h"
+
+static int exportOBJ(SDKMesh& sdkMesh, const char *output, MeshProcessor *processor, bool lodObjects, UINT attributes,
+	const VertexTransform *transform, ConvertStats *stats, MemoryBudget *budget)
+{
+	OBJWriter writer(&sdkMesh, output);
+	if (writer.CanWrite() == false)
+	{
+		LogError() << "Can not write: " << output << "\n";
+		return -1;
+	}
+	writer.SetProcessor(processor);
+	writer.SetAttributes(attributes);
+	writer.SetTransform(transform);
+	writer.SetStats(stats);
+	writer.SetBudget(budget);
+
+	LogDebug() << "\n# Material infomations:\n";
+
+	UINT numMaterials = sdkMesh.GetNumMaterials();
+	for (UINT i = 0; i < numMaterials; ++i)
+	{
+		SDKMESH_MATERIAL* mat = sdkMesh.GetMaterial(i);
+		LogDebug() << "Material: " << mat->Name << "\n";
+		LogDebug() << "- DiffuseMapName: " << mat->DiffuseTexture << "\n";
+		LogDebug() << "- NormalMapName: " << mat->NormalTexture << "\n";
+
+		writer.WriteMaterial(mat);
+	}
+
+	// LOD levels written as objects of this file
+	UINT numLevels = 1;
+	if (processor != NULL && lodObjects)
+		numLevels = processor->GetNumLevels();
+
+	int errorCount = 0;
+
+	LogDebug() << "\n# Mesh infomations:\n";
+	UINT numMeshes = sdkMesh.GetNumMeshes();
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		LogDebug() << "\n Mesh ID: " << meshIdx << " - ";
+
+		// Figure out the index type
+		if (sdkMesh.GetIndexType(meshIdx) == IT_32BIT)
+			LogDebug() << "32BIT";
+		else
+			LogDebug() << "16BIT";
+
+		UINT numPrims = static_cast<UINT>(sdkMesh.GetNumIndices(meshIdx) / 3);
+		UINT numVerts = static_cast<UINT>(sdkMesh.GetNumVertices(meshIdx, 0));
+
+		LogDebug() << " - Prims: " << numPrims << ", Verts: " << numVerts << "\n";
+
+		if (Log::IsEnabled(LOG_DEBUG))
+		{
+			LogDebug() << " - Vertex buffer elements\n";
+			sdkMesh.PrintVBElements(sdkMesh.VBElements(meshIdx, 0));
+		}
+
+		SDKMESH_MESH* mesh = sdkMesh.GetMesh(meshIdx);
+
+		for (UINT level = 0; level < numLevels; ++level)
+		{
+			// write name
+			if (level == 0)
+			{
+				writer.WriteObject(mesh->Name);
+			}
+			else
+			{
+				char name[MAX_MESH_NAME + 32];
+				sprintf(name, "%s_lod%d", mesh->Name, level);
+				writer.WriteObject(name);
+
+				LogDebug() << " - LOD " << level << "\n";
+			}
+
+			if (numLevels > 1)
+				processor->SetLevel(level);
+
+			UINT numSubsets = sdkMesh.GetNumSubsets(meshIdx);
+
+			for (UINT i = 0; i < numSubsets; ++i)
+			{
+				SDKMESH_SUBSET* subset = sdkMesh.GetSubset(meshIdx, i);
+
+				int materialID = subset->MaterialID;
+				SDKMESH_MATERIAL* mat = sdkMesh.GetMaterial(materialID);
+
+				int faceCount = static_cast<DWORD>(subset->IndexCount / 3);
+
+				const char *PrimitiveType[] = {
+					"PT_TRIANGLE_LIST",
+					"PT_TRIANGLE_STRIP",
+					"PT_LINE_LIST",
+					"PT_LINE_STRIP",
+					"PT_POINT_LIST",
+					"PT_TRIANGLE_LIST_ADJ",
+					"PT_TRIANGLE_STRIP_ADJ",
+					"PT_LINE_LIST_ADJ",
+					"PT_LINE_STRIP_ADJ",
+					"PT_QUAD_PATCH_LIST",
+					"PT_TRIANGLE_PATCH_LIST",
+				};
+
+				LogDebug() << "- Subset: " << i << " " << mat->Name << " - " << PrimitiveType[subset->PrimitiveType] << "\n";
+				LogDebug() << "  + Indices start: " << subset->IndexStart << "\n";
+				LogDebug() << "  + Indices count: " << subset->IndexCount << "\n";
+				LogDebug() << "  + Face count: " << faceCount << "\n";
+
+				if (subset->PrimitiveType == 0)
+				{
+					if (writer.WriteSubset(meshIdx, subset, numSubsets > 1) == true)
+						LogDebug() << "  -> Writed!\n";
+					else
+						LogError() << "  -> Write error!\n";
+				}
+				else
+				{
+					LogError() << "  -> Error: OBJ Exporter just support TRIANGLE_LIST!\n";
+					errorCount++;
+				}
+			}
+		}
+	}
+
+	if (writer.Finish() == false)
+	{
+		LogError() << "Can not write: " << output << "\n";
+		errorCount++;
+	}
+
+	return errorCount;
+}
+
+static int exportBinary(SDKMesh& sdkMesh, const char *output, const char *ext, MeshProcessor *processor, UINT attributes,
+	const VertexTransform *transform, ConvertStats *stats, MemoryBudget *budget)
+{
+	bool success;
+	if (strcmp(ext, "ply") == 0)
+	{
+		PLYWriter plyWriter(&sdkMesh, output);
+		if (plyWriter.CanWrite() == false)
+		{
+			LogError() << "Can not write: " << output << "\n";
+			return -1;
+		}
+		plyWriter.SetProcessor(processor);
+		plyWriter.SetAttributes(attributes);
+		plyWriter.SetTransform(transform);
+		plyWriter.SetStats(stats);
+		plyWriter.SetBudget(budget);
+		success = plyWriter.Write();
+	}
+	else
+	{
+		STLWriter stlWriter(&sdkMesh, output);
+		if (stlWriter.CanWrite() == false)
+		{
+			LogError() << "Can not write: " << output << "\n";
+			return -1;
+		}
+		stlWriter.SetProcessor(processor);
+		stlWriter.SetTransform(transform);
+		stlWriter.SetStats(stats);
+		stlWriter.SetBudget(budget);
+		success = stlWriter.Write();
+	}
+
+	if (!success)
+	{
+		LogError() << "Error: write " << output << " failed!\n";
+		return 1;
+	}
+
+	return 0;
+}
+
+static int exportSequence(SDKMesh& sdkMesh, const char *output, MeshProcessor *processor, UINT attributes,
+	const VertexTransform *transform, double start, double end, int numThreads, std::vector<std::string>& files)
+{
+	SequenceWriter writer(&sdkMesh);
+	writer.SetProcessor(processor);
+	writer.SetAttributes(attributes);
+	writer.SetTransform(transform);
+
+	UINT numSamples = writer.SamplePoses(start, end);
+	if (numSamples == 0)
+	{
+		LogError() << "Error: -sequence needs an animation (-anim) with samples in the time range!\n";
+		return -1;
+	}
+
+	if (!writer.Prepare())
+		LogError() << "Warning: some subsets can not be decoded!\n";
+
+	SDKANIMATION_FILE_HEADER *header = sdkMesh.GetAnimationHeader();
+	LogInfo() << "\n# Sequence: " << numSamples << " frames at " << header->AnimationFPS << " fps\n";
+
+	int errorCount = writer.Write(output, numThreads);
+	if (errorCount < 0)
+		return -1;
+
+	char path[MAX_PATH];
+	strcpy(path, output);
+	Skylicht::CStringImp::replacePathExt(path, ".mtl");
+	files.push_back(path);
+
+	for (UINT i = 0; i < numSamples; ++i)
+	{
+		SequenceWriter::GetFramePath(output, i, path);
+		files.push_back(path);
+	}
+
+	if (errorCount > 0)
+		LogError() << "Error: " << errorCount << " frames failed!\n";
+
+	return errorCount;
+}
+
+static int exportSplit(SDKMesh& sdkMesh, const char *input, const char *output, SPLIT_MODE mode, MeshProcessor *processor,
+	UINT attributes, const VertexTransform *transform, int numThreads, ConvertStats *stats, std::vector<std::string>& files)
+{
+	SplitWriter writer(&sdkMesh, mode);
+	writer.SetProcessor(processor);
+	writer.SetAttributes(attributes);
+	writer.SetTransform(transform);
+	writer.Plan(output);
+
+	int errorCount = writer.Write(input, output, numThreads, stats, files);
+	if (errorCount > 0)
+		LogError() << "Error: " << errorCount << " parts failed!\n";
+
+	return errorCount;
+}
+
+std::string getOptionsKey(const ConvertOptions& options, const char *output)
+{
+	char text[512];
+	sprintf(text, "skin=%d,%.9g|lodobjects=%d|optimize=%d|crease=%.9g|bounds=%d,%d|sequence=%d,%.9g,%.9g|lod=",
+		options.Skin ? 1 : 0, options.SkinTime,
+		options.LODObjects ? 1 : 0,
+		options.Optimize ? 1 : 0,
+		options.Crease,
+		options.Bounds ? 1 : 0, options.Spheres ? 1 : 0,
+		options.Sequence ? 1 : 0, options.Start, options.End);
+
+	std::string key = text;
+	for (size_t i = 0; i < options.LODRatios.size(); i++)
+	{
+		sprintf(text, "%.9g,", options.LODRatios[i]);
+		key += text;
+	}
+
+	// the OBJ of a windowed subset lists its vertices window by window
+	if (options.Budget > 0)
+	{
+		sprintf(text, "|budget=%llu", (unsigned long long)options.Budget);
+		key += text;
+	}
+
+	if (!options.Select.empty() || !options.Exclude.empty())
+	{
+		key += "|select=" + options.Select;
+		key += "|exclude=" + options.Exclude;
+	}
+
+	if (!options.Split.empty())
+		key += "|split=" + options.Split;
+
+	if (!options.Attributes.empty())
+		key += "|attributes=" + options.Attributes;
+
+	if (!options.Axes.empty() || !options.Scale.empty() || !options.Transform.empty() || options.FlipWinding)
+	{
+		key += "|axes=" + options.Axes;
+		key += "|scale=" + options.Scale;
+		key += "|transform=" + options.Transform;
+		key += options.FlipWinding ? "|flipwinding" : "";
+	}
+
+	// the animation content, not its path
+	if (!options.Anim.empty())
+	{
+		UINT64 anim = 0;
+		ContentHash::HashFile(options.Anim.c_str(), 1, &anim);
+		sprintf(text, "|anim=%llx", (unsigned long long)anim);
+		key += text;
+	}
+
+	// the entry is restored at this path
+	key += "|output=";
+	key += output;
+	return key;
+}
+
+// OBJ (+ MTL) back to an sdkmesh
+static int importOBJ(const char *input, const char *output, const ConvertOptions& options, ConvertResult& result)
+{
+	char ext[MAX_PATH];
+	Skylicht::CStringImp::getFileNameExt(ext, output);
+	Skylicht::CStringImp::toLower(ext);
+
+	if (strcmp(ext, "sdkmesh") != 0)
+	{
+		LogError() << "Error: an OBJ input is converted to an sdkmesh only!\n";
+		return -1;
+	}
+
+	ConvertStats *stats = result.Stats;
+
+	OBJImporter importer;
+	bool loaded;
+	{
+		StatsScope scope(stats, SP_LOAD);
+		loaded = importer.Load(input, options.NumThreads);
+	}
+
+	if (!loaded)
+	{
+		LogError() << "Open " << input << " failed!\n";
+		return -1;
+	}
+
+	SDKMeshWriter writer;
+	{
+		StatsScope scope(stats, SP_PROCESS);
+		importer.Build(writer, options.NumThreads);
+	}
+	importer.PrintStats();
+
+	bool written;
+	{
+		StatsScope scope(stats, SP_FLUSH);
+		written = writer.Write(output);
+	}
+
+	if (!written)
+	{
+		LogError() << "Can not write: " << output << "\n";
+		return -1;
+	}
+
+	if (stats != NULL)
+		stats->Add(SC_FACES, importer.GetNumTriangles());
+
+	result.Triangles = importer.GetNumTriangles();
+	result.Files.push_back(output);
+
+	if (importer.GetNumErrors() > 0)
+		return 1;
+
+	LogInfo() << "Finished!\n";
+	return 0;
+}
+
+// SDKMesh::Create takes a UINT byte count
+static bool checkCreateSize(const char *path, UINT64 size)
+{
+	if (size <= 0xFFFFFFFF)
+		return true;
+
+	LogError() << "Error: " << path << " is 4 GB or larger, can not be loaded from memory\n";
+	return false;
+}
+
+// read a whole file in a reused buffer
+static bool readFile(const char *path, std::vector<BYTE>& buffer)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if (size > 0 && !checkCreateSize(path, (UINT64)size))
+	{
+		fclose(file);
+		return false;
+	}
+
+	// the capacity is kept between the calls
+	buffer.resize(size > 0 ? (size_t)size : 0);
+	bool success = size > 0 && fread(buffer.data(), (size_t)size, 1, file) == 1;
+
+	fclose(file);
+	return success;
+}
+
+int convert(const char *input, const char *output, const ConvertOptions& options, ConvertResult& result,
+	std::vector<BYTE> *buffer)
+{
+	char inputExt[MAX_PATH];
+	Skylicht::CStringImp::getFileNameExt(inputExt, input);
+	Skylicht::CStringImp::toLower(inputExt);
+
+	ConvertStats *stats = result.Stats;
+	StatsScope scope(stats, SP_OTHER);
+
+	// the temporaries of the conversion come from the arena of this thread, rewound on return
+	ArenaScope session(Arena::GetThreadArena());
+	AllocationScope allocations(stats);
+
+	if (strcmp(inputExt, "obj") == 0)
+		return importOBJ(input, output, options, result);
+
+	// -select & -exclude: the headers are read first, then the buffers of the selected meshes only
+	MeshFilter filter;
+	if (!filter.Add(options.Select.c_str(), false) || !filter.Add(options.Exclude.c_str(), true))
+	{
+		LogError() << "Error: -select and -exclude take [mesh:|subset:|material:|frame:]NAME lists\n";
+		return -1;
+	}
+
+	// -attributes: the stripped elements are never decoded
+	UINT attributes = VA_ALL;
+	if (!options.Attributes.empty() && !SubsetDecoder::ParseAttributes(options.Attributes.c_str(), &attributes))
+	{
+		LogError() << "Error: -attributes takes a position,normal,uv,color list\n";
+		return -1;
+	}
+
+	// -axes, -scale, -transform & -flipwinding: converted in the decoded chunks and the written faces
+	VertexTransform vertexTransform;
+	const VertexTransform *transform = NULL;
+	if (!options.Axes.empty() || !options.Scale.empty() || !options.Transform.empty() || options.FlipWinding)
+	{
+		if (!vertexTransform.Set(options.Axes.c_str(), options.Scale.c_str(), options.Transform.c_str(), options.FlipWinding))
+		{
+			LogError() << "Error: -axes takes x,y,z with signs, -scale 1 or 3 values, -transform 16 values, not singular\n";
+			return -1;
+		}
+		transform = &vertexTransform;
+	}
+
+	// a selection is not read from or written to the mesh cache
+	const std::string& cache = options.Cache;
+	bool useCache = !cache.empty() && !filter.IsEnabled();
+	MeshCache meshCache;
+
+	bool cacheOpened = false;
+	if (useCache)
+	{
+		StatsScope load(stats, SP_LOAD);
+		cacheOpened = meshCache.Open(cache.c_str(), input);
+	}
+
+	// the file read and the pointer fixup are timed apart
+	std::vector<BYTE> statsBuffer;
+	if (buffer == NULL && stats != NULL)
+		buffer = &statsBuffer;
+
+	// -budget: the input is mapped, the writers release its pages as they consume them
+	MemoryBudget budget(options.Budget);
+	MappedFile mappedFile;
+
+	SDKMesh sdkMesh;
+	HRESULT cached = E_FAIL;
+	if (cacheOpened)
+	{
+		StatsScope fixup(stats, SP_FIXUP);
+		cached = sdkMesh.Create(&meshCache);
+	}
+
+	if (cached == S_OK)
+	{
+		LogInfo() << "Load cache: " << cache.c_str() << "\n";
+
+		// split streams: only the pages of the written ones are read
+		if (attributes != VA_ALL)
+		{
+			UINT flags = 0;
+			if (attributes & VA_NORMAL)
+				flags |= MCF_NORMAL;
+			if (attributes & VA_TEXCOORD)
+				flags |= MCF_TEXCOORD;
+			if (attributes & VA_COLOR)
+				flags |= MCF_COLOR;
+			meshCache.Prefetch(flags);
+		}
+	}
+	else
+	{
+		HRESULT r;
+		if (filter.IsEnabled())
+		{
+			std::vector<BYTE>& data = buffer != NULL ? *buffer : statsBuffer;
+			bool loaded;
+			{
+				StatsScope load(stats, SP_LOAD);
+				loaded = filter.Load(input, &sdkMesh, data);
+			}
+
+			// valid headers without a selected subset
+			if (!loaded && sdkMesh.GetHeader() != NULL && filter.GetNumSubsets() == 0)
+			{
+				LogError() << "Error: nothing selected in " << input << "\n";
+				return -1;
+			}
+
+			r = loaded ? S_OK : E_FAIL;
+
+			if (loaded && stats != NULL)
+				stats->Add(SC_BYTES_READ, filter.GetBytesRead());
+
+			if (loaded)
+				filter.PrintStats();
+		}
+		else if (options.Budget > 0)
+		{
+			bool mapped;
+			{
+				StatsScope load(stats, SP_LOAD);
+				mapped = mappedFile.Open(input) && checkCreateSize(input, mappedFile.GetSize());
+			}
+
+			// only the header & non-buffer data are copied
+			StatsScope fixup(stats, SP_FIXUP);
+			r = mapped ? sdkMesh.Create(mappedFile.GetData(), (UINT)mappedFile.GetSize(), false, true) : E_FAIL;
+
+			if (r == S_OK)
+			{
+				SDKMESH_HEADER *header = sdkMesh.GetHeader();
+				budget.SetInput(&mappedFile, (size_t)(header->HeaderSize + header->NonBufferDataSize));
+			}
+		}
+		else if (buffer != NULL)
+		{
+			bool read;
+			{
+				StatsScope load(stats, SP_LOAD);
+				read = readFile(input, *buffer);
+			}
+
+			if (read && stats != NULL)
+				stats->Add(SC_BYTES_READ, buffer->size());
+
+			StatsScope fixup(stats, SP_FIXUP);
+			r = read ? sdkMesh.Create(buffer->data(), (UINT)buffer->size(), false, true) : E_FAIL;
+		}
+		else
+		{
+			r = sdkMesh.Create(input);
+		}
+
+		if (r == E_FAIL)
+		{
+			LogError() << "Open " << input << " failed!\n";
+			return -1;
+		}
+
+		if (useCache)
+		{
+			if (MeshCache::Write(&sdkMesh, input, cache.c_str()))
+				LogInfo() << "Write cache: " << cache.c_str() << "\n";
+			else
+				LogError() << "Can not write cache: " << cache.c_str() << "\n";
+		}
+	}
+
+	result.Triangles = 0;
+	for (UINT i = 0; i < sdkMesh.GetNumMeshes(); ++i)
+		result.Triangles += sdkMesh.GetNumIndices(i) / 3;
+
+	int numThreads = options.NumThreads;
+
+	if (!options.Anim.empty())
+	{
+		if (sdkMesh.LoadAnimation(options.Anim.c_str()) == S_OK)
+			LogInfo() << "Load animation: " << options.Anim.c_str() << "\n";
+		else
+			LogError() << "Warning: open " << options.Anim.c_str() << " failed, use the bind pose\n";
+	}
+
+	// optional per-subset processing
+	MeshProcessor processor(&sdkMesh);
+	processor.SetOptimizeVertexCache(options.Optimize);
+	processor.SetLODRatios(options.LODRatios);
+	processor.SetSkinning(options.Skin, options.SkinTime);
+	processor.SetGenerateNormals((attributes & VA_NORMAL) != 0, options.Crease * 3.14159265f / 180.0f);
+
+	MeshProcessor *meshProcessor = NULL;
+	if (processor.IsEnabled())
+	{
+		StatsScope process(stats, SP_PROCESS);
+
+		if (!processor.Process(numThreads))
+			LogError() << "Warning: invalid indices in some subsets!\n";
+
+		processor.PrintStats();
+		meshProcessor = &processor;
+	}
+
+	// exact bounds of the written positions: OUTPUT.bounds.json
+	if (options.Bounds)
+	{
+		StatsScope process(stats, SP_PROCESS);
+
+		MeshBounds bounds(&sdkMesh);
+		bounds.SetProcessor(meshProcessor);
+		bounds.SetTransform(transform);
+		bounds.SetSpheres(options.Spheres);
+		bounds.Compute(numThreads);
+		bounds.PrintStats();
+
+		if (bounds.GetNumStale() > 0)
+			LogError() << "Warning: " << bounds.GetNumStale() << " meshes have stale stored bounds!\n";
+
+		char path[MAX_PATH];
+		strcpy(path, output);
+		Skylicht::CStringImp::replacePathExt(path, ".bounds.json");
+
+		if (bounds.WriteMetadata(path, input))
+			result.Files.push_back(path);
+		else
+			LogError() << "Can not write: " << path << "\n";
+	}
+
+	char ext[MAX_PATH];
+	Skylicht::CStringImp::getFileNameExt(ext, output);
+	Skylicht::CStringImp::toLower(ext);
+
+	if (options.Sequence)
+	{
+		if (strcmp(ext, "obj") != 0)
+		{
+			LogError() << "Error: -sequence writes OBJ files only!\n";
+			return -1;
+		}
+
+		int r = exportSequence(sdkMesh, output, meshProcessor, attributes, transform, options.Start, options.End, numThreads, result.Files);
+		if (r < 0)
+			return -1;
+
+		if (r == 0)
+			LogInfo() << "Finished!\n";
+
+		return r > 0 ? 1 : 0;
+	}
+
+	bool binary = strcmp(ext, "ply") == 0 || strcmp(ext, "stl") == 0;
+
+	// -split: the parts of each LOD level are written in parallel
+	bool split = !options.Split.empty();
+	SPLIT_MODE splitMode = SPLIT_MESH;
+	if (split && (binary || !SplitWriter::ParseMode(options.Split.c_str(), &splitMode)))
+	{
+		LogError() << "Error: -split takes mesh, subset or material and writes OBJ files only!\n";
+		return -1;
+	}
+
+	// LOD levels written as separate files: OUTPUT_lod1.obj...
+	UINT numFiles = 1;
+	if (meshProcessor != NULL && (binary || split || !options.LODObjects))
+		numFiles = processor.GetNumLevels();
+
+	int errorCount = 0;
+
+	for (UINT level = 0; level < numFiles; ++level)
+	{
+		char path[MAX_PATH];
+		strcpy(path, output);
+
+		if (level > 0)
+		{
+			std::string lodExt = "_lod" + std::to_string(level) + "." + ext;
+			if (strlen(output) + lodExt.size() >= MAX_PATH)
+			{
+				LogError() << "Error: the LOD " << level << " path of " << output << " is too long\n";
+				errorCount++;
+				continue;
+			}
+
+			Skylicht::CStringImp::replacePathExt(path, lodExt.c_str());
+
+			LogInfo() << "\n# LOD " << level << ": " << path << "\n";
+		}
+
+		if (numFiles > 1)
+			processor.SetLevel(level);
+
+		// the writers time their remap, decode & flush, the rest is formatting
+		int r;
+		{
+			StatsScope format(stats, SP_FORMAT);
+			if (split)
+				r = exportSplit(sdkMesh, input, path, splitMode, meshProcessor, attributes, transform, numThreads, stats, result.Files);
+			else if (binary)
+				r = exportBinary(sdkMesh, path, ext, meshProcessor, attributes, transform, stats, options.Budget > 0 ? &budget : NULL);
+			else
+				r = exportOBJ(sdkMesh, path, meshProcessor, options.LODObjects, attributes, transform, stats, options.Budget > 0 ? &budget : NULL);
+		}
+
+		if (r < 0)
+			return -1;
+
+		errorCount += r;
+
+		// the split writer lists its files
+		if (split)
+			continue;
+
+		result.Files.push_back(path);
+		if (!binary)
+		{
+			Skylicht::CStringImp::replacePathExt(path, ".mtl");
+			result.Files.push_back(path);
+		}
+	}
+
+	if (options.Budget > 0)
+	{
+		LogDebug() << "Memory: peak " << MemoryBudget::GetPeakMemory() / (1024 * 1024) << " MB, budget "
+			<< options.Budget / (1024 * 1024) << " MB, " << budget.GetNumReleases() << " input releases\n";
+	}
+
+	if (errorCount > 0)
+	{
+		LogError() << "Error: " << errorCount;
+		return 1;
+	}
+
+	LogInfo() << "Finished!\n";
+	return 0;
+}
+
+int convertCached(const char *input, const char *output, const ConvertOptions& options, ConversionCache *cache, ConvertResult& result,
+	std::vector<BYTE> *buffer)
+{
+	if (cache == NULL)
+		return convert(input, output, options, result, buffer);
+
+	UINT64 key;
+	if (!cache->GetKey(input, getOptionsKey(options, output), options.NumThreads, &key))
+	{
+		LogError() << "Open " << input << " failed!\n";
+		return -1;
+	}
+
+	if (cache->Restore(key, output, &result.Triangles))
+	{
+		LogInfo() << "Up to date: " << output << "\n";
+		result.Cached = true;
+		return 0;
+	}
+
+	int r = convert(input, output, options, result, buffer);
+
+	// only complete conversions are reused
+	if (r == 0 && !cache->Store(key, result.Files, result.Triangles))
+		LogError() << "Warning: can not store " << output << " in the conversion cache\n";
+
+	return r;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "ConvertStats.h"
+
+#include <string>
+#include <vector>
+
+class ConversionCache;
+
+// options shared by every converted file
+struct ConvertOptions
+{
+	// -cache FILE: decoded mesh cache
+	std::string Cache;
+
+	// -skin [-anim FILE -time SECONDS]
+	std::string Anim;
+	bool Skin;
+	double SkinTime;
+
+	// threads of the parallel stages, 0: all cores
+	int NumThreads;
+
+	// -lod 0.5,0.25 [-lodobjects]
+	std::vector<float> LODRatios;
+	bool LODObjects;
+
+	bool Optimize;
+
+	// degrees, 0: smooth generated normals
+	float Crease;
+
+	bool Bounds;
+	bool Spheres;
+
+	// -sequence [-start SECONDS -end SECONDS], End < 0: to the end of the animation
+	bool Sequence;
+	double Start;
+	double End;
+
+	// -incremental FOLDER: conversion cache
+	std::string Incremental;
+
+	// -budget MB: peak memory in bytes, the input is mapped and streamed; 0: read whole
+	UINT64 Budget;
+
+	// -select & -exclude: [mesh:|subset:|material:|frame:]GLOB lists, only the buffers of the selection are read
+	std::string Select;
+	std::string Exclude;
+
+	// -split mesh|subset|material: one OBJ per part sharing OUTPUT.mtl, listed in OUTPUT.parts.json
+	std::string Split;
+
+	// -attributes position[,normal,uv,color]: the vertex elements written, empty: all
+	std::string Attributes;
+
+	// -axes x,y,-z -scale S|SX,SY,SZ -transform M00,...,M33 [-flipwinding]: coordinate conversion of the
+	// written positions & normals, empty: none
+	std::string Axes;
+	std::string Scale;
+	std::string Transform;
+	bool FlipWinding;
+
+	ConvertOptions()
+		:Skin(false),
+		SkinTime(0.0),
+		NumThreads(0),
+		LODObjects(false),
+		Optimize(false),
+		Crease(0.0f),
+		Bounds(false),
+		Spheres(false),
+		Sequence(false),
+		Start(0.0),
+		End(-1.0),
+		Budget(0),
+		FlipWinding(false)
+	{
+	}
+};
+
+// what a conversion read and wrote
+struct ConvertResult
+{
+	UINT64 Triangles;
+	std::vector<std::string> Files;
+	bool Cached;
+
+	// set by the caller to time the phases of the conversion (not owned), NULL: off
+	ConvertStats *Stats;
+
+	ConvertResult()
+		:Triangles(0),
+		Cached(false),
+		Stats(NULL)
+	{
+	}
+};
+
+// In-process conversion API (libsdkmesh): the command line, the batch mode and the server are
+// front ends of these calls. The output format follows the extension of output (obj, ply, stl).
+// Calls are independent and can run on several threads at once.
+
+// returns 0 on success, > 0 if some subsets failed, < 0 if the input or output can not be opened
+// buffer: optional reused read buffer, the sdkmesh buffers then point in it
+int convert(const char *input, const char *output, const ConvertOptions& options, ConvertResult& result,
+	std::vector<BYTE> *buffer = NULL);
+
+inline int convert(const char *input, const char *output, const ConvertOptions& options)
+{
+	ConvertResult result;
+	return convert(input, output, options, result);
+}
+
+// convert through the conversion cache when one is set
+int convertCached(const char *input, const char *output, const ConvertOptions& options, ConversionCache *cache, ConvertResult& result,
+	std::vector<BYTE> *buffer = NULL);
+
+// every option that changes the written files, part of the conversion cache key
+std::string getOptionsKey(const ConvertOptions& options, const char *output);
@@ -0,0 +1,119 @@
+#include "FileReader.h"
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+FileReader::FileReader()
+	:m_size(0)
+{
+#if defined(_WIN32)
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	m_file = -1;
+#endif
+}
+
+FileReader::~FileReader()
+{
+	Close();
+}
+
+bool FileReader::Open(const char *path)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_size = (unsigned long long)fileSize.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	m_file = fd;
+	m_size = (unsigned long long)st.st_size;
+#endif
+	return true;
+}
+
+void FileReader::Close()
+{
+#if defined(_WIN32)
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_file >= 0)
+		close(m_file);
+	m_file = -1;
+#endif
+	m_size = 0;
+}
+
+bool FileReader::IsOpen()
+{
+#if defined(_WIN32)
+	return m_file != INVALID_HANDLE_VALUE;
+#else
+	return m_file >= 0;
+#endif
+}
+
+size_t FileReader::ReadAt(void *data, size_t size, unsigned long long offset)
+{
+#if defined(_WIN32)
+	// ReadFile takes 32-bit sizes
+	size_t done = 0;
+	while (done < size)
+	{
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(OVERLAPPED));
+		overlapped.Offset = (DWORD)(offset + done);
+		overlapped.OffsetHigh = (DWORD)((offset + done) >> 32);
+
+		DWORD chunk = size - done > 0x40000000 ? 0x40000000 : (DWORD)(size - done);
+		DWORD read = 0;
+		if (!ReadFile(m_file, (char*)data + done, chunk, &read, &overlapped) || read == 0)
+			break;
+		done += (size_t)read;
+	}
+	return done;
+#else
+	size_t done = 0;
+	while (done < size)
+	{
+		ssize_t n = pread(m_file, (char*)data + done, size - done, (off_t)(offset + done));
+		if (n <= 0)
+			break;
+		done += (size_t)n;
+	}
+	return done;
+#endif
+}
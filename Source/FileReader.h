@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+
+// Positioned reads of a file: no seek and no stdio buffer, so a few ranges of a large
+// file are read without touching the rest. Reads of one reader can run on several threads.
+class FileReader
+{
+protected:
+#if defined(_WIN32)
+	void *m_file;
+#else
+	int m_file;
+#endif
+	unsigned long long m_size;
+
+public:
+	FileReader();
+
+	virtual ~FileReader();
+
+	bool Open(const char *path);
+
+	void Close();
+
+	bool IsOpen();
+
+	unsigned long long GetSize()
+	{
+		return m_size;
+	}
+
+	// returns the bytes read, less than size at the end of the file or on error
+	size_t ReadAt(void *data, size_t size, unsigned long long offset);
+};
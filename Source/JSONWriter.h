@@ -0,0 +1,146 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+// Minimal streaming JSON output (objects, arrays, strings, numbers, bools), indented with tabs
+class JSONWriter
+{
+protected:
+	FILE *m_file;
+
+	// per open scope: true until its first value is written
+	std::vector<bool> m_first;
+
+public:
+	JSONWriter(FILE *file)
+		:m_file(file)
+	{
+	}
+
+	// name is NULL for the root and array items
+	void BeginObject(const char *name = NULL)
+	{
+		Key(name);
+		fputc('{', m_file);
+		m_first.push_back(true);
+	}
+
+	void EndObject()
+	{
+		End('}');
+	}
+
+	void BeginArray(const char *name = NULL)
+	{
+		Key(name);
+		fputc('[', m_file);
+		m_first.push_back(true);
+	}
+
+	void EndArray()
+	{
+		End(']');
+	}
+
+	void Write(const char *name, const char *value)
+	{
+		Key(name);
+		String(value);
+	}
+
+	void Write(const char *name, double value)
+	{
+		Key(name);
+		fprintf(m_file, "%.9g", value);
+	}
+
+	void Write(const char *name, unsigned long long value)
+	{
+		Key(name);
+		fprintf(m_file, "%llu", value);
+	}
+
+	void Write(const char *name, unsigned int value)
+	{
+		Write(name, (unsigned long long)value);
+	}
+
+	void Write(const char *name, int value)
+	{
+		Key(name);
+		fprintf(m_file, "%d", value);
+	}
+
+	void Write(const char *name, bool value)
+	{
+		Key(name);
+		fputs(value ? "true" : "false", m_file);
+	}
+
+	// inline array of numbers
+	void Write(const char *name, const float *values, int count)
+	{
+		Key(name);
+		fputc('[', m_file);
+		for (int i = 0; i < count; i++)
+			fprintf(m_file, i > 0 ? ", %.9g" : "%.9g", values[i]);
+		fputc(']', m_file);
+	}
+
+	// end the line after the root value
+	void Finish()
+	{
+		fputc('\n', m_file);
+	}
+
+protected:
+	void Indent()
+	{
+		fputc('\n', m_file);
+		for (size_t i = 0; i < m_first.size(); i++)
+			fputc('\t', m_file);
+	}
+
+	void Key(const char *name)
+	{
+		if (!m_first.empty())
+		{
+			if (!m_first.back())
+				fputc(',', m_file);
+			m_first.back() = false;
+			Indent();
+		}
+
+		if (name != NULL)
+		{
+			String(name);
+			fputs(": ", m_file);
+		}
+	}
+
+	void End(char c)
+	{
+		bool empty = m_first.back();
+		m_first.pop_back();
+		if (!empty)
+			Indent();
+		fputc(c, m_file);
+	}
+
+	void String(const char *s)
+	{
+		fputc('"', m_file);
+		for (; *s; s++)
+		{
+			unsigned char c = (unsigned char)*s;
+			if (c == '"' || c == '\\')
+				fprintf(m_file, "\\%c", c);
+			else if (c < 0x20)
+				fprintf(m_file, "\\u%04x", c);
+			else
+				fputc(c, m_file);
+		}
+		fputc('"', m_file);
+	}
+};
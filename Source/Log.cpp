@@ -0,0 +1,54 @@
+#include "Log.h"
+
+#include <stdio.h>
+#include <mutex>
+
+// written to stdout past this size
+#define LOG_BUFFER_SIZE (64 * 1024)
+
+LOG_LEVEL Log::s_level = LOG_INFO;
+
+struct LogBuffer
+{
+	std::mutex Lock;
+	std::string Text;
+
+	void Flush()
+	{
+		if (!Text.empty())
+		{
+			fwrite(Text.data(), 1, Text.size(), stdout);
+			fflush(stdout);
+			Text.clear();
+		}
+	}
+
+	~LogBuffer()
+	{
+		Flush();
+	}
+};
+
+// constructed on first use, flushed at exit
+static LogBuffer& GetBuffer()
+{
+	static LogBuffer buffer;
+	return buffer;
+}
+
+void Log::Write(const char *text, size_t size)
+{
+	LogBuffer& buffer = GetBuffer();
+	std::lock_guard<std::mutex> lock(buffer.Lock);
+
+	buffer.Text.append(text, size);
+	if (buffer.Text.size() >= LOG_BUFFER_SIZE)
+		buffer.Flush();
+}
+
+void Log::Flush()
+{
+	LogBuffer& buffer = GetBuffer();
+	std::lock_guard<std::mutex> lock(buffer.Lock);
+	buffer.Flush();
+}
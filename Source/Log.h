@@ -0,0 +1,98 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+enum LOG_LEVEL
+{
+	// nothing (the per-file log of the batch & server)
+	LOG_NONE = 0,
+	// errors & warnings (-q)
+	LOG_ERROR,
+	// progress & results (default)
+	LOG_INFO,
+	// materials, meshes, subsets & vertex elements of each file (-v)
+	LOG_DEBUG,
+};
+
+// Levelled console log. Lines are appended to a shared buffer (one lock per line, thread safe)
+// written to stdout when it is full, on Flush and at exit: no terminal I/O per line.
+class Log
+{
+protected:
+	static LOG_LEVEL s_level;
+
+public:
+	static void SetLevel(LOG_LEVEL level)
+	{
+		s_level = level;
+	}
+
+	static LOG_LEVEL GetLevel()
+	{
+		return s_level;
+	}
+
+	static inline bool IsEnabled(LOG_LEVEL level)
+	{
+		return level <= s_level;
+	}
+
+	static void Write(const char *text, size_t size);
+
+	static void Flush();
+};
+
+// Text of a level, written to the log when destroyed: LogInfo() << "Finished!\n";
+// nothing is formatted when the level is off
+class LogStream
+{
+protected:
+	std::ostringstream *m_stream;
+
+public:
+	LogStream(LOG_LEVEL level)
+		:m_stream(Log::IsEnabled(level) ? new std::ostringstream() : NULL)
+	{
+	}
+
+	~LogStream()
+	{
+		if (m_stream != NULL)
+		{
+			std::string text = m_stream->str();
+			Log::Write(text.c_str(), text.size());
+			delete m_stream;
+		}
+	}
+
+	template<class T>
+	LogStream& operator<<(const T& value)
+	{
+		if (m_stream != NULL)
+			*m_stream << value;
+		return *this;
+	}
+
+private:
+	LogStream(const LogStream&);
+	LogStream& operator=(const LogStream&);
+};
+
+class LogError : public LogStream
+{
+public:
+	LogError() :LogStream(LOG_ERROR) {}
+};
+
+class LogInfo : public LogStream
+{
+public:
+	LogInfo() :LogStream(LOG_INFO) {}
+};
+
+class LogDebug : public LogStream
+{
+public:
+	LogDebug() :LogStream(LOG_DEBUG) {}
+};
@@ -0,0 +1,227 @@
+#include "MappedFile.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+size_t MappedFile::GetPageSize()
+{
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (size_t)info.dwPageSize;
+#else
+	long pageSize = sysconf(_SC_PAGESIZE);
+	return pageSize > 0 ? (size_t)pageSize : 4096;
+#endif
+}
+
+MappedFile::MappedFile()
+	:m_data(NULL),
+	m_size(0)
+#if defined(_WIN32)
+	, m_file(INVALID_HANDLE_VALUE),
+	m_mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char *path)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void *data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (data == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = (unsigned char*)data;
+	m_size = (size_t)size.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = (unsigned char*)data;
+	m_size = (size_t)st.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data == NULL)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_data);
+	CloseHandle((HANDLE)m_mapping);
+	CloseHandle((HANDLE)m_file);
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+#else
+	munmap(m_data, m_size);
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size)
+{
+	if (m_data == NULL || offset >= m_size || size == 0)
+		return;
+
+	if (size > m_size - offset)
+		size = m_size - offset;
+
+#if defined(_WIN32)
+#if _WIN32_WINNT >= 0x0602
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = m_data + offset;
+	range.NumberOfBytes = size;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+	// the advice works on whole pages
+	static const size_t pageSize = GetPageSize();
+	size_t begin = offset / pageSize * pageSize;
+	madvise(m_data + begin, offset + size - begin, MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::Release(size_t offset, size_t size)
+{
+	if (m_data == NULL || offset >= m_size)
+		return;
+
+	if (size > m_size - offset)
+		size = m_size - offset;
+
+	// whole pages inside the range
+	static const size_t pageSize = GetPageSize();
+	size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+	size_t end = (offset + size) / pageSize * pageSize;
+	if (end <= begin)
+		return;
+
+#if defined(_WIN32)
+	// unlocking pages that are not locked removes them from the working set
+	VirtualUnlock(m_data + begin, end - begin);
+#else
+	madvise(m_data + begin, end - begin, MADV_DONTNEED);
+#endif
+}
+
+void MappedFile::AdviseRandom(size_t offset, size_t size)
+{
+	if (m_data == NULL || offset >= m_size)
+		return;
+
+	if (size > m_size - offset)
+		size = m_size - offset;
+
+#if !defined(_WIN32)
+	static const size_t pageSize = GetPageSize();
+	size_t begin = offset / pageSize * pageSize;
+	madvise(m_data + begin, offset + size - begin, MADV_RANDOM);
+#endif
+}
+
+bool MappedFile::GetFileInfo(const char *path, unsigned long long *size, unsigned long long *time)
+{
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return false;
+
+	if (size)
+		*size = (unsigned long long)st.st_size;
+
+	if (time)
+		*time = (unsigned long long)st.st_mtime;
+
+	return true;
+}
+
+bool MappedFile::IsDirectory(const char *path)
+{
+	struct stat st;
+	return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+bool MappedFile::CreateFolders(const char *path)
+{
+	std::string s = path;
+	for (size_t i = 1; i < s.size(); i++)
+	{
+		if (s[i] != '/' && s[i] != '\\')
+			continue;
+
+		std::string folder = s.substr(0, i);
+		if (IsDirectory(folder.c_str()))
+			continue;
+
+#if defined(_WIN32)
+		_mkdir(folder.c_str());
+#else
+		mkdir(folder.c_str(), 0777);
+#endif
+		if (!IsDirectory(folder.c_str()))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+
+// Read-only view of a file mapped in memory.
+// Pages are copy-on-write so the content can be patched in place (pointer fixup)
+// without touching the file on disk.
+class MappedFile
+{
+protected:
+	unsigned char *m_data;
+	size_t m_size;
+
+#if defined(_WIN32)
+	void *m_file;
+	void *m_mapping;
+#endif
+
+public:
+	MappedFile();
+
+	virtual ~MappedFile();
+
+	bool Open(const char *path);
+
+	void Close();
+
+	unsigned char* GetData()
+	{
+		return m_data;
+	}
+
+	size_t GetSize()
+	{
+		return m_size;
+	}
+
+	bool IsOpen()
+	{
+		return m_data != NULL;
+	}
+
+	// ask the system to read a range ahead of its first access
+	void Prefetch(size_t offset, size_t size);
+
+	// drop the resident pages of a range that was only read, they are paged in again on the next access
+	void Release(size_t offset, size_t size);
+
+	// the range is read in random order: no read-ahead of the pages after the one read
+	void AdviseRandom(size_t offset, size_t size);
+
+	// granularity of the mapped ranges
+	static size_t GetPageSize();
+
+	// size & last modified time of a file, false if it does not exist
+	static bool GetFileInfo(const char *path, unsigned long long *size, unsigned long long *time);
+
+	static bool IsDirectory(const char *path);
+
+	// create the missing parent folders of a file path
+	static bool CreateFolders(const char *path);
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+#include <math.h>
+
+// D3DX style matrix helpers: row vectors, v' = v * M
+
+inline void MatrixIdentity(D3DXMATRIX *out)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+			out->m[i][j] = i == j ? 1.0f : 0.0f;
+	}
+}
+
+inline void MatrixTranslation(D3DXMATRIX *out, float x, float y, float z)
+{
+	MatrixIdentity(out);
+	out->m[3][0] = x;
+	out->m[3][1] = y;
+	out->m[3][2] = z;
+}
+
+inline void MatrixScaling(D3DXMATRIX *out, float x, float y, float z)
+{
+	MatrixIdentity(out);
+	out->m[0][0] = x;
+	out->m[1][1] = y;
+	out->m[2][2] = z;
+}
+
+// out = a * b (out can be a or b)
+inline void MatrixMultiply(D3DXMATRIX *out, const D3DXMATRIX *a, const D3DXMATRIX *b)
+{
+	D3DXMATRIX r;
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			r.m[i][j] = a->m[i][0] * b->m[0][j] +
+				a->m[i][1] * b->m[1][j] +
+				a->m[i][2] * b->m[2][j] +
+				a->m[i][3] * b->m[3][j];
+		}
+	}
+	*out = r;
+}
+
+inline void MatrixTranspose(D3DXMATRIX *out, const D3DXMATRIX *m)
+{
+	D3DXMATRIX r;
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+			r.m[i][j] = m->m[j][i];
+	}
+	*out = r;
+}
+
+// general 4x4 inverse, returns false (and identity) if the matrix is singular
+inline bool MatrixInverse(D3DXMATRIX *out, const D3DXMATRIX *m)
+{
+	const float *a = &m->m[0][0];
+	float inv[16];
+
+	inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+	inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+	inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+	inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+	inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+	inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+	inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+	inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+	inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+	inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+	inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+	inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+	inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+	inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+	inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+	inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+	float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+	if (det == 0.0f)
+	{
+		MatrixIdentity(out);
+		return false;
+	}
+
+	det = 1.0f / det;
+
+	float *o = &out->m[0][0];
+	for (int i = 0; i < 16; i++)
+		o[i] = inv[i] * det;
+
+	return true;
+}
+
+// rotation of a (x, y, z, w) quaternion, zero quaternion is identity
+inline void MatrixRotationQuaternion(D3DXMATRIX *out, const D3DXVECTOR4 *q)
+{
+	float x = q->x, y = q->y, z = q->z, w = q->w;
+
+	float l = sqrtf(x * x + y * y + z * z + w * w);
+	if (l == 0.0f)
+	{
+		MatrixIdentity(out);
+		return;
+	}
+
+	x /= l;
+	y /= l;
+	z /= l;
+	w /= l;
+
+	MatrixIdentity(out);
+	out->m[0][0] = 1.0f - 2.0f * (y * y + z * z);
+	out->m[0][1] = 2.0f * (x * y + z * w);
+	out->m[0][2] = 2.0f * (x * z - y * w);
+	out->m[1][0] = 2.0f * (x * y - z * w);
+	out->m[1][1] = 1.0f - 2.0f * (x * x + z * z);
+	out->m[1][2] = 2.0f * (y * z + x * w);
+	out->m[2][0] = 2.0f * (x * z + y * w);
+	out->m[2][1] = 2.0f * (y * z - x * w);
+	out->m[2][2] = 1.0f - 2.0f * (x * x + y * y);
+}
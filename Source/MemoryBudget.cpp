@@ -0,0 +1,105 @@
+#include "MemoryBudget.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+MemoryBudget::MemoryBudget(UINT64 budget)
+	:m_budget(budget),
+	m_file(NULL),
+	m_bufferStart(0),
+	m_consumed(0),
+	m_numReleases(0),
+	m_blockSize(MappedFile::GetPageSize() > BUDGET_FAULT_SIZE ? MappedFile::GetPageSize() : BUDGET_FAULT_SIZE)
+{
+}
+
+void MemoryBudget::SetInput(MappedFile *file, size_t bufferStart)
+{
+	m_file = file;
+	m_bufferStart = bufferStart;
+	m_consumed = 0;
+
+	size_t numBlocks = file->GetSize() / m_blockSize + 1;
+	m_touched.assign((numBlocks + 63) / 64, 0);
+}
+
+UINT64 MemoryBudget::GetWindowIndices()
+{
+	UINT64 indices = m_budget / 2 / 16 / 3 * 3;
+
+	// the chunks of the writers are 1024 vertices
+	return indices > 3 * 1024 ? indices : 3 * 1024;
+}
+
+void MemoryBudget::Consume(UINT64 bytes)
+{
+	m_consumed += bytes;
+	if (m_consumed >= m_budget / 2)
+		Release();
+}
+
+void MemoryBudget::Touch(const BYTE *data, size_t size)
+{
+	if (m_file == NULL || data < m_file->GetData() + m_bufferStart || data >= m_file->GetData() + m_file->GetSize())
+		return;
+
+	size_t offset = (size_t)(data - m_file->GetData());
+	size_t last = (offset + size - 1) / m_blockSize;
+
+	for (size_t block = offset / m_blockSize; block <= last; block++)
+	{
+		UINT64 bit = 1ULL << (block & 63);
+		if (m_touched[block >> 6] & bit)
+			continue;
+
+		if (m_consumed + m_blockSize > m_budget / 2)
+			Release();
+
+		m_touched[block >> 6] |= bit;
+		m_consumed += m_blockSize;
+	}
+}
+
+void MemoryBudget::AdviseRandom(const BYTE *data, UINT64 size)
+{
+	if (m_file == NULL || data < m_file->GetData() || data >= m_file->GetData() + m_file->GetSize())
+		return;
+
+	m_file->AdviseRandom((size_t)(data - m_file->GetData()), (size_t)size);
+}
+
+void MemoryBudget::Release()
+{
+	if (m_file != NULL && m_file->GetSize() > m_bufferStart)
+	{
+		m_file->Release(m_bufferStart, m_file->GetSize() - m_bufferStart);
+		m_numReleases++;
+	}
+
+	m_consumed = 0;
+	std::fill(m_touched.begin(), m_touched.end(), 0);
+}
+
+UINT64 MemoryBudget::GetPeakMemory()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return (UINT64)counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	// kilobytes
+	return (UINT64)usage.ru_maxrss * 1024;
+#endif
+}
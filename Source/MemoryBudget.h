@@ -0,0 +1,67 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "MappedFile.h"
+
+#include <vector>
+
+// a page fault maps the pages around the one read (Linux fault-around, Windows clustering):
+// the vertex reads are counted in blocks of this size
+#define BUDGET_FAULT_SIZE (64 * 1024)
+
+// Peak memory of a streamed conversion (-budget MB). The input is mapped instead of read and
+// its pages are released once the resident ones reach half of the budget: the writers report
+// the index bytes they read in order, the decoders each vertex before they read it (the fault
+// blocks it lands in that were not touched since the last release are counted). Large subsets
+// are written in index windows sized from the other half.
+class MemoryBudget
+{
+protected:
+	UINT64 m_budget;
+
+	MappedFile *m_file;
+	size_t m_bufferStart;
+
+	// input bytes resident since the last release
+	UINT64 m_consumed;
+	UINT m_numReleases;
+
+	// fault blocks of the input touched since the last release, one bit per block
+	std::vector<UINT64> m_touched;
+	size_t m_blockSize;
+
+public:
+	MemoryBudget(UINT64 budget);
+
+	// the mapped input, its buffer data (vertices & indices) starts at bufferStart
+	void SetInput(MappedFile *file, size_t bufferStart);
+
+	UINT64 GetBudget()
+	{
+		return m_budget;
+	}
+
+	// indices of a subset window: remap, lookup & decode scratch of about 16 bytes per index
+	UINT64 GetWindowIndices();
+
+	// bytes of the input a writer read in order (index buffers)
+	void Consume(UINT64 bytes);
+
+	// a vertex about to be read in random order, the input is released first when its new blocks
+	// would exceed half of the budget
+	void Touch(const BYTE *data, size_t size);
+
+	// a vertex buffer of the mapped input, read in random order
+	void AdviseRandom(const BYTE *data, UINT64 size);
+
+	// release the buffer data pages of the input
+	void Release();
+
+	UINT GetNumReleases()
+	{
+		return m_numReleases;
+	}
+
+	// peak resident memory of the process, 0 if unknown
+	static UINT64 GetPeakMemory();
+};
@@ -0,0 +1,316 @@
+#include "MeshBounds.h"
+#include "ParallelFor.h"
+#include "JSONWriter.h"
+#include "Log.h"
+
+#include <math.h>
+#include <float.h>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BOUNDS_SSE
+#include <xmmintrin.h>
+#endif
+
+MeshBounds::MeshBounds(SDKMesh *mesh)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_transform(NULL),
+	m_spheres(false)
+{
+}
+
+MeshBounds::~MeshBounds()
+{
+}
+
+void MeshBounds::ComputeAABB(const float *positions, size_t count, float *min, float *max)
+{
+	size_t i = 0;
+
+	for (int j = 0; j < 3; j++)
+		min[j] = max[j] = positions[j];
+
+#ifdef BOUNDS_SSE
+	if (count >= 4)
+	{
+		// 4 vertices = 3 registers: (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3)
+		__m128 minA = _mm_loadu_ps(positions);
+		__m128 minB = _mm_loadu_ps(positions + 4);
+		__m128 minC = _mm_loadu_ps(positions + 8);
+		__m128 maxA = minA, maxB = minB, maxC = minC;
+
+		for (i = 4; i + 4 <= count; i += 4)
+		{
+			const float *p = positions + i * 3;
+			__m128 a = _mm_loadu_ps(p);
+			__m128 b = _mm_loadu_ps(p + 4);
+			__m128 c = _mm_loadu_ps(p + 8);
+
+			minA = _mm_min_ps(minA, a);
+			minB = _mm_min_ps(minB, b);
+			minC = _mm_min_ps(minC, c);
+			maxA = _mm_max_ps(maxA, a);
+			maxB = _mm_max_ps(maxB, b);
+			maxC = _mm_max_ps(maxC, c);
+		}
+
+		float lo[12], hi[12];
+		_mm_storeu_ps(lo, minA);
+		_mm_storeu_ps(lo + 4, minB);
+		_mm_storeu_ps(lo + 8, minC);
+		_mm_storeu_ps(hi, maxA);
+		_mm_storeu_ps(hi + 4, maxB);
+		_mm_storeu_ps(hi + 8, maxC);
+
+		// lane k holds component k % 3
+		for (int k = 0; k < 12; k++)
+		{
+			if (lo[k] < min[k % 3])
+				min[k % 3] = lo[k];
+			if (hi[k] > max[k % 3])
+				max[k % 3] = hi[k];
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float *p = positions + i * 3;
+		for (int j = 0; j < 3; j++)
+		{
+			if (p[j] < min[j])
+				min[j] = p[j];
+			if (p[j] > max[j])
+				max[j] = p[j];
+		}
+	}
+}
+
+float MeshBounds::ComputeRadius(const float *positions, size_t count, const float *center)
+{
+	float r2 = 0.0f;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const float *p = positions + i * 3;
+		float dx = p[0] - center[0];
+		float dy = p[1] - center[1];
+		float dz = p[2] - center[2];
+		float d2 = dx * dx + dy * dy + dz * dz;
+		if (d2 > r2)
+			r2 = d2;
+	}
+
+	return sqrtf(r2);
+}
+
+static void ResetVolume(BoundingVolume& v)
+{
+	memset(&v, 0, sizeof(BoundingVolume));
+}
+
+static void SetCenter(BoundingVolume& v)
+{
+	for (int j = 0; j < 3; j++)
+		v.Center[j] = (v.Min[j] + v.Max[j]) * 0.5f;
+}
+
+bool MeshBounds::Compute(int numThreads)
+{
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+
+	m_meshes.resize(numMeshes);
+	m_subsets.resize(numMeshes);
+	m_stale.assign(numMeshes, 0);
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	ParallelFor(numMeshes, numThreads, [&](size_t meshIdx, int)
+	{
+		ComputeMesh((UINT)meshIdx);
+	});
+
+	return true;
+}
+
+void MeshBounds::ComputeMesh(UINT meshID)
+{
+	SubsetDecoder decoder(m_sdkMesh, meshID, m_processor);
+	decoder.SetTransform(m_transform);
+
+	UINT numSubsets = m_sdkMesh->GetNumSubsets(meshID);
+	std::vector<BoundingVolume>& subsets = m_subsets[meshID];
+	subsets.resize(numSubsets);
+
+	BoundingVolume& mesh = m_meshes[meshID];
+	ResetVolume(mesh);
+
+	// decoded positions are kept for the mesh sphere
+	std::vector<std::vector<float> > positions(numSubsets);
+	SubsetRemap remap;
+
+	for (UINT i = 0; i < numSubsets; ++i)
+	{
+		BoundingVolume& v = subsets[i];
+		ResetVolume(v);
+
+		if (!decoder.Remap(m_sdkMesh->GetSubset(meshID, i), remap) || remap.Vertices.empty())
+			continue;
+
+		UINT count = (UINT)remap.Vertices.size();
+		positions[i].resize((size_t)count * 3);
+		if (!decoder.DecodePositions(remap.Vertices.data(), count, positions[i].data()))
+		{
+			positions[i].clear();
+			continue;
+		}
+
+		ComputeAABB(positions[i].data(), count, v.Min, v.Max);
+		SetCenter(v);
+		v.NumVertices = count;
+
+		if (m_spheres)
+			v.Radius = ComputeRadius(positions[i].data(), count, v.Center);
+
+		// union
+		for (int j = 0; j < 3; j++)
+		{
+			if (mesh.NumVertices == 0 || v.Min[j] < mesh.Min[j])
+				mesh.Min[j] = v.Min[j];
+			if (mesh.NumVertices == 0 || v.Max[j] > mesh.Max[j])
+				mesh.Max[j] = v.Max[j];
+		}
+		mesh.NumVertices += count;
+	}
+
+	SetCenter(mesh);
+
+	if (m_spheres)
+	{
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			float r = ComputeRadius(positions[i].data(), positions[i].size() / 3, mesh.Center);
+			if (r > mesh.Radius)
+				mesh.Radius = r;
+		}
+	}
+
+	if (m_transform != NULL)
+		return;
+
+	// stored bounds, relative tolerance on the mesh size
+	SDKMESH_MESH *sdkMesh = m_sdkMesh->GetMesh(meshID);
+	const float *storedCenter = &sdkMesh->BoundingBoxCenter.x;
+	const float *storedExtents = &sdkMesh->BoundingBoxExtents.x;
+
+	float size = 0.0f;
+	for (int j = 0; j < 3; j++)
+	{
+		float e = (mesh.Max[j] - mesh.Min[j]) * 0.5f;
+		if (e > size)
+			size = e;
+	}
+
+	float tolerance = 1e-3f * size + 1e-6f;
+
+	for (int j = 0; j < 3; j++)
+	{
+		float e = (mesh.Max[j] - mesh.Min[j]) * 0.5f;
+		if (fabsf(storedCenter[j] - mesh.Center[j]) > tolerance || fabsf(storedExtents[j] - e) > tolerance)
+			m_stale[meshID] = 1;
+	}
+}
+
+UINT MeshBounds::GetNumStale()
+{
+	UINT n = 0;
+	for (size_t i = 0; i < m_stale.size(); i++)
+		n += m_stale[i];
+	return n;
+}
+
+void MeshBounds::PrintStats()
+{
+	LogDebug() << "\n# Bounds:\n";
+
+	for (size_t meshIdx = 0; meshIdx < m_meshes.size(); ++meshIdx)
+	{
+		const BoundingVolume& v = m_meshes[meshIdx];
+		SDKMESH_MESH *mesh = m_sdkMesh->GetMesh((UINT)meshIdx);
+
+		LogDebug() << " Mesh " << meshIdx << " " << mesh->Name << ": min (" << v.Min[0] << ", " << v.Min[1] << ", " << v.Min[2] << ")"
+			<< " max (" << v.Max[0] << ", " << v.Max[1] << ", " << v.Max[2] << ")";
+
+		if (m_spheres)
+			LogDebug() << " radius " << v.Radius;
+
+		if (m_stale[meshIdx])
+		{
+			LogDebug() << " - stale stored bounds: center (" << mesh->BoundingBoxCenter.x << ", " << mesh->BoundingBoxCenter.y << ", " << mesh->BoundingBoxCenter.z << ")"
+				<< " extents (" << mesh->BoundingBoxExtents.x << ", " << mesh->BoundingBoxExtents.y << ", " << mesh->BoundingBoxExtents.z << ")";
+		}
+
+		LogDebug() << "\n";
+	}
+}
+
+static void WriteVolume(JSONWriter& json, const BoundingVolume& v, bool spheres)
+{
+	json.Write("vertices", (unsigned long long)v.NumVertices);
+	json.Write("min", v.Min, 3);
+	json.Write("max", v.Max, 3);
+
+	if (spheres)
+	{
+		json.Write("center", v.Center, 3);
+		json.Write("radius", (double)v.Radius);
+	}
+}
+
+bool MeshBounds::WriteMetadata(const char *path, const char *source)
+{
+	remove(path);
+	FILE *file = fopen(path, "wt");
+	if (file == NULL)
+		return false;
+
+	JSONWriter json(file);
+	json.BeginObject();
+	json.Write("source", source);
+	json.BeginArray("meshes");
+
+	for (size_t meshIdx = 0; meshIdx < m_meshes.size(); ++meshIdx)
+	{
+		SDKMESH_MESH *mesh = m_sdkMesh->GetMesh((UINT)meshIdx);
+
+		json.BeginObject();
+		json.Write("name", mesh->Name);
+		WriteVolume(json, m_meshes[meshIdx], m_spheres);
+
+		json.Write("stale", m_stale[meshIdx] != 0);
+		json.Write("storedCenter", &mesh->BoundingBoxCenter.x, 3);
+		json.Write("storedExtents", &mesh->BoundingBoxExtents.x, 3);
+
+		json.BeginArray("subsets");
+		for (size_t i = 0; i < m_subsets[meshIdx].size(); ++i)
+		{
+			json.BeginObject();
+			json.Write("name", m_sdkMesh->GetSubset((UINT)meshIdx, (UINT)i)->Name);
+			WriteVolume(json, m_subsets[meshIdx][i], m_spheres);
+			json.EndObject();
+		}
+		json.EndArray();
+
+		json.EndObject();
+	}
+
+	json.EndArray();
+	json.EndObject();
+	json.Finish();
+
+	bool success = ferror(file) == 0;
+	fclose(file);
+	return success;
+}
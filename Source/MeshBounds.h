@@ -0,0 +1,90 @@
+#pragma once
+
+#include "SubsetDecoder.h"
+#include "VertexTransform.h"
+
+struct BoundingVolume
+{
+	float Min[3];
+	float Max[3];
+
+	// sphere around the box center (Radius is 0 when spheres are not computed)
+	float Center[3];
+	float Radius;
+
+	UINT64 NumVertices;
+};
+
+// Exact per-subset and per-mesh bounds of the decoded (written) positions,
+// checked against the bounds stored in SDKMESH_MESH
+class MeshBounds
+{
+protected:
+	SDKMesh *m_sdkMesh;
+	MeshProcessor *m_processor;
+
+	// bounds of the converted positions (not owned), NULL: source space
+	const VertexTransform *m_transform;
+
+	bool m_spheres;
+
+	std::vector<BoundingVolume> m_meshes;
+	std::vector<std::vector<BoundingVolume> > m_subsets;
+	std::vector<BYTE> m_stale;
+
+public:
+	MeshBounds(SDKMesh *mesh);
+
+	virtual ~MeshBounds();
+
+	void SetProcessor(MeshProcessor *processor)
+	{
+		m_processor = processor;
+	}
+
+	// the stored bounds are in the source space: not checked with a transform
+	void SetTransform(const VertexTransform *transform)
+	{
+		m_transform = transform;
+	}
+
+	void SetSpheres(bool b)
+	{
+		m_spheres = b;
+	}
+
+	// meshes are computed in parallel
+	bool Compute(int numThreads);
+
+	const BoundingVolume& GetMeshBounds(UINT meshID)
+	{
+		return m_meshes[meshID];
+	}
+
+	const BoundingVolume& GetSubsetBounds(UINT meshID, UINT subsetID)
+	{
+		return m_subsets[meshID][subsetID];
+	}
+
+	// the stored BoundingBoxCenter/BoundingBoxExtents do not match the vertices
+	bool IsStale(UINT meshID)
+	{
+		return m_stale[meshID] != 0;
+	}
+
+	UINT GetNumStale();
+
+	void PrintStats();
+
+	// sidecar JSON metadata
+	bool WriteMetadata(const char *path, const char *source);
+
+	// min/max of packed float3 positions (SIMD when available), count > 0
+	static void ComputeAABB(const float *positions, size_t count, float *min, float *max);
+
+	// max distance to center
+	static float ComputeRadius(const float *positions, size_t count, const float *center);
+
+protected:
+	void ComputeMesh(UINT meshID);
+};
@@ -0,0 +1,305 @@
+#include "MeshCache.h"
+#include "SubsetDecoder.h"
+#include "ChunkWriter.h"
+
+// vertices decoded per chunk
+#define MESHCACHE_CHUNK_VERTICES 1024
+
+static UINT64 AlignOffset(UINT64 offset)
+{
+	return (offset + MESHCACHE_ALIGNMENT - 1) / MESHCACHE_ALIGNMENT * MESHCACHE_ALIGNMENT;
+}
+
+static void WritePadding(ChunkWriter& out, UINT64& offset, UINT64 alignedOffset)
+{
+	static const BYTE zero[MESHCACHE_ALIGNMENT] = { 0 };
+	out.Write(zero, (size_t)(alignedOffset - offset));
+	offset = alignedOffset;
+}
+
+MeshCache::MeshCache()
+	:m_header(NULL),
+	m_meshes(NULL),
+	m_subsets(NULL)
+{
+}
+
+MeshCache::~MeshCache()
+{
+	Close();
+}
+
+bool MeshCache::Open(const char *path, const char *source)
+{
+	Close();
+
+	unsigned long long sourceSize, sourceTime;
+	if (!MappedFile::GetFileInfo(source, &sourceSize, &sourceTime))
+		return false;
+
+	if (!m_file.Open(path))
+		return false;
+
+	UINT64 fileSize = m_file.GetSize();
+	MESHCACHE_HEADER *header = (MESHCACHE_HEADER*)m_file.GetData();
+
+	bool valid = fileSize >= sizeof(MESHCACHE_HEADER) &&
+		header->Magic == MESHCACHE_MAGIC &&
+		header->Version == MESHCACHE_VERSION &&
+		header->SourceSize == sourceSize &&
+		header->SourceTime == sourceTime;
+
+	for (int i = 0; valid && i < MCS_COUNT; i++)
+	{
+		const MESHCACHE_SECTION& section = header->Sections[i];
+		if (section.Offset % MESHCACHE_ALIGNMENT != 0 ||
+			section.Offset > fileSize ||
+			section.SizeBytes > fileSize - section.Offset)
+			valid = false;
+	}
+
+	if (valid &&
+		(header->Sections[MCS_MESHES].SizeBytes != (UINT64)header->NumMeshes * sizeof(MESHCACHE_MESH) ||
+		header->Sections[MCS_SUBSETS].SizeBytes != (UINT64)header->NumEntries * sizeof(MESHCACHE_SUBSET)))
+		valid = false;
+
+	if (!valid)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	m_header = header;
+	m_meshes = (MESHCACHE_MESH*)GetSection(MCS_MESHES);
+	m_subsets = (MESHCACHE_SUBSET*)GetSection(MCS_SUBSETS);
+	return true;
+}
+
+void MeshCache::Close()
+{
+	m_file.Close();
+	m_header = NULL;
+	m_meshes = NULL;
+	m_subsets = NULL;
+}
+
+BYTE* MeshCache::GetSDKMeshData(UINT64 *size)
+{
+	if (size)
+		*size = m_header->Sections[MCS_SDKMESH_HEADERS].SizeBytes;
+	return GetSection(MCS_SDKMESH_HEADERS);
+}
+
+void MeshCache::Prefetch(UINT flags)
+{
+	if (m_header == NULL)
+		return;
+
+	MESHCACHE_SECTION_TYPE sections[] = { MCS_POSITIONS, MCS_INDICES, MCS_NORMALS, MCS_TEXCOORDS, MCS_COLORS };
+	UINT required[] = { 0, 0, MCF_NORMAL, MCF_TEXCOORD, MCF_COLOR };
+
+	for (int i = 0; i < 5; i++)
+	{
+		if ((required[i] & flags) != required[i])
+			continue;
+
+		const MESHCACHE_SECTION& section = m_header->Sections[sections[i]];
+		m_file.Prefetch((size_t)section.Offset, (size_t)section.SizeBytes);
+	}
+}
+
+bool MeshCache::Write(SDKMesh *mesh, const char *source, const char *output)
+{
+	unsigned long long sourceSize, sourceTime;
+	if (!MappedFile::GetFileInfo(source, &sourceSize, &sourceTime))
+		return false;
+
+	UINT numMeshes = mesh->GetNumMeshes();
+
+	// pass 1: remap every subset to count the stream sizes
+	std::vector<MESHCACHE_MESH> meshes(numMeshes);
+	std::vector<MESHCACHE_SUBSET> subsets;
+
+	SubsetRemap remap;
+	UINT64 numVertices = 0;
+	UINT64 numIndices = 0;
+	UINT flags = 0;
+
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SubsetDecoder decoder(mesh, meshIdx);
+		if (!decoder.HasPosition())
+			return false;
+
+		meshes[meshIdx].FirstEntry = (UINT)subsets.size();
+		meshes[meshIdx].Flags = 0;
+		if (decoder.HasNormal())
+			meshes[meshIdx].Flags |= MCF_NORMAL;
+		if (decoder.HasTexcoord())
+			meshes[meshIdx].Flags |= MCF_TEXCOORD;
+		if (decoder.HasColor())
+			meshes[meshIdx].Flags |= MCF_COLOR;
+		flags |= meshes[meshIdx].Flags;
+
+		UINT numSubsets = mesh->GetNumSubsets(meshIdx);
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			if (!decoder.Remap(mesh->GetSubset(meshIdx, i), remap))
+				return false;
+
+			MESHCACHE_SUBSET entry;
+			entry.FirstVertex = numVertices;
+			entry.NumVertices = remap.Vertices.size();
+			entry.FirstIndex = numIndices;
+			entry.NumIndices = remap.Indices.size();
+			subsets.push_back(entry);
+
+			numVertices += entry.NumVertices;
+			numIndices += entry.NumIndices;
+		}
+	}
+
+	// copy of the sdkmesh headers with the fixed up pointers turned back to offsets
+	SDKMESH_HEADER *sdkHeader = mesh->GetHeader();
+	BYTE *sdkData = (BYTE*)sdkHeader;
+	UINT64 sdkSize = sdkHeader->HeaderSize + sdkHeader->NonBufferDataSize;
+
+	std::vector<BYTE> headers(sdkData, sdkData + sdkSize);
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SDKMESH_MESH *src = mesh->GetMesh(meshIdx);
+		SDKMESH_MESH *dst = (SDKMESH_MESH*)(headers.data() + ((BYTE*)src - sdkData));
+		dst->SubsetOffset = (UINT64)((BYTE*)src->pSubsets - sdkData);
+		dst->FrameInfluenceOffset = (UINT64)((BYTE*)src->pFrameInfluences - sdkData);
+	}
+
+	// section table
+	MESHCACHE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.Magic = MESHCACHE_MAGIC;
+	header.Version = MESHCACHE_VERSION;
+	header.SourceSize = sourceSize;
+	header.SourceTime = sourceTime;
+	header.NumMeshes = numMeshes;
+	header.NumEntries = (UINT)subsets.size();
+
+	UINT64 sectionSize[MCS_COUNT];
+	sectionSize[MCS_SDKMESH_HEADERS] = sdkSize;
+	sectionSize[MCS_MESHES] = numMeshes * sizeof(MESHCACHE_MESH);
+	sectionSize[MCS_SUBSETS] = subsets.size() * sizeof(MESHCACHE_SUBSET);
+	sectionSize[MCS_POSITIONS] = numVertices * sizeof(float) * 3;
+	sectionSize[MCS_NORMALS] = (flags & MCF_NORMAL) ? numVertices * sizeof(float) * 3 : 0;
+	sectionSize[MCS_TEXCOORDS] = (flags & MCF_TEXCOORD) ? numVertices * sizeof(float) * 2 : 0;
+	sectionSize[MCS_COLORS] = (flags & MCF_COLOR) ? numVertices * 4 : 0;
+	sectionSize[MCS_INDICES] = numIndices * sizeof(UINT);
+
+	UINT64 offset = AlignOffset(sizeof(MESHCACHE_HEADER));
+	for (int i = 0; i < MCS_COUNT; i++)
+	{
+		header.Sections[i].Offset = offset;
+		header.Sections[i].SizeBytes = sectionSize[i];
+		offset = AlignOffset(offset + sectionSize[i]);
+	}
+
+	FILE *file = fopen(output, "wb");
+	if (file == NULL)
+		return false;
+
+	bool success = true;
+	{
+		ChunkWriter out(file);
+
+		offset = 0;
+		out.Write(&header, sizeof(header));
+		offset += sizeof(header);
+
+		WritePadding(out, offset, header.Sections[MCS_SDKMESH_HEADERS].Offset);
+		out.Write(headers.data(), headers.size());
+		offset += headers.size();
+
+		WritePadding(out, offset, header.Sections[MCS_MESHES].Offset);
+		out.Write(meshes.data(), (size_t)sectionSize[MCS_MESHES]);
+		offset += sectionSize[MCS_MESHES];
+
+		WritePadding(out, offset, header.Sections[MCS_SUBSETS].Offset);
+		out.Write(subsets.data(), (size_t)sectionSize[MCS_SUBSETS]);
+		offset += sectionSize[MCS_SUBSETS];
+
+		float f[MESHCACHE_CHUNK_VERTICES * 4];
+		BYTE rgba[MESHCACHE_CHUNK_VERTICES * 4];
+
+		// pass 2: one pass per stream so each one is contiguous
+		for (int section = MCS_POSITIONS; section < MCS_COUNT; section++)
+		{
+			if (sectionSize[section] == 0)
+				continue;
+
+			WritePadding(out, offset, header.Sections[section].Offset);
+			offset += sectionSize[section];
+
+			for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+			{
+				SubsetDecoder decoder(mesh, meshIdx);
+
+				UINT numSubsets = mesh->GetNumSubsets(meshIdx);
+				for (UINT i = 0; i < numSubsets; ++i)
+				{
+					decoder.Remap(mesh->GetSubset(meshIdx, i), remap);
+
+					if (section == MCS_INDICES)
+					{
+						out.Write(remap.Indices.data(), remap.Indices.size() * sizeof(UINT));
+						continue;
+					}
+
+					for (UINT begin = 0, n = (UINT)remap.Vertices.size(); begin < n; begin += MESHCACHE_CHUNK_VERTICES)
+					{
+						UINT count = n - begin < MESHCACHE_CHUNK_VERTICES ? n - begin : MESHCACHE_CHUNK_VERTICES;
+						const UINT *chunk = remap.Vertices.data() + begin;
+
+						switch (section)
+						{
+						case MCS_POSITIONS:
+							decoder.DecodePositions(chunk, count, f);
+							out.Write(f, count * sizeof(float) * 3);
+							break;
+						case MCS_NORMALS:
+							if (!decoder.DecodeNormals(chunk, count, f))
+								memset(f, 0, count * sizeof(float) * 3);
+							out.Write(f, count * sizeof(float) * 3);
+							break;
+						case MCS_TEXCOORDS:
+							if (!decoder.DecodeTexcoords(chunk, count, f))
+								memset(f, 0, count * sizeof(float) * 2);
+							out.Write(f, count * sizeof(float) * 2);
+							break;
+						case MCS_COLORS:
+							if (!decoder.DecodeColors(chunk, count, f))
+							{
+								for (UINT j = 0; j < count * 4; j++)
+									f[j] = 1.0f;
+							}
+							for (UINT j = 0; j < count * 4; j++)
+							{
+								float c = f[j] < 0.0f ? 0.0f : (f[j] > 1.0f ? 1.0f : f[j]);
+								rgba[j] = (BYTE)(c * 255.0f + 0.5f);
+							}
+							out.Write(rgba, count * 4);
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		out.Flush();
+		success = !out.HasError();
+	}
+
+	fclose(file);
+
+	if (!success)
+		remove(output);
+
+	return success;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "MappedFile.h"
+
+//--------------------------------------------------------------------------------------
+// Converted mesh cache (.meshcache)
+// A native little-endian file that is mapped in memory and used without parsing:
+// - the sdkmesh header & non-buffer data (meshes, subsets, frames, materials) verbatim
+// - decoded vertex streams, each one a contiguous array shared by all subsets
+//   positions: float3, normals: float3, texcoords: float2 (V flipped), colors: RGBA8
+// - per-subset triangle lists remapped to the subset vertices
+// Sections start at MESHCACHE_ALIGNMENT, the header holds the offset table.
+//--------------------------------------------------------------------------------------
+#define MESHCACHE_MAGIC 0x48434D53	// 'SMCH'
+#define MESHCACHE_VERSION 1
+#define MESHCACHE_ALIGNMENT 64
+
+enum MESHCACHE_SECTION_TYPE
+{
+	MCS_SDKMESH_HEADERS = 0,
+	MCS_MESHES,
+	MCS_SUBSETS,
+	MCS_POSITIONS,
+	MCS_NORMALS,
+	MCS_TEXCOORDS,
+	MCS_COLORS,
+	MCS_INDICES,
+	MCS_COUNT,
+};
+
+enum MESHCACHE_STREAM_FLAG
+{
+	MCF_NORMAL = 1,
+	MCF_TEXCOORD = 2,
+	MCF_COLOR = 4,
+};
+
+struct MESHCACHE_SECTION
+{
+	UINT64 Offset;
+	UINT64 SizeBytes;
+};
+
+struct MESHCACHE_HEADER
+{
+	UINT Magic;
+	UINT Version;
+
+	// the source sdkmesh this cache was built from
+	UINT64 SourceSize;
+	UINT64 SourceTime;
+
+	UINT NumMeshes;
+	UINT NumEntries;
+
+	MESHCACHE_SECTION Sections[MCS_COUNT];
+};
+
+struct MESHCACHE_MESH
+{
+	UINT FirstEntry;
+	UINT Flags;
+};
+
+// one per (mesh, subset), in mesh then subset order
+struct MESHCACHE_SUBSET
+{
+	UINT64 FirstVertex;
+	UINT64 NumVertices;
+	UINT64 FirstIndex;
+	UINT64 NumIndices;
+};
+
+class MeshCache
+{
+protected:
+	MappedFile m_file;
+
+	MESHCACHE_HEADER *m_header;
+	MESHCACHE_MESH *m_meshes;
+	MESHCACHE_SUBSET *m_subsets;
+
+public:
+	MeshCache();
+
+	virtual ~MeshCache();
+
+	// map a cache file, fails if it is not built from the current 'source'
+	bool Open(const char *path, const char *source);
+
+	void Close();
+
+	// decode all subsets of the loaded sdkmesh and write the cache file
+	static bool Write(SDKMesh *mesh, const char *source, const char *output);
+
+	BYTE* GetSDKMeshData(UINT64 *size);
+
+	// read ahead the positions, the indices and the MESHCACHE_STREAM_FLAG streams in 'flags',
+	// the other streams are left on disk
+	void Prefetch(UINT flags);
+
+	UINT GetNumMeshes()
+	{
+		return m_header->NumMeshes;
+	}
+
+	const MESHCACHE_MESH* GetMesh(UINT iMesh)
+	{
+		return &m_meshes[iMesh];
+	}
+
+	const MESHCACHE_SUBSET* GetSubset(UINT iMesh, UINT iSubset)
+	{
+		return &m_subsets[m_meshes[iMesh].FirstEntry + iSubset];
+	}
+
+	const float* GetPositions()
+	{
+		return (const float*)GetSection(MCS_POSITIONS);
+	}
+
+	const float* GetNormals()
+	{
+		return (const float*)GetSection(MCS_NORMALS);
+	}
+
+	const float* GetTexcoords()
+	{
+		return (const float*)GetSection(MCS_TEXCOORDS);
+	}
+
+	const BYTE* GetColors()
+	{
+		return (const BYTE*)GetSection(MCS_COLORS);
+	}
+
+	const UINT* GetIndices()
+	{
+		return (const UINT*)GetSection(MCS_INDICES);
+	}
+
+protected:
+	BYTE* GetSection(MESHCACHE_SECTION_TYPE type)
+	{
+		return m_file.GetData() + m_header->Sections[type].Offset;
+	}
+};
@@ -0,0 +1,376 @@
+#include "MeshFilter.h"
+#include "MeshManifest.h"
+#include "BatchConverter.h"
+#include "FileReader.h"
+#include "CStringImp.h"
+#include "Log.h"
+
+#include <string.h>
+
+// buffers are placed in the read data on 16 bytes
+static UINT64 AlignSize(UINT64 size)
+{
+	return (size + 15) & ~(UINT64)15;
+}
+
+MeshFilter::MeshFilter()
+	:m_hasSelect(false),
+	m_numMeshes(0),
+	m_numSubsets(0),
+	m_bytesRead(0),
+	m_fileSize(0)
+{
+}
+
+MeshFilter::~MeshFilter()
+{
+}
+
+bool MeshFilter::Add(const char *patterns, bool exclude)
+{
+	std::vector<std::string> items;
+	Skylicht::CStringImp::splitString(patterns, ",", items);
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		const std::string& item = items[i];
+		if (item.empty())
+			continue;
+
+		FilterPattern pattern;
+		pattern.Kind = FK_MESH;
+		pattern.Exclude = exclude;
+		pattern.Glob = item;
+
+		size_t colon = item.find(':');
+		if (colon != std::string::npos)
+		{
+			std::string kind = item.substr(0, colon);
+			if (kind == "mesh")
+				pattern.Kind = FK_MESH;
+			else if (kind == "subset")
+				pattern.Kind = FK_SUBSET;
+			else if (kind == "material")
+				pattern.Kind = FK_MATERIAL;
+			else if (kind == "frame")
+				pattern.Kind = FK_FRAME;
+			else
+				return false;
+
+			pattern.Glob = item.substr(colon + 1);
+		}
+
+		m_patterns.push_back(pattern);
+		if (!exclude)
+			m_hasSelect = true;
+	}
+
+	return true;
+}
+
+bool MeshFilter::MatchName(const std::string& glob, const char *name, size_t size)
+{
+	char text[MAX_PATH];
+	size_t length = 0;
+	while (length < size && length < MAX_PATH - 1 && name[length] != 0)
+		length++;
+
+	memcpy(text, name, length);
+	text[length] = 0;
+
+	return BatchConverter::MatchWildcard(glob.c_str(), text);
+}
+
+void MeshFilter::MatchFrames(SDKMesh *sdkMesh, ArenaArray<BYTE>& frames)
+{
+	UINT numMeshes = sdkMesh->GetNumMeshes();
+	UINT numFrames = sdkMesh->GetNumFrames();
+
+	frames.Resize(numMeshes);
+	for (UINT i = 0; i < numMeshes; i++)
+		frames[i] = 0;
+
+	for (UINT frameIdx = 0; frameIdx < numFrames; frameIdx++)
+	{
+		UINT meshIdx = sdkMesh->GetFrame(frameIdx)->Mesh;
+		if (meshIdx >= numMeshes)
+			continue;
+
+		// the frame then its parents, a looping hierarchy stops after numFrames steps
+		UINT parent = frameIdx;
+		for (UINT step = 0; step < numFrames && parent < numFrames; step++)
+		{
+			SDKMESH_FRAME *frame = sdkMesh->GetFrame(parent);
+
+			for (size_t i = 0; i < m_patterns.size(); i++)
+			{
+				const FilterPattern& pattern = m_patterns[i];
+				if (pattern.Kind == FK_FRAME && MatchName(pattern.Glob, frame->Name, MAX_FRAME_NAME))
+					frames[meshIdx] |= pattern.Exclude ? 2 : 1;
+			}
+
+			parent = frame->ParentFrame;
+		}
+	}
+}
+
+bool MeshFilter::IsSelected(SDKMESH_MESH *mesh, SDKMESH_SUBSET *subset, SDKMESH_MATERIAL *material, BYTE frames)
+{
+	bool selected = !m_hasSelect;
+
+	for (size_t i = 0; i < m_patterns.size(); i++)
+	{
+		const FilterPattern& pattern = m_patterns[i];
+
+		bool match = false;
+		switch (pattern.Kind)
+		{
+		case FK_MESH:
+			match = MatchName(pattern.Glob, mesh->Name, MAX_MESH_NAME);
+			break;
+		case FK_SUBSET:
+			match = MatchName(pattern.Glob, subset->Name, MAX_SUBSET_NAME);
+			break;
+		case FK_MATERIAL:
+			match = material != NULL && MatchName(pattern.Glob, material->Name, MAX_MATERIAL_NAME);
+			break;
+		case FK_FRAME:
+			match = (frames & (pattern.Exclude ? 2 : 1)) != 0;
+			break;
+		}
+
+		if (!match)
+			continue;
+
+		if (pattern.Exclude)
+			return false;
+
+		selected = true;
+	}
+
+	return selected;
+}
+
+UINT MeshFilter::Apply(SDKMesh *sdkMesh)
+{
+	SDKMESH_HEADER *header = sdkMesh->GetHeader();
+	BYTE *data = (BYTE*)header;
+
+	SDKMESH_SUBSET *subsets = (SDKMESH_SUBSET*)(data + header->SubsetDataOffset);
+	UINT numMeshes = header->NumMeshes;
+	UINT numMaterials = header->NumMaterials;
+	UINT numSubsets = header->NumTotalSubsets;
+
+	ArenaArray<BYTE> frames;
+	MatchFrames(sdkMesh, frames);
+
+	ArenaArray<UINT> meshMap;
+	meshMap.Resize(numMeshes);
+
+	ArenaArray<BYTE> subsetKept;
+	subsetKept.Resize(numSubsets);
+	for (UINT i = 0; i < numSubsets; i++)
+		subsetKept[i] = 0;
+
+	// the subset lists are compacted in place, then the meshes
+	m_numMeshes = 0;
+	m_numSubsets = 0;
+
+	for (UINT meshIdx = 0; meshIdx < numMeshes; meshIdx++)
+	{
+		SDKMESH_MESH *mesh = sdkMesh->GetMesh(meshIdx);
+
+		UINT numKept = 0;
+		for (UINT i = 0; i < mesh->NumSubsets; i++)
+		{
+			UINT subsetIdx = mesh->pSubsets[i];
+			SDKMESH_SUBSET *subset = &subsets[subsetIdx];
+			SDKMESH_MATERIAL *material = subset->MaterialID < numMaterials ? sdkMesh->GetMaterial(subset->MaterialID) : NULL;
+
+			if (!IsSelected(mesh, subset, material, frames[meshIdx]))
+				continue;
+
+			mesh->pSubsets[numKept++] = subsetIdx;
+			subsetKept[subsetIdx] = 1;
+		}
+
+		mesh->NumSubsets = numKept;
+		m_numSubsets += numKept;
+
+		if (numKept == 0)
+		{
+			meshMap[meshIdx] = INVALID_MESH;
+			continue;
+		}
+
+		if (m_numMeshes != meshIdx)
+			*sdkMesh->GetMesh(m_numMeshes) = *mesh;
+
+		meshMap[meshIdx] = m_numMeshes++;
+	}
+
+	header->NumMeshes = m_numMeshes;
+
+	for (UINT i = 0; i < sdkMesh->GetNumFrames(); i++)
+	{
+		SDKMESH_FRAME *frame = sdkMesh->GetFrame(i);
+		if (frame->Mesh < numMeshes)
+			frame->Mesh = meshMap[frame->Mesh];
+	}
+
+	// the materials of the kept subsets, in their order
+	ArenaArray<UINT> materialMap;
+	materialMap.Resize(numMaterials);
+	for (UINT i = 0; i < numMaterials; i++)
+		materialMap[i] = (UINT)-1;
+
+	for (UINT i = 0; i < numSubsets; i++)
+	{
+		if (subsetKept[i] && subsets[i].MaterialID < numMaterials)
+			materialMap[subsets[i].MaterialID] = 0;
+	}
+
+	UINT numUsed = 0;
+	for (UINT i = 0; i < numMaterials; i++)
+	{
+		if (materialMap[i] == (UINT)-1)
+			continue;
+
+		if (numUsed != i)
+			*sdkMesh->GetMaterial(numUsed) = *sdkMesh->GetMaterial(i);
+
+		materialMap[i] = numUsed++;
+	}
+
+	for (UINT i = 0; i < numSubsets; i++)
+	{
+		if (subsetKept[i] && subsets[i].MaterialID < numMaterials)
+			subsets[i].MaterialID = materialMap[subsets[i].MaterialID];
+	}
+
+	header->NumMaterials = numUsed;
+
+	return m_numSubsets;
+}
+
+bool MeshFilter::Load(const char *path, SDKMesh *sdkMesh, std::vector<BYTE>& data)
+{
+	m_numMeshes = 0;
+	m_numSubsets = 0;
+	m_bytesRead = 0;
+
+	FileReader file;
+	if (!file.Open(path))
+		return false;
+
+	m_fileSize = file.GetSize();
+
+	size_t staticSize = MeshManifest::ReadStaticData(file, data);
+	if (staticSize == 0 || sdkMesh->CreateHeadersOnly(data.data(), staticSize) != S_OK)
+		return false;
+
+	UINT64 firstRead = m_fileSize < MANIFEST_READ_SIZE ? m_fileSize : MANIFEST_READ_SIZE;
+	m_bytesRead = staticSize > firstRead ? staticSize : firstRead;
+
+	if (Apply(sdkMesh) == 0)
+		return false;
+
+	SDKMESH_HEADER *header = sdkMesh->GetHeader();
+	UINT numVBs = header->NumVertexBuffers;
+	UINT numIBs = header->NumIndexBuffers;
+	UINT64 bufferStart = header->HeaderSize + header->NonBufferDataSize;
+
+	// offset of each read buffer in data, after the header data; vertex buffers then index buffers
+	ArenaArray<UINT64> slots;
+	slots.Resize(numVBs + numIBs);
+	for (UINT i = 0; i < numVBs + numIBs; i++)
+		slots[i] = 0;
+
+	// file ranges of the buffers
+	ArenaArray<UINT64> offsets;
+	ArenaArray<UINT64> sizes;
+	offsets.Resize(numVBs + numIBs);
+	sizes.Resize(numVBs + numIBs);
+
+	SDKMESH_VERTEX_BUFFER_HEADER *vbs = (SDKMESH_VERTEX_BUFFER_HEADER*)(data.data() + header->VertexStreamHeadersOffset);
+	SDKMESH_INDEX_BUFFER_HEADER *ibs = (SDKMESH_INDEX_BUFFER_HEADER*)(data.data() + header->IndexStreamHeadersOffset);
+	for (UINT i = 0; i < numVBs; i++)
+	{
+		offsets[i] = vbs[i].DataOffset;
+		sizes[i] = vbs[i].SizeBytes;
+	}
+	for (UINT i = 0; i < numIBs; i++)
+	{
+		offsets[numVBs + i] = ibs[i].DataOffset;
+		sizes[numVBs + i] = ibs[i].SizeBytes;
+	}
+
+	UINT64 size = AlignSize(staticSize);
+
+	for (UINT meshIdx = 0; meshIdx < header->NumMeshes; meshIdx++)
+	{
+		SDKMESH_MESH *mesh = sdkMesh->GetMesh(meshIdx);
+
+		UINT buffers[MAX_VERTEX_STREAMS + 1];
+		UINT numBuffers = 0;
+		for (UINT i = 0; i < mesh->NumVertexBuffers; i++)
+			buffers[numBuffers++] = mesh->VertexBuffers[i];
+		buffers[numBuffers++] = numVBs + mesh->IndexBuffer;
+
+		for (UINT i = 0; i < numBuffers; i++)
+		{
+			UINT buffer = buffers[i];
+			if (slots[buffer] != 0)
+				continue;
+
+			if (offsets[buffer] < bufferStart || offsets[buffer] > m_fileSize || sizes[buffer] > m_fileSize - offsets[buffer])
+				return false;
+
+			slots[buffer] = size;
+			size += AlignSize(sizes[buffer]);
+		}
+	}
+
+	// data may move when it grows: the subset & influence pointers go back to offsets
+	// (as in MeshCache::Write) and are fixed up again, the selection is kept
+	for (UINT i = 0; i < header->NumMeshes; i++)
+	{
+		SDKMESH_MESH *mesh = sdkMesh->GetMesh(i);
+		mesh->SubsetOffset = (UINT64)((BYTE*)mesh->pSubsets - data.data());
+		mesh->FrameInfluenceOffset = (UINT64)((BYTE*)mesh->pFrameInfluences - data.data());
+	}
+
+	data.resize((size_t)size);
+	if (sdkMesh->CreateHeadersOnly(data.data(), staticSize) != S_OK)
+		return false;
+
+	m_vertices.Resize(numVBs);
+	m_indices.Resize(numIBs);
+
+	for (UINT i = 0; i < numVBs + numIBs; i++)
+	{
+		BYTE *buffer = NULL;
+		if (slots[i] != 0)
+		{
+			buffer = data.data() + slots[i];
+			if (file.ReadAt(buffer, (size_t)sizes[i], offsets[i]) != sizes[i])
+				return false;
+
+			m_bytesRead += sizes[i];
+		}
+
+		if (i < numVBs)
+			m_vertices[i] = buffer;
+		else
+			m_indices[i - numVBs] = buffer;
+	}
+
+	sdkMesh->SetBuffers(m_vertices.Data(), m_indices.Data());
+	return true;
+}
+
+void MeshFilter::PrintStats()
+{
+	LogInfo() << "Selection: " << m_numMeshes << " meshes, " << m_numSubsets << " subsets, read "
+		<< m_bytesRead / 1024 << " KB of " << m_fileSize / 1024 << " KB\n";
+}
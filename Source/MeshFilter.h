@@ -0,0 +1,85 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "Arena.h"
+
+#include <string>
+#include <vector>
+
+enum FILTER_KIND
+{
+	FK_MESH = 0,
+	FK_SUBSET,
+	FK_MATERIAL,
+	// a frame of the mesh or one of its parents
+	FK_FRAME
+};
+
+struct FilterPattern
+{
+	FILTER_KIND Kind;
+	bool Exclude;
+	std::string Glob;
+};
+
+// Subsets picked by name (-select & -exclude): [mesh:|subset:|material:|frame:]GLOB lists,
+// '*' and '?' wildcards, case insensitive. A subset is kept when a select pattern matches it
+// (or there is none) and no exclude pattern does. The selection is resolved on the headers,
+// then only the vertex & index buffers of the kept meshes are read.
+class MeshFilter
+{
+protected:
+	std::vector<FilterPattern> m_patterns;
+	bool m_hasSelect;
+
+	UINT m_numMeshes;
+	UINT m_numSubsets;
+	UINT64 m_bytesRead;
+	UINT64 m_fileSize;
+
+	// buffer pointers of the loaded mesh, NULL: not read
+	ArenaArray<BYTE*> m_vertices;
+	ArenaArray<BYTE*> m_indices;
+
+public:
+	MeshFilter();
+
+	virtual ~MeshFilter();
+
+	// comma separated patterns, false if a kind is unknown
+	bool Add(const char *patterns, bool exclude);
+
+	bool IsEnabled()
+	{
+		return !m_patterns.empty();
+	}
+
+	// drop the subsets, meshes and materials that are not selected from writable header data,
+	// the frames of a dropped mesh get INVALID_MESH; returns the kept subsets
+	UINT Apply(SDKMesh *sdkMesh);
+
+	// header data, selection, then the buffers of the kept meshes in data (reused);
+	// false if the file can not be read or nothing is selected (GetNumSubsets)
+	bool Load(const char *path, SDKMesh *sdkMesh, std::vector<BYTE>& data);
+
+	UINT GetNumSubsets()
+	{
+		return m_numSubsets;
+	}
+
+	UINT64 GetBytesRead()
+	{
+		return m_bytesRead;
+	}
+
+	void PrintStats();
+
+protected:
+	bool IsSelected(SDKMESH_MESH *mesh, SDKMESH_SUBSET *subset, SDKMESH_MATERIAL *material, BYTE frames);
+
+	// frame patterns that match a frame of each mesh or its parents: bit 0 select, bit 1 exclude
+	void MatchFrames(SDKMesh *sdkMesh, ArenaArray<BYTE>& frames);
+
+	// a fixed size name field, not always terminated
+	static bool MatchName(const std::string& glob, const char *name, size_t size);
+};
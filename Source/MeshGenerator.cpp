@@ -0,0 +1,299 @@
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+
+// [0, 1] floats only: no denormals, inf or nan
+static unsigned short FloatToHalf(float f)
+{
+	unsigned int bits;
+	memcpy(&bits, &f, sizeof(float));
+
+	unsigned int sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	unsigned int mantissa = (bits >> 13) & 0x3FF;
+
+	if (exponent <= 0)
+		return (unsigned short)sign;
+	if (exponent >= 31)
+		return (unsigned short)(sign | 0x7BFF);
+
+	return (unsigned short)(sign | (exponent << 10) | mantissa);
+}
+
+static DWORD PackDEC3N(const float *n)
+{
+	DWORD v = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		int c = (int)floorf(n[i] * 511.0f + 0.5f);
+		v |= ((DWORD)c & 0x3FF) << (i * 10);
+	}
+	return v;
+}
+
+MeshGenerator::MeshGenerator(const GeneratorOptions& options)
+	:m_options(options),
+	m_state(options.Seed * 0x9E3779B97F4A7C15ULL + 1)
+{
+	if (m_options.NumMeshes < 1)
+		m_options.NumMeshes = 1;
+	if (m_options.NumSubsets < 1)
+		m_options.NumSubsets = 1;
+}
+
+UINT MeshGenerator::Random()
+{
+	m_state ^= m_state >> 12;
+	m_state ^= m_state << 25;
+	m_state ^= m_state >> 27;
+	return (UINT)((m_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void MeshGenerator::Build(SDKMeshWriter& writer)
+{
+	for (UINT i = 0; i < m_options.NumSubsets; i++)
+	{
+		char name[MAX_MATERIAL_NAME];
+		sprintf(name, "material_%u", i);
+
+		SDKMESH_MATERIAL material;
+		SDKMeshWriter::InitMaterial(material, name);
+		material.Diffuse.x = (float)((i * 37) % 256) / 255.0f;
+		material.Diffuse.y = (float)((i * 91 + 64) % 256) / 255.0f;
+		material.Diffuse.z = (float)((i * 173 + 128) % 256) / 255.0f;
+		writer.AddMaterial(material);
+	}
+
+	// N x N quads per mesh
+	UINT64 trianglesPerMesh = m_options.NumTriangles / m_options.NumMeshes;
+	UINT gridSize = (UINT)(sqrt((double)trianglesPerMesh / 2.0) + 0.5);
+	if (gridSize < 1)
+		gridSize = 1;
+
+	for (UINT i = 0; i < m_options.NumMeshes; i++)
+		BuildMesh(writer, i, gridSize);
+}
+
+void MeshGenerator::BuildMesh(SDKMeshWriter& writer, UINT meshID, UINT gridSize)
+{
+	UINT n = gridSize;
+	UINT numVertices = (n + 1) * (n + 1);
+	UINT numTriangles = n * n * 2;
+
+	// meshes side by side on x
+	float offset = meshID * 1.25f;
+
+	D3DVERTEXELEMENT9 declaration[5];
+	UINT numElements = 0;
+	WORD stride = 0;
+
+	D3DVERTEXELEMENT9 position = { 0, stride, D3DDECLTYPE_FLOAT3, 0, D3DDECLUSAGE_POSITION, 0 };
+	declaration[numElements++] = position;
+	stride += 12;
+
+	if (m_options.Declaration == GD_FULL)
+	{
+		D3DVERTEXELEMENT9 normal = { 0, stride, D3DDECLTYPE_FLOAT3, 0, D3DDECLUSAGE_NORMAL, 0 };
+		declaration[numElements++] = normal;
+		stride += 12;
+
+		D3DVERTEXELEMENT9 texcoord = { 0, stride, D3DDECLTYPE_FLOAT2, 0, D3DDECLUSAGE_TEXCOORD, 0 };
+		declaration[numElements++] = texcoord;
+		stride += 8;
+	}
+	else if (m_options.Declaration == GD_COMPACT)
+	{
+		D3DVERTEXELEMENT9 normal = { 0, stride, D3DDECLTYPE_DEC3N, 0, D3DDECLUSAGE_NORMAL, 0 };
+		declaration[numElements++] = normal;
+		stride += 4;
+
+		D3DVERTEXELEMENT9 texcoord = { 0, stride, D3DDECLTYPE_FLOAT16_2, 0, D3DDECLUSAGE_TEXCOORD, 0 };
+		declaration[numElements++] = texcoord;
+		stride += 4;
+
+		D3DVERTEXELEMENT9 color = { 0, stride, D3DDECLTYPE_D3DCOLOR, 0, D3DDECLUSAGE_COLOR, 0 };
+		declaration[numElements++] = color;
+		stride += 4;
+	}
+
+	D3DVERTEXELEMENT9 last = { (WORD)0xFF, 0, D3DDECLTYPE_UNUSED, 0, 0, 0 };
+	declaration[numElements] = last;
+
+	// scattered: vertex i is stored at order[i]
+	std::vector<UINT> order(numVertices);
+	for (UINT i = 0; i < numVertices; i++)
+		order[i] = i;
+
+	if (m_options.Locality == GL_SCATTERED)
+	{
+		for (UINT i = numVertices - 1; i > 0; i--)
+			std::swap(order[i], order[Random() % (i + 1)]);
+	}
+
+	std::vector<BYTE> vertices(numVertices * stride);
+
+	for (UINT z = 0; z <= n; z++)
+	{
+		for (UINT x = 0; x <= n; x++)
+		{
+			float u = x / (float)n;
+			float v = z / (float)n;
+
+			float p[3];
+			p[0] = offset + u;
+			p[1] = 0.1f * sinf(u * 6.0f) * cosf(v * 6.0f);
+			p[2] = v;
+
+			float normal[3];
+			normal[0] = -0.6f * cosf(u * 6.0f) * cosf(v * 6.0f);
+			normal[1] = 1.0f;
+			normal[2] = 0.6f * sinf(u * 6.0f) * sinf(v * 6.0f);
+
+			float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (int i = 0; i < 3; i++)
+				normal[i] /= length;
+
+			BYTE *vertex = vertices.data() + (size_t)order[z * (n + 1) + x] * stride;
+			memcpy(vertex, p, 12);
+
+			if (m_options.Declaration == GD_FULL)
+			{
+				float uv[2] = { u, 1.0f - v };
+				memcpy(vertex + 12, normal, 12);
+				memcpy(vertex + 24, uv, 8);
+			}
+			else if (m_options.Declaration == GD_COMPACT)
+			{
+				DWORD packed = PackDEC3N(normal);
+				unsigned short uv[2] = { FloatToHalf(u), FloatToHalf(1.0f - v) };
+
+				// D3DCOLOR: B G R A in memory
+				BYTE color[4] = { (BYTE)(v * 255.0f), (BYTE)(p[1] * 1275.0f + 128.0f), (BYTE)(u * 255.0f), 255 };
+
+				memcpy(vertex + 12, &packed, 4);
+				memcpy(vertex + 16, uv, 4);
+				memcpy(vertex + 20, color, 4);
+			}
+		}
+	}
+
+	std::vector<UINT> triangles(numTriangles);
+	for (UINT i = 0; i < numTriangles; i++)
+		triangles[i] = i;
+
+	if (m_options.Locality != GL_ORDERED)
+	{
+		for (UINT i = numTriangles - 1; i > 0; i--)
+			std::swap(triangles[i], triangles[Random() % (i + 1)]);
+	}
+
+	std::vector<UINT> indices(numTriangles * 3);
+	for (UINT i = 0; i < numTriangles; i++)
+	{
+		// quad (a b / c d): a c b, b c d
+		UINT quad = triangles[i] / 2;
+		UINT a = (quad / n) * (n + 1) + quad % n;
+		UINT b = a + 1;
+		UINT c = a + n + 1;
+		UINT d = c + 1;
+
+		UINT *triangle = &indices[i * 3];
+		if (triangles[i] % 2 == 0)
+		{
+			triangle[0] = order[a];
+			triangle[1] = order[c];
+			triangle[2] = order[b];
+		}
+		else
+		{
+			triangle[0] = order[b];
+			triangle[1] = order[c];
+			triangle[2] = order[d];
+		}
+	}
+
+	char name[MAX_MESH_NAME];
+	sprintf(name, "mesh_%u", meshID);
+
+	D3DXVECTOR3 center = { offset + 0.5f, 0.0f, 0.5f };
+	D3DXVECTOR3 extents = { 0.5f, 0.1f, 0.5f };
+
+	UINT vb = writer.AddVertexBuffer(declaration, stride, vertices);
+	UINT ib = writer.AddIndexBuffer(indices, m_options.Index32);
+	UINT mesh = writer.AddMesh(name, vb, ib, center, extents);
+
+	UINT numSubsets = m_options.NumSubsets < numTriangles ? m_options.NumSubsets : numTriangles;
+	for (UINT i = 0; i < numSubsets; i++)
+	{
+		UINT64 first = (UINT64)numTriangles * i / numSubsets;
+		UINT64 end = (UINT64)numTriangles * (i + 1) / numSubsets;
+
+		char subsetName[MAX_SUBSET_NAME];
+		sprintf(subsetName, "subset_%u", i);
+		writer.AddSubset(mesh, subsetName, i, first * 3, (end - first) * 3, 0, numVertices);
+	}
+}
+
+bool MeshGenerator::Write(const char *path)
+{
+	SDKMeshWriter writer;
+	Build(writer);
+	return writer.Write(path);
+}
+
+bool MeshGenerator::ParseDeclaration(const char *name, GENERATOR_DECLARATION *declaration)
+{
+	for (int i = GD_POSITION; i <= GD_COMPACT; i++)
+	{
+		if (strcmp(name, GetDeclarationName((GENERATOR_DECLARATION)i)) == 0)
+		{
+			*declaration = (GENERATOR_DECLARATION)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MeshGenerator::ParseLocality(const char *name, GENERATOR_LOCALITY *locality)
+{
+	for (int i = GL_ORDERED; i <= GL_SCATTERED; i++)
+	{
+		if (strcmp(name, GetLocalityName((GENERATOR_LOCALITY)i)) == 0)
+		{
+			*locality = (GENERATOR_LOCALITY)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* MeshGenerator::GetDeclarationName(GENERATOR_DECLARATION declaration)
+{
+	switch (declaration)
+	{
+	case GD_POSITION:
+		return "position";
+	case GD_FULL:
+		return "full";
+	case GD_COMPACT:
+		return "compact";
+	}
+	return "";
+}
+
+const char* MeshGenerator::GetLocalityName(GENERATOR_LOCALITY locality)
+{
+	switch (locality)
+	{
+	case GL_ORDERED:
+		return "ordered";
+	case GL_SHUFFLED:
+		return "shuffled";
+	case GL_SCATTERED:
+		return "scattered";
+	}
+	return "";
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "SDKMeshWriter.h"
+
+enum GENERATOR_DECLARATION
+{
+	// POSITION float3
+	GD_POSITION = 0,
+	// POSITION float3, NORMAL float3, TEXCOORD float2
+	GD_FULL,
+	// POSITION float3, NORMAL DEC3N, TEXCOORD FLOAT16_2, COLOR D3DCOLOR
+	GD_COMPACT,
+};
+
+enum GENERATOR_LOCALITY
+{
+	// grid order: neighbour triangles share their vertices
+	GL_ORDERED = 0,
+	// triangles in random order
+	GL_SHUFFLED,
+	// triangles and vertices in random order
+	GL_SCATTERED,
+};
+
+struct GeneratorOptions
+{
+	// total, split over the meshes
+	UINT64 NumTriangles;
+	UINT NumMeshes;
+
+	// per mesh, one material per subset index
+	UINT NumSubsets;
+
+	// 32 bit indices even when 16 bit fit
+	bool Index32;
+
+	GENERATOR_DECLARATION Declaration;
+	GENERATOR_LOCALITY Locality;
+
+	UINT Seed;
+
+	GeneratorOptions()
+		:NumTriangles(100000),
+		NumMeshes(1),
+		NumSubsets(1),
+		Index32(false),
+		Declaration(GD_FULL),
+		Locality(GL_ORDERED),
+		Seed(1)
+	{
+	}
+};
+
+// Synthetic sdkmesh: each mesh is a wavy grid (a height field of sines) of about
+// NumTriangles / NumMeshes triangles, its index buffer cut in NumSubsets subsets.
+// The same options and seed always give the same file.
+class MeshGenerator
+{
+protected:
+	GeneratorOptions m_options;
+
+	UINT64 m_state;
+
+public:
+	MeshGenerator(const GeneratorOptions& options);
+
+	void Build(SDKMeshWriter& writer);
+
+	bool Write(const char *path);
+
+	static bool ParseDeclaration(const char *name, GENERATOR_DECLARATION *declaration);
+
+	static bool ParseLocality(const char *name, GENERATOR_LOCALITY *locality);
+
+	static const char* GetDeclarationName(GENERATOR_DECLARATION declaration);
+
+	static const char* GetLocalityName(GENERATOR_LOCALITY locality);
+
+protected:
+	void BuildMesh(SDKMeshWriter& writer, UINT meshID, UINT gridSize);
+
+	// xorshift64*
+	UINT Random();
+};
@@ -0,0 +1,137 @@
+#include "MeshInfo.h"
+#include "MeshManifest.h"
+#include "ParallelFor.h"
+#include "Log.h"
+
+#include <chrono>
+
+MeshInfo::MeshInfo()
+	:m_numThreads(0),
+	m_seconds(0.0)
+{
+}
+
+MeshInfo::~MeshInfo()
+{
+}
+
+void MeshInfo::AddFile(const std::string& path)
+{
+	MeshInfoItem item;
+	item.Path = path;
+	item.Success = false;
+	item.FileSize = 0;
+	item.Vertices = 0;
+	item.Indices = 0;
+	item.Triangles = 0;
+	item.Meshes = 0;
+	item.Subsets = 0;
+	item.Materials = 0;
+	item.Frames = 0;
+	m_items.push_back(item);
+}
+
+static void ReadInfo(MeshManifest& manifest, MeshInfoItem& item)
+{
+	item.Success = manifest.Load(item.Path.c_str());
+	item.FileSize = manifest.GetFileSize();
+	if (!item.Success)
+		return;
+
+	SDKMesh *mesh = manifest.GetMesh();
+
+	item.Vertices = manifest.GetNumVertices();
+
+	item.Meshes = mesh->GetNumMeshes();
+	item.Materials = mesh->GetNumMaterials();
+	item.Frames = mesh->GetNumFrames();
+
+	for (UINT i = 0; i < item.Meshes; i++)
+	{
+		item.Indices += mesh->GetNumIndices(i);
+
+		UINT numSubsets = mesh->GetNumSubsets(i);
+		item.Subsets += numSubsets;
+
+		for (UINT j = 0; j < numSubsets; j++)
+		{
+			SDKMESH_SUBSET *subset = mesh->GetSubset(i, j);
+			if (subset->PrimitiveType == PT_TRIANGLE_LIST)
+				item.Triangles += subset->IndexCount / 3;
+			else if (subset->PrimitiveType == PT_TRIANGLE_STRIP && subset->IndexCount >= 3)
+				item.Triangles += subset->IndexCount - 2;
+		}
+	}
+}
+
+UINT MeshInfo::Run(int numThreads)
+{
+	m_numThreads = numThreads > 0 ? numThreads : GetDefaultNumThreads();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// one manifest per thread, its read buffer is reused from file to file
+	std::vector<MeshManifest> manifests(m_numThreads);
+
+	ParallelFor(m_items.size(), m_numThreads, [&](size_t i, int thread)
+	{
+		ReadInfo(manifests[thread], m_items[i]);
+	});
+
+	m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	UINT numFailed = 0;
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		if (!m_items[i].Success)
+			numFailed++;
+	}
+	return numFailed;
+}
+
+void MeshInfo::PrintStats()
+{
+	MeshInfoItem total;
+	total.FileSize = total.Vertices = total.Indices = total.Triangles = 0;
+	total.Meshes = total.Subsets = total.Materials = total.Frames = 0;
+
+	UINT numFailed = 0;
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		const MeshInfoItem& item = m_items[i];
+		if (!item.Success)
+		{
+			LogError() << "Failed: " << item.Path << "\n";
+			numFailed++;
+			continue;
+		}
+
+		LogDebug() << item.Path << ": " << item.Triangles << " triangles, " << item.Vertices << " vertices, "
+			<< item.Indices << " indices, " << item.Meshes << " meshes, " << item.Subsets << " subsets, "
+			<< item.Materials << " materials, " << item.Frames << " frames\n";
+
+		total.FileSize += item.FileSize;
+		total.Vertices += item.Vertices;
+		total.Indices += item.Indices;
+		total.Triangles += item.Triangles;
+		total.Meshes += item.Meshes;
+		total.Subsets += item.Subsets;
+		total.Materials += item.Materials;
+		total.Frames += item.Frames;
+	}
+
+	double seconds = m_seconds > 0.0 ? m_seconds : 1e-9;
+
+	LogInfo() << "Files: " << m_items.size() - numFailed << " (failed: " << numFailed << ")\n";
+	LogInfo() << "Triangles: " << total.Triangles << ", vertices: " << total.Vertices << ", indices: " << total.Indices << "\n";
+	LogInfo() << "Meshes: " << total.Meshes << ", subsets: " << total.Subsets << ", materials: " << total.Materials << ", frames: " << total.Frames << "\n";
+	LogInfo() << "Input: " << total.FileSize / (1024.0 * 1024.0) << " MB\n";
+	LogInfo() << "Time: " << (int)(m_seconds * 1000) << " ms on " << m_numThreads << " threads, "
+		<< (int)(m_items.size() / seconds) << " files/s\n";
+}
+
+int MeshInfo::GetDefaultNumThreads()
+{
+	// mostly waiting on the file system, not on the cores
+	return ::GetDefaultNumThreads() * 4;
+}
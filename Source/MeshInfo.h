@@ -0,0 +1,63 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+#include <string>
+#include <vector>
+
+struct MeshInfoItem
+{
+	std::string Path;
+
+	bool Success;
+	UINT64 FileSize;
+
+	// from the vertex & index buffer headers of the meshes
+	UINT64 Vertices;
+	UINT64 Indices;
+
+	// from the subsets
+	UINT64 Triangles;
+
+	UINT Meshes;
+	UINT Subsets;
+	UINT Materials;
+	UINT Frames;
+};
+
+// Statistics of many sdkmesh files read from their headers & non-buffer data only:
+// one positioned read per file (see MeshManifest), the vertex & index data is never read.
+// The reads are latency bound, so the files are scanned by more threads than cores.
+class MeshInfo
+{
+protected:
+	std::vector<MeshInfoItem> m_items;
+
+	int m_numThreads;
+	double m_seconds;
+
+public:
+	MeshInfo();
+
+	virtual ~MeshInfo();
+
+	void AddFile(const std::string& path);
+
+	UINT GetNumItems()
+	{
+		return (UINT)m_items.size();
+	}
+
+	MeshInfoItem& GetItem(UINT i)
+	{
+		return m_items[i];
+	}
+
+	// returns the number of failed files
+	UINT Run(int numThreads);
+
+	// each file with -v, then the totals
+	void PrintStats();
+
+	static int GetDefaultNumThreads();
+};
@@ -0,0 +1,274 @@
+#include "MeshManifest.h"
+#include "SubsetDecoder.h"
+#include "FileReader.h"
+
+#include <string.h>
+
+// fixed size name fields are not always terminated
+static std::string GetName(const char *name, size_t size)
+{
+	const char *end = (const char*)memchr(name, 0, size);
+	return std::string(name, end != NULL ? (size_t)(end - name) : size);
+}
+
+// INVALID_* as -1
+static void WriteIndex(JSONWriter& json, const char *name, UINT index)
+{
+	if (index == (UINT)-1)
+		json.Write(name, -1);
+	else
+		json.Write(name, index);
+}
+
+MeshManifest::MeshManifest()
+	:m_fileSize(0)
+{
+}
+
+MeshManifest::~MeshManifest()
+{
+}
+
+size_t MeshManifest::ReadStaticData(FileReader& file, std::vector<BYTE>& data)
+{
+	UINT64 fileSize = file.GetSize();
+
+	// one read covers the header & non-buffer data of most files
+	size_t readSize = fileSize < MANIFEST_READ_SIZE ? (size_t)fileSize : MANIFEST_READ_SIZE;
+	data.resize(readSize);
+
+	size_t read = file.ReadAt(data.data(), readSize, 0);
+
+	SDKMESH_HEADER *header = (SDKMESH_HEADER*)data.data();
+	if (read != readSize || read < sizeof(SDKMESH_HEADER) ||
+		header->Version != SDKMESH_FILE_VERSION ||
+		header->HeaderSize > fileSize ||
+		header->NonBufferDataSize > fileSize - header->HeaderSize)
+		return 0;
+
+	size_t staticSize = (size_t)(header->HeaderSize + header->NonBufferDataSize);
+
+	// the buffer keeps its capacity, a reused manifest does not allocate again
+	data.resize(staticSize);
+	if (staticSize > read && file.ReadAt(data.data() + read, staticSize - read, read) != staticSize - read)
+		return 0;
+
+	return staticSize;
+}
+
+bool MeshManifest::Load(const char *path)
+{
+	m_sdkMesh.Destroy();
+	m_path = path;
+	m_fileSize = 0;
+
+	FileReader file;
+	if (!file.Open(path))
+		return false;
+
+	m_fileSize = file.GetSize();
+
+	size_t staticSize = ReadStaticData(file, m_data);
+	return staticSize > 0 && m_sdkMesh.CreateHeadersOnly(m_data.data(), staticSize) == S_OK;
+}
+
+UINT64 MeshManifest::GetNumTriangles()
+{
+	UINT64 triangles = 0;
+	for (UINT i = 0; i < m_sdkMesh.GetNumMeshes(); i++)
+		triangles += m_sdkMesh.GetNumIndices(i) / 3;
+	return triangles;
+}
+
+UINT64 MeshManifest::GetNumVertices()
+{
+	UINT64 vertices = 0;
+	for (UINT i = 0; i < m_sdkMesh.GetNumMeshes(); i++)
+	{
+		if (m_sdkMesh.GetMesh(i)->NumVertexBuffers > 0)
+			vertices += m_sdkMesh.GetNumVertices(i, 0);
+	}
+	return vertices;
+}
+
+void MeshManifest::Write(JSONWriter& json)
+{
+	SDKMESH_HEADER *header = m_sdkMesh.GetHeader();
+
+	json.BeginObject();
+	json.Write("source", m_path.c_str());
+	json.Write("fileSize", (unsigned long long)m_fileSize);
+	json.Write("version", header->Version);
+	json.Write("headerSize", (unsigned long long)header->HeaderSize);
+	json.Write("nonBufferDataSize", (unsigned long long)header->NonBufferDataSize);
+	json.Write("bufferDataSize", (unsigned long long)header->BufferDataSize);
+
+	// the buffer data is not read, only its size is checked
+	json.Write("complete", header->BufferDataSize <= m_fileSize - header->HeaderSize - header->NonBufferDataSize);
+	json.Write("triangles", (unsigned long long)GetNumTriangles());
+	json.Write("vertices", (unsigned long long)GetNumVertices());
+
+	const SDKMESH_VERTEX_BUFFER_HEADER *vbs = (const SDKMESH_VERTEX_BUFFER_HEADER*)(m_data.data() + header->VertexStreamHeadersOffset);
+	const SDKMESH_INDEX_BUFFER_HEADER *ibs = (const SDKMESH_INDEX_BUFFER_HEADER*)(m_data.data() + header->IndexStreamHeadersOffset);
+
+	json.BeginArray("vertexBuffers");
+	for (UINT i = 0; i < header->NumVertexBuffers; i++)
+	{
+		const SDKMESH_VERTEX_BUFFER_HEADER& vb = vbs[i];
+
+		json.BeginObject();
+		json.Write("numVertices", (unsigned long long)vb.NumVertices);
+		json.Write("stride", (unsigned long long)vb.StrideBytes);
+		json.Write("sizeBytes", (unsigned long long)vb.SizeBytes);
+		json.Write("dataOffset", (unsigned long long)vb.DataOffset);
+
+		json.BeginArray("elements");
+		for (UINT j = 0; j < MAX_VERTEX_ELEMENTS && vb.Decl[j].Stream != 0xFF; j++)
+		{
+			const D3DVERTEXELEMENT9& element = vb.Decl[j];
+
+			json.BeginObject();
+			json.Write("usage", SubsetDecoder::GetUsageName(element.Usage));
+			json.Write("usageIndex", (int)element.UsageIndex);
+			json.Write("format", SubsetDecoder::GetFormatName(element.Type));
+			json.Write("type", (int)element.Type);
+			json.Write("offset", (int)(unsigned short)element.Offset);
+			json.EndObject();
+		}
+		json.EndArray();
+
+		json.EndObject();
+	}
+	json.EndArray();
+
+	json.BeginArray("indexBuffers");
+	for (UINT i = 0; i < header->NumIndexBuffers; i++)
+	{
+		const SDKMESH_INDEX_BUFFER_HEADER& ib = ibs[i];
+
+		json.BeginObject();
+		json.Write("numIndices", (unsigned long long)ib.NumIndices);
+		json.Write("indexType", ib.IndexType == IT_32BIT ? "32BIT" : "16BIT");
+		json.Write("sizeBytes", (unsigned long long)ib.SizeBytes);
+		json.Write("dataOffset", (unsigned long long)ib.DataOffset);
+		json.EndObject();
+	}
+	json.EndArray();
+
+	json.BeginArray("meshes");
+	for (UINT i = 0; i < m_sdkMesh.GetNumMeshes(); i++)
+		WriteMesh(json, i);
+	json.EndArray();
+
+	json.BeginArray("materials");
+	for (UINT i = 0; i < m_sdkMesh.GetNumMaterials(); i++)
+	{
+		SDKMESH_MATERIAL *material = m_sdkMesh.GetMaterial(i);
+
+		json.BeginObject();
+		json.Write("name", GetName(material->Name, MAX_MATERIAL_NAME).c_str());
+		json.Write("diffuseTexture", GetName(material->DiffuseTexture, MAX_TEXTURE_NAME).c_str());
+		json.Write("normalTexture", GetName(material->NormalTexture, MAX_TEXTURE_NAME).c_str());
+		json.Write("specularTexture", GetName(material->SpecularTexture, MAX_TEXTURE_NAME).c_str());
+		json.Write("diffuse", &material->Diffuse.x, 4);
+		json.Write("ambient", &material->Ambient.x, 4);
+		json.Write("specular", &material->Specular.x, 4);
+		json.Write("emissive", &material->Emissive.x, 4);
+		json.Write("power", (double)material->Power);
+		json.EndObject();
+	}
+	json.EndArray();
+
+	json.BeginArray("frames");
+	for (UINT i = 0; i < m_sdkMesh.GetNumFrames(); i++)
+	{
+		SDKMESH_FRAME *frame = m_sdkMesh.GetFrame(i);
+
+		json.BeginObject();
+		json.Write("name", GetName(frame->Name, MAX_FRAME_NAME).c_str());
+		WriteIndex(json, "mesh", frame->Mesh);
+		WriteIndex(json, "parent", frame->ParentFrame);
+		WriteIndex(json, "child", frame->ChildFrame);
+		WriteIndex(json, "sibling", frame->SiblingFrame);
+		json.EndObject();
+	}
+	json.EndArray();
+
+	json.EndObject();
+}
+
+void MeshManifest::WriteMesh(JSONWriter& json, UINT meshIdx)
+{
+	SDKMESH_MESH *mesh = m_sdkMesh.GetMesh(meshIdx);
+
+	json.BeginObject();
+	json.Write("name", GetName(mesh->Name, MAX_MESH_NAME).c_str());
+
+	json.BeginArray("vertexBuffers");
+	for (UINT i = 0; i < mesh->NumVertexBuffers; i++)
+		json.Write(NULL, mesh->VertexBuffers[i]);
+	json.EndArray();
+
+	json.Write("indexBuffer", mesh->IndexBuffer);
+	json.Write("indexType", m_sdkMesh.GetIndexType(meshIdx) == IT_32BIT ? "32BIT" : "16BIT");
+	json.Write("numIndices", (unsigned long long)m_sdkMesh.GetNumIndices(meshIdx));
+	json.Write("numVertices", (unsigned long long)(mesh->NumVertexBuffers > 0 ? m_sdkMesh.GetNumVertices(meshIdx, 0) : 0));
+	json.Write("numFrameInfluences", mesh->NumFrameInfluences);
+	json.Write("center", &mesh->BoundingBoxCenter.x, 3);
+	json.Write("extents", &mesh->BoundingBoxExtents.x, 3);
+
+	json.BeginArray("subsets");
+	for (UINT i = 0; i < mesh->NumSubsets; i++)
+	{
+		SDKMESH_SUBSET *subset = m_sdkMesh.GetSubset(meshIdx, i);
+
+		json.BeginObject();
+		json.Write("name", GetName(subset->Name, MAX_SUBSET_NAME).c_str());
+		WriteIndex(json, "material", subset->MaterialID);
+		json.Write("primitiveType", GetPrimitiveTypeName(subset->PrimitiveType));
+		json.Write("indexStart", (unsigned long long)subset->IndexStart);
+		json.Write("indexCount", (unsigned long long)subset->IndexCount);
+		json.Write("vertexStart", (unsigned long long)subset->VertexStart);
+		json.Write("vertexCount", (unsigned long long)subset->VertexCount);
+		json.EndObject();
+	}
+	json.EndArray();
+
+	json.EndObject();
+}
+
+bool MeshManifest::Write(const char *path)
+{
+	remove(path);
+	FILE *file = fopen(path, "wt");
+	if (file == NULL)
+		return false;
+
+	JSONWriter json(file);
+	Write(json);
+	json.Finish();
+
+	bool success = ferror(file) == 0;
+	return fclose(file) == 0 && success;
+}
+
+const char* MeshManifest::GetPrimitiveTypeName(UINT type)
+{
+	const char *names[] = {
+		"PT_TRIANGLE_LIST",
+		"PT_TRIANGLE_STRIP",
+		"PT_LINE_LIST",
+		"PT_LINE_STRIP",
+		"PT_POINT_LIST",
+		"PT_TRIANGLE_LIST_ADJ",
+		"PT_TRIANGLE_STRIP_ADJ",
+		"PT_LINE_LIST_ADJ",
+		"PT_LINE_STRIP_ADJ",
+		"PT_QUAD_PATCH_LIST",
+		"PT_TRIANGLE_PATCH_LIST",
+	};
+
+	if (type < sizeof(names) / sizeof(names[0]))
+		return names[type];
+	return "";
+}
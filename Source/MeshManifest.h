@@ -0,0 +1,61 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "JSONWriter.h"
+
+#include <string>
+#include <vector>
+
+// first read of a file, the rest of the non-buffer data is read after it if needed
+#define MANIFEST_READ_SIZE (16 * 1024)
+
+class FileReader;
+
+// Description of an sdkmesh read from its header & non-buffer data only (no vertex or index data):
+// vertex buffers with their declarations, index buffers, meshes with their subsets, materials and frames.
+class MeshManifest
+{
+protected:
+	std::string m_path;
+	UINT64 m_fileSize;
+
+	// header & non-buffer data, the mesh points in it
+	std::vector<BYTE> m_data;
+	SDKMesh m_sdkMesh;
+
+public:
+	MeshManifest();
+
+	virtual ~MeshManifest();
+
+	// false if the file can not be read or its headers are not valid
+	bool Load(const char *path);
+
+	SDKMesh* GetMesh()
+	{
+		return &m_sdkMesh;
+	}
+
+	UINT64 GetFileSize()
+	{
+		return m_fileSize;
+	}
+
+	// index buffer triangles & vertex buffer 0 vertices of all meshes
+	UINT64 GetNumTriangles();
+
+	UINT64 GetNumVertices();
+
+	// the manifest object as a value of the current scope
+	void Write(JSONWriter& json);
+
+	bool Write(const char *path);
+
+	// the header & non-buffer data of an opened file in data, returns their size, 0 if they are not valid
+	static size_t ReadStaticData(FileReader& file, std::vector<BYTE>& data);
+
+	static const char* GetPrimitiveTypeName(UINT type);
+
+protected:
+	void WriteMesh(JSONWriter& json, UINT meshIdx);
+};
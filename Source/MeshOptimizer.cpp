@@ -0,0 +1,239 @@
+#include "MeshOptimizer.h"
+
+#include <math.h>
+#include <cstring>
+
+// Forsyth's score function constants
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRI_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+static float VertexScore(int cachePosition, UINT numActiveTriangles)
+{
+	if (numActiveTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3)
+		{
+			// the vertices of the last triangle are in the cache anyway
+			score = LAST_TRI_SCORE;
+		}
+		else
+		{
+			const float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+			score = powf(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+		}
+	}
+
+	// boost vertices with few triangles left so they are finished first
+	score += VALENCE_BOOST_SCALE * powf((float)numActiveTriangles, -VALENCE_BOOST_POWER);
+
+	return score;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<UINT>& indices, UINT numVertices)
+{
+	size_t numTriangles = indices.size() / 3;
+	if (numTriangles < 2 || numVertices == 0)
+		return;
+
+	// vertex -> triangles adjacency
+	std::vector<UINT> numActive(numVertices, 0);
+	for (size_t i = 0; i < numTriangles * 3; i++)
+		numActive[indices[i]]++;
+
+	std::vector<UINT> adjacencyOffset(numVertices + 1, 0);
+	for (UINT v = 0; v < numVertices; v++)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + numActive[v];
+
+	std::vector<UINT> adjacency(adjacencyOffset[numVertices]);
+	std::vector<UINT> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			UINT v = indices[t * 3 + k];
+			adjacency[fill[v]++] = (UINT)t;
+		}
+	}
+
+	std::vector<int> cachePosition(numVertices, -1);
+	std::vector<float> vertexScore(numVertices);
+	for (UINT v = 0; v < numVertices; v++)
+		vertexScore[v] = VertexScore(-1, numActive[v]);
+
+	std::vector<float> triangleScore(numTriangles);
+	std::vector<bool> emitted(numTriangles, false);
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		triangleScore[t] = vertexScore[indices[t * 3]] +
+			vertexScore[indices[t * 3 + 1]] +
+			vertexScore[indices[t * 3 + 2]];
+	}
+
+	std::vector<UINT> result;
+	result.reserve(numTriangles * 3);
+
+	// LRU cache, +3 for the vertices pushed out by the new triangle
+	UINT cache[VERTEX_CACHE_SIZE + 3];
+	UINT cacheSize = 0;
+
+	size_t bestTriangle = 0;
+	for (size_t t = 1; t < numTriangles; t++)
+	{
+		if (triangleScore[t] > triangleScore[bestTriangle])
+			bestTriangle = t;
+	}
+
+	size_t scanCursor = 0;
+
+	for (size_t emittedCount = 0; emittedCount < numTriangles; emittedCount++)
+	{
+		if (bestTriangle == (size_t)-1)
+		{
+			// no candidate in the cache: best of the remaining triangles
+			float bestScore = -1.0f;
+			for (size_t t = scanCursor; t < numTriangles; t++)
+			{
+				if (emitted[t])
+				{
+					if (t == scanCursor)
+						scanCursor++;
+					continue;
+				}
+
+				if (bestTriangle == (size_t)-1 || triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		size_t t = bestTriangle;
+		emitted[t] = true;
+
+		UINT tri[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+		result.push_back(tri[0]);
+		result.push_back(tri[1]);
+		result.push_back(tri[2]);
+
+		// remove the triangle from the adjacency of its vertices
+		for (int k = 0; k < 3; k++)
+		{
+			UINT v = tri[k];
+			UINT begin = adjacencyOffset[v];
+			UINT end = begin + numActive[v];
+			for (UINT a = begin; a < end; a++)
+			{
+				if (adjacency[a] == t)
+				{
+					adjacency[a] = adjacency[end - 1];
+					break;
+				}
+			}
+			numActive[v]--;
+		}
+
+		// move the triangle vertices to the front of the LRU cache
+		UINT newCache[VERTEX_CACHE_SIZE + 3];
+		UINT newCacheSize = 0;
+		for (int k = 0; k < 3; k++)
+			newCache[newCacheSize++] = tri[k];
+
+		for (UINT c = 0; c < cacheSize; c++)
+		{
+			UINT v = cache[c];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCacheSize++] = v;
+		}
+
+		for (UINT c = VERTEX_CACHE_SIZE; c < newCacheSize; c++)
+			cachePosition[newCache[c]] = -1;
+
+		cacheSize = newCacheSize < VERTEX_CACHE_SIZE ? newCacheSize : VERTEX_CACHE_SIZE;
+		memcpy(cache, newCache, cacheSize * sizeof(UINT));
+
+		// update the scores of the cached vertices & their triangles, pick the next best
+		bestTriangle = (size_t)-1;
+		float bestScore = -1.0f;
+
+		for (UINT c = 0; c < newCacheSize; c++)
+		{
+			UINT v = newCache[c];
+			if (c < VERTEX_CACHE_SIZE)
+				cachePosition[v] = (int)c;
+
+			float score = VertexScore(cachePosition[v], numActive[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			UINT begin = adjacencyOffset[v];
+			UINT end = begin + numActive[v];
+			for (UINT a = begin; a < end; a++)
+			{
+				UINT adjacent = adjacency[a];
+				triangleScore[adjacent] += delta;
+
+				if (triangleScore[adjacent] > bestScore)
+				{
+					bestScore = triangleScore[adjacent];
+					bestTriangle = adjacent;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(SubsetRemap& remap)
+{
+	UINT numVertices = (UINT)remap.Vertices.size();
+
+	std::vector<UINT> newIndex(numVertices, (UINT)-1);
+	std::vector<UINT> vertices;
+	vertices.reserve(numVertices);
+
+	for (size_t i = 0, n = remap.Indices.size(); i < n; i++)
+	{
+		UINT& v = newIndex[remap.Indices[i]];
+		if (v == (UINT)-1)
+		{
+			v = (UINT)vertices.size();
+			vertices.push_back(remap.Vertices[remap.Indices[i]]);
+		}
+		remap.Indices[i] = v;
+	}
+
+	remap.Vertices.swap(vertices);
+}
+
+float MeshOptimizer::ComputeACMR(const std::vector<UINT>& indices, UINT numVertices, UINT cacheSize)
+{
+	size_t numTriangles = indices.size() / 3;
+	if (numTriangles == 0)
+		return 0.0f;
+
+	// timestamp of the vertex entering the FIFO
+	std::vector<size_t> timestamp(numVertices, 0);
+	size_t time = cacheSize + 1;
+	size_t misses = 0;
+
+	for (size_t i = 0; i < numTriangles * 3; i++)
+	{
+		UINT v = indices[i];
+		if (time - timestamp[v] > cacheSize)
+		{
+			timestamp[v] = time++;
+			misses++;
+		}
+	}
+
+	return (float)misses / numTriangles;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "SubsetDecoder.h"
+
+// LRU cache size the triangle order is optimized for
+#define VERTEX_CACHE_SIZE 32
+
+// FIFO cache size used to report the ACMR
+#define ACMR_CACHE_SIZE 16
+
+// Index buffer optimizations on a remapped subset
+class MeshOptimizer
+{
+public:
+	// reorder triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm)
+	static void OptimizeVertexCache(std::vector<UINT>& indices, UINT numVertices);
+
+	// renumber vertices in first-use order of the triangles for fetch locality
+	static void OptimizeVertexFetch(SubsetRemap& remap);
+
+	// average cache miss ratio: transformed vertices per triangle on a FIFO cache
+	static float ComputeACMR(const std::vector<UINT>& indices, UINT numVertices, UINT cacheSize = ACMR_CACHE_SIZE);
+};
@@ -0,0 +1,553 @@
+#include "MeshProcessor.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Skinning.h"
+#include "NormalGenerator.h"
+#include "MatrixMath.h"
+#include "ParallelFor.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+// a mesh vertex position, to find the vertices shared by several subsets or split on uv seams
+struct VertexPosition
+{
+	UINT Key[3];
+	UINT Subset;
+	UINT Vertex;
+
+	bool operator<(const VertexPosition& p) const
+	{
+		if (Key[0] != p.Key[0])
+			return Key[0] < p.Key[0];
+		if (Key[1] != p.Key[1])
+			return Key[1] < p.Key[1];
+		return Key[2] < p.Key[2];
+	}
+
+	bool SamePosition(const VertexPosition& p) const
+	{
+		return Key[0] == p.Key[0] && Key[1] == p.Key[1] && Key[2] == p.Key[2];
+	}
+};
+
+static VertexPosition MakePosition(const float *position, UINT subset, UINT vertex)
+{
+	VertexPosition p;
+	// +0.0f: -0 and 0 are the same position
+	float key[3] = { position[0] + 0.0f, position[1] + 0.0f, position[2] + 0.0f };
+	memcpy(p.Key, key, sizeof(p.Key));
+	p.Subset = subset;
+	p.Vertex = vertex;
+	return p;
+}
+
+MeshProcessor::MeshProcessor(SDKMesh *mesh)
+	:m_sdkMesh(mesh),
+	m_optimizeVertexCache(false),
+	m_skinning(false),
+	m_skinTime(0.0),
+	m_generateNormals(false),
+	m_creaseAngle(0.0f),
+	m_level(0)
+{
+}
+
+MeshProcessor::~MeshProcessor()
+{
+}
+
+bool MeshProcessor::Process(int numThreads)
+{
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+	UINT numLevels = GetNumLevels();
+
+	m_remaps.clear();
+	m_remaps.resize(numLevels);
+	m_acmrBefore.clear();
+	m_acmrBefore.resize(numLevels);
+	m_acmrAfter.clear();
+	m_acmrAfter.resize(numLevels);
+	m_normals.clear();
+	m_normals.resize(numLevels);
+
+	UpdateBones();
+
+	// flatten (mesh, subset) to spread the work
+	std::vector<std::pair<UINT, UINT> > items;
+	for (UINT level = 0; level < numLevels; ++level)
+	{
+		m_remaps[level].resize(numMeshes);
+		m_acmrBefore[level].resize(numMeshes);
+		m_acmrAfter[level].resize(numMeshes);
+		m_normals[level].resize(numMeshes);
+
+		for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+		{
+			UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+			m_remaps[level][meshIdx].resize(numSubsets);
+			m_acmrBefore[level][meshIdx].resize(numSubsets, 0.0f);
+			m_acmrAfter[level][meshIdx].resize(numSubsets, 0.0f);
+
+			if (level == 0)
+			{
+				for (UINT i = 0; i < numSubsets; ++i)
+					items.push_back(std::make_pair(meshIdx, i));
+			}
+		}
+	}
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	// one decoder per thread, reused while the thread stays on the same mesh
+	std::vector<SubsetDecoder*> decoders(numThreads, (SubsetDecoder*)NULL);
+	std::vector<UINT> decoderMesh(numThreads, 0);
+	std::atomic<bool> success(true);
+
+	auto getDecoder = [&](UINT meshIdx, int thread)
+	{
+		if (decoders[thread] == NULL || decoderMesh[thread] != meshIdx)
+		{
+			delete decoders[thread];
+			decoders[thread] = new SubsetDecoder(m_sdkMesh, meshIdx);
+			decoderMesh[thread] = meshIdx;
+		}
+		return decoders[thread];
+	};
+
+	// remap, across subsets
+	ParallelFor(items.size(), numThreads, [&](size_t item, int thread)
+	{
+		UINT meshIdx = items[item].first;
+		UINT subsetIdx = items[item].second;
+
+		SubsetDecoder *decoder = getDecoder(meshIdx, thread);
+		if (!decoder->Remap(m_sdkMesh->GetSubset(meshIdx, subsetIdx), m_remaps[0][meshIdx][subsetIdx]))
+			success = false;
+	});
+
+	// LOD chain, across meshes (the shared vertices of the subsets are locked)
+	if (!m_lodRatios.empty())
+	{
+		ParallelFor(numMeshes, numThreads, [&](size_t meshIdx, int thread)
+		{
+			SimplifyMesh((UINT)meshIdx, getDecoder((UINT)meshIdx, thread));
+		});
+	}
+
+	// normals of the meshes without NORMAL element, from the triangles of each level
+	if (m_generateNormals && success)
+	{
+		for (UINT level = 0; level < numLevels; ++level)
+		{
+			for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+			{
+				SubsetDecoder decoder(m_sdkMesh, meshIdx);
+				if (!decoder.HasNormal() && decoder.HasPosition())
+					GenerateNormals(level, meshIdx, numThreads);
+			}
+		}
+	}
+
+	// vertex cache, across all levels & subsets
+	if (m_optimizeVertexCache)
+	{
+		ParallelFor(items.size() * numLevels, numThreads, [&](size_t item, int)
+		{
+			UINT level = (UINT)(item / items.size());
+			UINT meshIdx = items[item % items.size()].first;
+			UINT subsetIdx = items[item % items.size()].second;
+
+			SubsetRemap& remap = m_remaps[level][meshIdx][subsetIdx];
+			UINT numVertices = (UINT)remap.Vertices.size();
+
+			m_acmrBefore[level][meshIdx][subsetIdx] = MeshOptimizer::ComputeACMR(remap.Indices, numVertices);
+
+			MeshOptimizer::OptimizeVertexCache(remap.Indices, numVertices);
+			MeshOptimizer::OptimizeVertexFetch(remap);
+
+			m_acmrAfter[level][meshIdx][subsetIdx] = MeshOptimizer::ComputeACMR(remap.Indices, numVertices);
+		});
+	}
+
+	for (size_t i = 0; i < decoders.size(); i++)
+		delete decoders[i];
+
+	return success;
+}
+
+void MeshProcessor::SimplifyMesh(UINT meshID, SubsetDecoder *decoder)
+{
+	UINT numSubsets = m_sdkMesh->GetNumSubsets(meshID);
+	UINT numLevels = GetNumLevels();
+
+	// decoded positions of each subset
+	std::vector<std::vector<float> > positions(numSubsets);
+	std::vector<VertexPosition> sorted;
+
+	for (UINT i = 0; i < numSubsets; ++i)
+	{
+		const SubsetRemap& remap = m_remaps[0][meshID][i];
+		UINT numVertices = (UINT)remap.Vertices.size();
+
+		positions[i].resize(numVertices * 3);
+		if (!decoder->DecodePositions(remap.Vertices.data(), numVertices, positions[i].data()))
+			positions[i].assign(numVertices * 3, 0.0f);
+
+		for (UINT v = 0; v < numVertices; v++)
+			sorted.push_back(MakePosition(&positions[i][v * 3], i, v));
+	}
+
+	// lock the vertices at the same position as another one:
+	// material boundaries (other subset) and uv seams (same subset)
+	std::vector<std::vector<BYTE> > locked(numSubsets);
+	for (UINT i = 0; i < numSubsets; ++i)
+		locked[i].resize(m_remaps[0][meshID][i].Vertices.size(), 0);
+
+	std::sort(sorted.begin(), sorted.end());
+	for (size_t i = 0, n = sorted.size(); i < n;)
+	{
+		size_t j = i + 1;
+		while (j < n && sorted[j].SamePosition(sorted[i]))
+			j++;
+
+		if (j - i > 1)
+		{
+			for (size_t k = i; k < j; k++)
+				locked[sorted[k].Subset][sorted[k].Vertex] = 1;
+		}
+
+		i = j;
+	}
+
+	for (UINT i = 0; i < numSubsets; ++i)
+	{
+		SDKMESH_SUBSET *subset = m_sdkMesh->GetSubset(meshID, i);
+		const SubsetRemap& remap = m_remaps[0][meshID][i];
+		UINT numVertices = (UINT)remap.Vertices.size();
+
+		MeshSimplifier::LockBorders(remap.Indices, numVertices, locked[i]);
+
+		size_t numIndices = remap.Indices.size();
+
+		// each level is simplified from the previous one
+		for (UINT level = 1; level < numLevels; ++level)
+		{
+			SubsetRemap& lod = m_remaps[level][meshID][i];
+			lod = m_remaps[level - 1][meshID][i];
+
+			if (subset->PrimitiveType != PT_TRIANGLE_LIST)
+				continue;
+
+			size_t target = (size_t)(numIndices / 3 * m_lodRatios[level - 1]) * 3;
+			MeshSimplifier::Simplify(lod.Indices, positions[i].data(), numVertices, locked[i], target);
+		}
+
+		// drop the vertices not used anymore
+		for (UINT level = 1; level < numLevels; ++level)
+			MeshOptimizer::OptimizeVertexFetch(m_remaps[level][meshID][i]);
+	}
+}
+
+bool MeshProcessor::HasMissingNormals()
+{
+	for (UINT meshIdx = 0, n = m_sdkMesh->GetNumMeshes(); meshIdx < n; ++meshIdx)
+	{
+		SubsetDecoder decoder(m_sdkMesh, meshIdx);
+		if (!decoder.HasNormal() && decoder.HasPosition())
+			return true;
+	}
+	return false;
+}
+
+void MeshProcessor::GenerateNormals(UINT level, UINT meshID, int numThreads)
+{
+	std::vector<SubsetRemap>& remaps = m_remaps[level][meshID];
+	GeneratedNormals& generated = m_normals[level][meshID];
+
+	// vertex ids of the remaps: source vertices, or cache stream vertices
+	UINT numVertices = 0;
+	for (size_t i = 0; i < remaps.size(); ++i)
+	{
+		for (size_t j = 0, n = remaps[i].Vertices.size(); j < n; j++)
+		{
+			if (remaps[i].Vertices[j] >= numVertices)
+				numVertices = remaps[i].Vertices[j] + 1;
+		}
+	}
+
+	// triangles of all subsets & positions, in vertex id space
+	SubsetDecoder decoder(m_sdkMesh, meshID);
+	std::vector<UINT> triangles;
+	std::vector<float> positions((size_t)numVertices * 3, 0.0f);
+	std::vector<float> decoded;
+
+	for (size_t i = 0; i < remaps.size(); ++i)
+	{
+		const SubsetRemap& remap = remaps[i];
+		UINT count = (UINT)remap.Vertices.size();
+
+		decoded.resize((size_t)count * 3);
+		if (!decoder.DecodePositions(remap.Vertices.data(), count, decoded.data()))
+			return;
+
+		for (UINT v = 0; v < count; v++)
+			memcpy(&positions[(size_t)remap.Vertices[v] * 3], &decoded[(size_t)v * 3], sizeof(float) * 3);
+
+		for (size_t j = 0, n = remap.Indices.size(); j < n; j++)
+			triangles.push_back(remap.Vertices[remap.Indices[j]]);
+	}
+
+	// weld by position: the vertices split at uv seams & material borders share their normal,
+	// only -crease splits the vertices again
+	std::vector<VertexPosition> sorted;
+	std::vector<UINT> weld(numVertices);
+	for (UINT v = 0; v < numVertices; v++)
+	{
+		weld[v] = v;
+		sorted.push_back(MakePosition(&positions[(size_t)v * 3], 0, v));
+	}
+
+	std::sort(sorted.begin(), sorted.end());
+	for (size_t i = 0, n = sorted.size(); i < n;)
+	{
+		size_t j = i + 1;
+		while (j < n && sorted[j].SamePosition(sorted[i]))
+			weld[sorted[j++].Vertex] = sorted[i].Vertex;
+
+		i = j;
+	}
+
+	std::vector<UINT> welded(triangles.size());
+	for (size_t c = 0, n = triangles.size(); c < n; c++)
+		welded[c] = weld[triangles[c]];
+
+	generated.NumVertices = numVertices;
+	generated.Sources.clear();
+
+	if (m_creaseAngle <= 0.0f)
+	{
+		std::vector<float> normals;
+		NormalGenerator::Generate(welded, positions.data(), numVertices, numThreads, normals);
+
+		generated.Normals.resize((size_t)numVertices * 3);
+		for (UINT v = 0; v < numVertices; v++)
+			memcpy(&generated.Normals[(size_t)v * 3], &normals[(size_t)weld[v] * 3], sizeof(float) * 3);
+		return;
+	}
+
+	// the corner normals average the faces around the welded vertex, the corners keep their own vertex
+	std::vector<float> cornerNormals;
+	NormalGenerator::GenerateCorners(welded, positions.data(), numVertices, m_creaseAngle, numThreads, cornerNormals);
+
+	// one vertex id per distinct corner normal of each vertex, chained from the source id
+	generated.Normals.assign((size_t)numVertices * 3, 0.0f);
+	std::vector<UINT> next(numVertices, INVALID_SUBSET);
+	std::vector<BYTE> used(numVertices, 0);
+	std::vector<UINT> cornerIds(triangles.size());
+
+	for (size_t c = 0, n = triangles.size(); c < n; c++)
+	{
+		UINT v = triangles[c];
+		const float *cn = &cornerNormals[c * 3];
+
+		if (!used[v])
+		{
+			used[v] = 1;
+			memcpy(&generated.Normals[(size_t)v * 3], cn, sizeof(float) * 3);
+			cornerIds[c] = v;
+			continue;
+		}
+
+		UINT id = v;
+		for (;;)
+		{
+			const float *gn = &generated.Normals[(size_t)id * 3];
+			if (gn[0] * cn[0] + gn[1] * cn[1] + gn[2] * cn[2] >= 0.99999f)
+				break;
+
+			if (next[id] == INVALID_SUBSET)
+			{
+				UINT split = numVertices + (UINT)generated.Sources.size();
+				generated.Sources.push_back(v);
+				generated.Normals.insert(generated.Normals.end(), cn, cn + 3);
+				next.push_back(INVALID_SUBSET);
+				next[id] = split;
+				id = split;
+				break;
+			}
+
+			id = next[id];
+		}
+
+		cornerIds[c] = id;
+	}
+
+	if (generated.Sources.empty())
+		return;
+
+	// renumber the subsets with the split vertices
+	std::vector<UINT> lookup(numVertices + generated.Sources.size(), INVALID_SUBSET);
+	size_t corner = 0;
+
+	for (size_t i = 0; i < remaps.size(); ++i)
+	{
+		SubsetRemap& remap = remaps[i];
+		remap.Vertices.clear();
+
+		for (size_t j = 0, n = remap.Indices.size(); j < n; j++)
+		{
+			UINT id = cornerIds[corner++];
+			if (lookup[id] == INVALID_SUBSET)
+			{
+				lookup[id] = (UINT)remap.Vertices.size();
+				remap.Vertices.push_back(id);
+			}
+			remap.Indices[j] = lookup[id];
+		}
+
+		for (size_t j = 0, n = remap.Vertices.size(); j < n; j++)
+			lookup[remap.Vertices[j]] = INVALID_SUBSET;
+	}
+}
+
+const GeneratedNormals* MeshProcessor::GetGeneratedNormals(UINT meshID)
+{
+	if (m_level >= m_normals.size() ||
+		meshID >= m_normals[m_level].size() ||
+		m_normals[m_level][meshID].Normals.empty())
+		return NULL;
+
+	return &m_normals[m_level][meshID];
+}
+
+void MeshProcessor::UpdateBones()
+{
+	m_bones.clear();
+
+	if (!m_skinning)
+		return;
+
+	D3DXMATRIX identity;
+	MatrixIdentity(&identity);
+
+	m_sdkMesh->TransformBindPose(&identity);
+	m_sdkMesh->TransformMesh(&identity, m_skinTime);
+
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+	m_bones.resize(numMeshes);
+
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+		Skinning::GetBones(m_sdkMesh, meshIdx, m_bones[meshIdx]);
+}
+
+const D3DXMATRIX* MeshProcessor::GetBones(UINT meshID, UINT *numBones)
+{
+	*numBones = 0;
+
+	if (meshID >= m_bones.size() || m_bones[meshID].empty())
+		return NULL;
+
+	*numBones = (UINT)m_bones[meshID].size();
+	return m_bones[meshID].data();
+}
+
+const SubsetRemap* MeshProcessor::GetRemap(UINT meshID, UINT subsetID)
+{
+	if (m_level >= m_remaps.size() ||
+		meshID >= m_remaps[m_level].size() ||
+		subsetID >= m_remaps[m_level][meshID].size())
+		return NULL;
+
+	return &m_remaps[m_level][meshID][subsetID];
+}
+
+void MeshProcessor::PrintStats()
+{
+	if (m_skinning)
+	{
+		LogDebug() << "\n# Skinning (time " << m_skinTime << ", key " << m_sdkMesh->GetAnimationKeyFromTime(m_skinTime) << "):\n";
+
+		for (size_t meshIdx = 0; meshIdx < m_bones.size(); ++meshIdx)
+		{
+			SubsetDecoder decoder(m_sdkMesh, (UINT)meshIdx);
+			LogDebug() << " Mesh " << meshIdx << ": " << m_bones[meshIdx].size() << " bones";
+			if (!decoder.HasSkin())
+				LogDebug() << " (no BLENDWEIGHT/BLENDINDICES, not skinned)";
+			LogDebug() << "\n";
+		}
+	}
+
+	for (size_t meshIdx = 0; m_generateNormals && !m_normals.empty() && meshIdx < m_normals[0].size(); ++meshIdx)
+	{
+		const GeneratedNormals& generated = m_normals[0][meshIdx];
+		if (generated.Normals.empty())
+			continue;
+
+		if (meshIdx == 0 || m_normals[0][meshIdx - 1].Normals.empty())
+			LogDebug() << "\n# Generated normals:\n";
+
+		LogDebug() << " Mesh " << meshIdx << ": " << generated.NumVertices << " vertices, " << generated.Sources.size() << " split on creases\n";
+	}
+
+	for (size_t level = 1; level < m_remaps.size(); ++level)
+	{
+		UINT64 numTriangles = 0;
+		UINT64 numLevelTriangles = 0;
+
+		for (size_t meshIdx = 0; meshIdx < m_remaps[level].size(); ++meshIdx)
+		{
+			for (size_t i = 0; i < m_remaps[level][meshIdx].size(); ++i)
+			{
+				numTriangles += m_remaps[0][meshIdx][i].Indices.size() / 3;
+				numLevelTriangles += m_remaps[level][meshIdx][i].Indices.size() / 3;
+			}
+		}
+
+		if (level == 1)
+			LogInfo() << "\n# LOD simplification:\n";
+
+		LogInfo() << " LOD " << level << " (" << m_lodRatios[level - 1] << "): " << numTriangles << " -> " << numLevelTriangles << " triangles\n";
+	}
+
+	if (!m_optimizeVertexCache)
+		return;
+
+	LogInfo() << "\n# Vertex cache optimization (ACMR, FIFO " << ACMR_CACHE_SIZE << "):\n";
+
+	for (size_t level = 0; level < m_remaps.size(); ++level)
+	{
+		double trianglesBefore = 0.0;
+		double trianglesAfter = 0.0;
+		UINT64 numTriangles = 0;
+
+		for (size_t meshIdx = 0; meshIdx < m_remaps[level].size(); ++meshIdx)
+		{
+			for (size_t i = 0; i < m_remaps[level][meshIdx].size(); ++i)
+			{
+				UINT64 n = m_remaps[level][meshIdx][i].Indices.size() / 3;
+				float before = m_acmrBefore[level][meshIdx][i];
+				float after = m_acmrAfter[level][meshIdx][i];
+
+				if (level == 0)
+					LogDebug() << " Mesh " << meshIdx << " - Subset " << i << ": " << before << " -> " << after << "\n";
+
+				trianglesBefore += before * n;
+				trianglesAfter += after * n;
+				numTriangles += n;
+			}
+		}
+
+		if (numTriangles > 0)
+		{
+			if (level == 0)
+				LogInfo() << " Total: ";
+			else
+				LogInfo() << " LOD " << level << ": ";
+
+			LogInfo() << trianglesBefore / numTriangles << " -> " << trianglesAfter / numTriangles << "\n";
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "SubsetDecoder.h"
+
+// Smooth normals generated for a mesh without NORMAL element.
+// Vertex ids >= NumVertices are copies of Sources[id - NumVertices] split on a crease.
+struct GeneratedNormals
+{
+	UINT NumVertices;
+	std::vector<UINT> Sources;
+
+	// 3 floats per vertex id
+	std::vector<float> Normals;
+};
+
+// Optional per-subset processing stages, run on all subsets in parallel before writing.
+// The writers read the processed remaps through SubsetDecoder.
+class MeshProcessor
+{
+protected:
+	SDKMesh *m_sdkMesh;
+
+	bool m_optimizeVertexCache;
+
+	// bake the pose of the frames at m_skinTime into positions & normals
+	bool m_skinning;
+	double m_skinTime;
+
+	// bone matrices (frame world x inverse bind) of each frame influence, per mesh
+	std::vector<std::vector<D3DXMATRIX> > m_bones;
+
+	// generate the normals of the meshes without NORMAL element, split on the crease angle (radians, 0: smooth)
+	bool m_generateNormals;
+	float m_creaseAngle;
+
+	// per level & mesh, empty Normals if the mesh has its own normals
+	std::vector<std::vector<GeneratedNormals> > m_normals;
+
+	// triangle ratio of each LOD level after the full detail level 0
+	std::vector<float> m_lodRatios;
+
+	// processed remap of each subset, per level & mesh
+	std::vector<std::vector<std::vector<SubsetRemap> > > m_remaps;
+
+	// ACMR of each subset before/after the vertex cache optimization, per level & mesh
+	std::vector<std::vector<std::vector<float> > > m_acmrBefore;
+	std::vector<std::vector<std::vector<float> > > m_acmrAfter;
+
+	UINT m_level;
+
+public:
+	MeshProcessor(SDKMesh *mesh);
+
+	virtual ~MeshProcessor();
+
+	void SetOptimizeVertexCache(bool b)
+	{
+		m_optimizeVertexCache = b;
+	}
+
+	// simplify each subset to these ratios of its triangles (1 LOD level per ratio)
+	void SetLODRatios(const std::vector<float>& ratios)
+	{
+		m_lodRatios = ratios;
+	}
+
+	// skin the vertices by the frame pose at this animation time (bind pose without animation)
+	void SetSkinning(bool b, double time = 0.0)
+	{
+		m_skinning = b;
+		m_skinTime = time;
+	}
+
+	void SetGenerateNormals(bool b, float creaseAngle = 0.0f)
+	{
+		m_generateNormals = b;
+		m_creaseAngle = creaseAngle;
+	}
+
+	bool IsEnabled()
+	{
+		return m_optimizeVertexCache || m_skinning || !m_lodRatios.empty() || (m_generateNormals && HasMissingNormals());
+	}
+
+	// a mesh has no NORMAL element
+	bool HasMissingNormals();
+
+	UINT GetNumLevels()
+	{
+		return (UINT)m_lodRatios.size() + 1;
+	}
+
+	// level returned by GetRemap
+	void SetLevel(UINT level)
+	{
+		m_level = level;
+	}
+
+	bool Process(int numThreads);
+
+	const SubsetRemap* GetRemap(UINT meshID, UINT subsetID);
+
+	// NULL if the mesh is not skinned
+	const D3DXMATRIX* GetBones(UINT meshID, UINT *numBones);
+
+	// NULL if the normals of the mesh are not generated
+	const GeneratedNormals* GetGeneratedNormals(UINT meshID);
+
+	void PrintStats();
+
+protected:
+	void SimplifyMesh(UINT meshID, SubsetDecoder *decoder);
+
+	void UpdateBones();
+
+	void GenerateNormals(UINT level, UINT meshID, int numThreads);
+};
@@ -0,0 +1,301 @@
+#include "MeshSimplifier.h"
+
+#include <math.h>
+#include <queue>
+#include <algorithm>
+
+// symmetric 4x4 error quadric
+struct Quadric
+{
+	double a2, ab, ac, ad;
+	double b2, bc, bd;
+	double c2, cd;
+	double d2;
+
+	Quadric()
+	{
+		a2 = ab = ac = ad = b2 = bc = bd = c2 = cd = d2 = 0.0;
+	}
+
+	void AddPlane(double a, double b, double c, double d, double w)
+	{
+		a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+		b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+		c2 += w * c * c; cd += w * c * d;
+		d2 += w * d * d;
+	}
+
+	void Add(const Quadric& q)
+	{
+		a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+		b2 += q.b2; bc += q.bc; bd += q.bd;
+		c2 += q.c2; cd += q.cd;
+		d2 += q.d2;
+	}
+
+	double Error(const float *p) const
+	{
+		double x = p[0], y = p[1], z = p[2];
+		return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+			b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+			c2 * z * z + 2.0 * cd * z +
+			d2;
+	}
+};
+
+struct Collapse
+{
+	double Cost;
+	UINT From;
+	UINT To;
+	UINT StampFrom;
+	UINT StampTo;
+
+	bool operator<(const Collapse& c) const
+	{
+		// lowest cost on top of the priority queue
+		return Cost > c.Cost;
+	}
+};
+
+static void TriangleNormal(const float *p0, const float *p1, const float *p2, double *n)
+{
+	double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+void MeshSimplifier::LockBorders(const std::vector<UINT>& indices, UINT numVertices, std::vector<BYTE>& locked)
+{
+	if (locked.size() != numVertices)
+		locked.resize(numVertices, 0);
+
+	// an edge used by a single triangle is on the border
+	std::vector<UINT64> edges;
+	edges.reserve(indices.size());
+
+	for (size_t i = 0, n = indices.size() / 3 * 3; i < n; i += 3)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			UINT a = indices[i + k];
+			UINT b = indices[i + (k + 1) % 3];
+			if (a > b)
+				std::swap(a, b);
+			edges.push_back(((UINT64)a << 32) | b);
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+
+	for (size_t i = 0, n = edges.size(); i < n;)
+	{
+		size_t j = i + 1;
+		while (j < n && edges[j] == edges[i])
+			j++;
+
+		if (j - i == 1)
+		{
+			locked[(UINT)(edges[i] >> 32)] = 1;
+			locked[(UINT)(edges[i] & 0xFFFFFFFF)] = 1;
+		}
+
+		i = j;
+	}
+}
+
+size_t MeshSimplifier::Simplify(std::vector<UINT>& indices, const float *positions, UINT numVertices,
+	const std::vector<BYTE>& locked, size_t targetIndexCount)
+{
+	size_t numTriangles = indices.size() / 3;
+	size_t numLive = numTriangles;
+
+	if (numTriangles * 3 <= targetIndexCount)
+		return indices.size();
+
+	// plane quadrics weighted by triangle area
+	std::vector<Quadric> quadrics(numVertices);
+	std::vector<std::vector<UINT> > vertexTriangles(numVertices);
+
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		UINT v[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+
+		double n[3];
+		TriangleNormal(positions + v[0] * 3, positions + v[1] * 3, positions + v[2] * 3, n);
+
+		double l = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (l > 0.0)
+		{
+			n[0] /= l;
+			n[1] /= l;
+			n[2] /= l;
+
+			const float *p = positions + v[0] * 3;
+			double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+
+			for (int k = 0; k < 3; k++)
+				quadrics[v[k]].AddPlane(n[0], n[1], n[2], d, l * 0.5);
+		}
+
+		for (int k = 0; k < 3; k++)
+			vertexTriangles[v[k]].push_back((UINT)t);
+	}
+
+	std::vector<BYTE> alive(numTriangles, 1);
+	std::vector<BYTE> removed(numVertices, 0);
+	std::vector<UINT> stamp(numVertices, 0);
+
+	std::priority_queue<Collapse> heap;
+
+	// queue the collapse from -> to
+	auto push = [&](UINT from, UINT to)
+	{
+		if (locked[from])
+			return;
+
+		Quadric q = quadrics[from];
+		q.Add(quadrics[to]);
+
+		Collapse c;
+		c.Cost = q.Error(positions + to * 3);
+		c.From = from;
+		c.To = to;
+		c.StampFrom = stamp[from];
+		c.StampTo = stamp[to];
+		heap.push(c);
+	};
+
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			UINT a = indices[t * 3 + k];
+			UINT b = indices[t * 3 + (k + 1) % 3];
+			push(a, b);
+			push(b, a);
+		}
+	}
+
+	while (numLive * 3 > targetIndexCount && !heap.empty())
+	{
+		Collapse c = heap.top();
+		heap.pop();
+
+		UINT a = c.From;
+		UINT b = c.To;
+
+		if (removed[a] || removed[b] || c.StampFrom != stamp[a] || c.StampTo != stamp[b])
+			continue;
+
+		// the edge must still exist and moving 'a' onto 'b' must not flip a triangle
+		bool adjacent = false;
+		bool flip = false;
+
+		const std::vector<UINT>& triangles = vertexTriangles[a];
+		for (size_t i = 0, n = triangles.size(); i < n && !flip; i++)
+		{
+			UINT t = triangles[i];
+			if (!alive[t])
+				continue;
+
+			UINT *v = &indices[t * 3];
+			if (v[0] == b || v[1] == b || v[2] == b)
+			{
+				adjacent = true;
+				continue;
+			}
+
+			const float *p[3];
+			const float *q[3];
+			for (int k = 0; k < 3; k++)
+			{
+				p[k] = positions + v[k] * 3;
+				q[k] = v[k] == a ? positions + b * 3 : p[k];
+			}
+
+			double n0[3], n1[3];
+			TriangleNormal(p[0], p[1], p[2], n0);
+			TriangleNormal(q[0], q[1], q[2], n1);
+
+			double l0 = sqrt(n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]);
+			double l1 = sqrt(n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+			double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+
+			if (l1 <= 0.0 || dot <= 1e-3 * l0 * l1)
+				flip = true;
+		}
+
+		if (!adjacent || flip)
+			continue;
+
+		// collapse a -> b
+		for (size_t i = 0, n = triangles.size(); i < n; i++)
+		{
+			UINT t = triangles[i];
+			if (!alive[t])
+				continue;
+
+			UINT *v = &indices[t * 3];
+			if (v[0] == b || v[1] == b || v[2] == b)
+			{
+				alive[t] = 0;
+				numLive--;
+				continue;
+			}
+
+			for (int k = 0; k < 3; k++)
+			{
+				if (v[k] == a)
+					v[k] = b;
+			}
+			vertexTriangles[b].push_back(t);
+		}
+
+		removed[a] = 1;
+		vertexTriangles[a].clear();
+		quadrics[b].Add(quadrics[a]);
+		stamp[b]++;
+
+		// drop the dead triangles of b and queue its new edges
+		std::vector<UINT>& triangleB = vertexTriangles[b];
+		size_t count = 0;
+		for (size_t i = 0, n = triangleB.size(); i < n; i++)
+		{
+			UINT t = triangleB[i];
+			if (!alive[t])
+				continue;
+
+			triangleB[count++] = t;
+
+			const UINT *v = &indices[t * 3];
+			for (int k = 0; k < 3; k++)
+			{
+				if (v[k] != b)
+				{
+					push(b, v[k]);
+					push(v[k], b);
+				}
+			}
+		}
+		triangleB.resize(count);
+	}
+
+	// compact the triangle list
+	size_t write = 0;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		if (!alive[t])
+			continue;
+
+		indices[write++] = indices[t * 3];
+		indices[write++] = indices[t * 3 + 1];
+		indices[write++] = indices[t * 3 + 2];
+	}
+	indices.resize(write);
+
+	return write;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "SubsetDecoder.h"
+
+// Quadric error edge collapse (Garland & Heckbert) restricted to the existing vertices,
+// so the remaining vertices keep their decoded attributes.
+class MeshSimplifier
+{
+public:
+	// simplify a triangle list in place until it has at most targetIndexCount indices
+	// positions: float3 per vertex, locked vertices are never collapsed
+	// returns the number of indices left
+	static size_t Simplify(std::vector<UINT>& indices, const float *positions, UINT numVertices,
+		const std::vector<BYTE>& locked, size_t targetIndexCount);
+
+	// lock the vertices on open borders of a triangle list
+	static void LockBorders(const std::vector<UINT>& indices, UINT numVertices, std::vector<BYTE>& locked);
+};
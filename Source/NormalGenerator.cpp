@@ -0,0 +1,198 @@
+#include "NormalGenerator.h"
+#include "ParallelFor.h"
+
+#include <math.h>
+#include <string.h>
+
+// triangles per partial buffer before another thread is worth its buffer
+#define NORMAL_PARTIAL_TRIANGLES 16384
+
+static float CornerAngle(const float *a, const float *b, const float *c)
+{
+	// angle at a in the triangle a, b, c
+	float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	float v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+	float lu = sqrtf(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+	float lv = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if (lu == 0.0f || lv == 0.0f)
+		return 0.0f;
+
+	float d = (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]) / (lu * lv);
+	if (d > 1.0f)
+		d = 1.0f;
+	if (d < -1.0f)
+		d = -1.0f;
+
+	return acosf(d);
+}
+
+// cross product of the edges (length: twice the area) and the 3 corner angles
+static void FaceWeights(const float *positions, const UINT *tri, float *cross, float *angles)
+{
+	const float *p0 = positions + (size_t)tri[0] * 3;
+	const float *p1 = positions + (size_t)tri[1] * 3;
+	const float *p2 = positions + (size_t)tri[2] * 3;
+
+	float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+	cross[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	cross[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	cross[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+	angles[0] = CornerAngle(p0, p1, p2);
+	angles[1] = CornerAngle(p1, p2, p0);
+	angles[2] = CornerAngle(p2, p0, p1);
+}
+
+static void Normalize(float *n)
+{
+	float l = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (l > 0.0f)
+	{
+		n[0] /= l;
+		n[1] /= l;
+		n[2] /= l;
+	}
+}
+
+void NormalGenerator::Generate(const std::vector<UINT>& triangles, const float *positions, UINT numVertices,
+	int numThreads, std::vector<float>& normals)
+{
+	size_t numTriangles = triangles.size() / 3;
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	size_t numParts = numTriangles / NORMAL_PARTIAL_TRIANGLES + 1;
+	if (numParts > (size_t)numThreads)
+		numParts = (size_t)numThreads;
+
+	// part 0 accumulates in the output, the others in their own partial buffer
+	normals.assign((size_t)numVertices * 3, 0.0f);
+	std::vector<std::vector<float> > partials(numParts - 1);
+
+	ParallelFor(numParts, (int)numParts, [&](size_t part, int)
+	{
+		std::vector<float>& sum = part == 0 ? normals : partials[part - 1];
+		if (part > 0)
+			sum.assign((size_t)numVertices * 3, 0.0f);
+
+		size_t begin = numTriangles * part / numParts;
+		size_t end = numTriangles * (part + 1) / numParts;
+
+		float cross[3], angles[3];
+		for (size_t t = begin; t < end; t++)
+		{
+			const UINT *tri = &triangles[t * 3];
+			FaceWeights(positions, tri, cross, angles);
+
+			for (int k = 0; k < 3; k++)
+			{
+				float *n = &sum[(size_t)tri[k] * 3];
+				n[0] += cross[0] * angles[k];
+				n[1] += cross[1] * angles[k];
+				n[2] += cross[2] * angles[k];
+			}
+		}
+	});
+
+	// reduce the partials, across vertex blocks
+	const size_t blockSize = 4096;
+	size_t numBlocks = ((size_t)numVertices + blockSize - 1) / blockSize;
+
+	ParallelFor(numBlocks, numThreads, [&](size_t block, int)
+	{
+		size_t begin = block * blockSize;
+		size_t end = begin + blockSize < numVertices ? begin + blockSize : numVertices;
+
+		for (size_t p = 0; p < partials.size(); p++)
+		{
+			const float *src = partials[p].data();
+			for (size_t i = begin * 3; i < end * 3; i++)
+				normals[i] += src[i];
+		}
+
+		for (size_t v = begin; v < end; v++)
+			Normalize(&normals[v * 3]);
+	});
+}
+
+void NormalGenerator::GenerateCorners(const std::vector<UINT>& triangles, const float *positions, UINT numVertices,
+	float creaseAngle, int numThreads, std::vector<float>& cornerNormals)
+{
+	size_t numTriangles = triangles.size() / 3;
+	size_t numCorners = numTriangles * 3;
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	// face weights, each triangle writes its own slots
+	std::vector<float> cross(numTriangles * 3);
+	std::vector<float> faceNormals(numTriangles * 3);
+	std::vector<float> angles(numCorners);
+
+	const size_t blockSize = 4096;
+	size_t numBlocks = (numTriangles + blockSize - 1) / blockSize;
+
+	ParallelFor(numBlocks, numThreads, [&](size_t block, int)
+	{
+		size_t end = (block + 1) * blockSize < numTriangles ? (block + 1) * blockSize : numTriangles;
+		for (size_t t = block * blockSize; t < end; t++)
+		{
+			FaceWeights(positions, &triangles[t * 3], &cross[t * 3], &angles[t * 3]);
+
+			memcpy(&faceNormals[t * 3], &cross[t * 3], sizeof(float) * 3);
+			Normalize(&faceNormals[t * 3]);
+		}
+	});
+
+	// corners around each vertex
+	std::vector<UINT> offsets((size_t)numVertices + 1, 0);
+	for (size_t c = 0; c < numCorners; c++)
+		offsets[triangles[c] + 1]++;
+	for (size_t v = 0; v < numVertices; v++)
+		offsets[v + 1] += offsets[v];
+
+	std::vector<UINT> corners(numCorners);
+	std::vector<UINT> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t c = 0; c < numCorners; c++)
+		corners[fill[triangles[c]]++] = (UINT)c;
+
+	float cosCrease = cosf(creaseAngle);
+	cornerNormals.resize(numCorners * 3);
+
+	// each corner averages the faces around its vertex that are within the crease angle
+	ParallelFor(numBlocks, numThreads, [&](size_t block, int)
+	{
+		size_t end = (block + 1) * blockSize < numTriangles ? (block + 1) * blockSize : numTriangles;
+		for (size_t t = block * blockSize; t < end; t++)
+		{
+			const float *fn = &faceNormals[t * 3];
+
+			for (int k = 0; k < 3; k++)
+			{
+				UINT v = triangles[t * 3 + k];
+				float *n = &cornerNormals[(t * 3 + k) * 3];
+				n[0] = n[1] = n[2] = 0.0f;
+
+				for (UINT i = offsets[v]; i < offsets[v + 1]; i++)
+				{
+					UINT c = corners[i];
+					const float *other = &faceNormals[(c / 3) * 3];
+
+					if (c / 3 != t && fn[0] * other[0] + fn[1] * other[1] + fn[2] * other[2] < cosCrease)
+						continue;
+
+					const float *w = &cross[(c / 3) * 3];
+					n[0] += w[0] * angles[c];
+					n[1] += w[1] * angles[c];
+					n[2] += w[2] * angles[c];
+				}
+
+				Normalize(n);
+			}
+		}
+	});
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+// Smooth vertex normals from a triangle list, each face weighted by its area and corner angle.
+// The accumulation runs on per-thread partial buffers that are reduced at the end (no atomics).
+class NormalGenerator
+{
+public:
+	// one normal per vertex: normals is resized to numVertices * 3
+	static void Generate(const std::vector<UINT>& triangles, const float *positions, UINT numVertices,
+		int numThreads, std::vector<float>& normals);
+
+	// one normal per triangle corner, only faces within creaseAngle (radians) of the corner face
+	// are averaged: cornerNormals is resized to triangles.size() * 3
+	static void GenerateCorners(const std::vector<UINT>& triangles, const float *positions, UINT numVertices,
+		float creaseAngle, int numThreads, std::vector<float>& cornerNormals);
+};
@@ -0,0 +1,929 @@
+#include "OBJImporter.h"
+#include "ParallelFor.h"
+#include "CStringImp.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Skylicht;
+
+static const double s_pow10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline const char* SkipSpace(const char *p, const char *end)
+{
+	while (p < end && IsSpace(*p))
+		p++;
+	return p;
+}
+
+static inline const char* FindLineEnd(const char *p, const char *end)
+{
+	const char *lineEnd = (const char*)memchr(p, '\n', end - p);
+	return lineEnd != NULL ? lineEnd : end;
+}
+
+// keyword followed by a space or the line end, p is moved after it
+static inline bool MatchKeyword(const char *&p, const char *end, const char *keyword)
+{
+	const char *s = p;
+	while (*keyword != 0)
+	{
+		if (s >= end || *s != *keyword)
+			return false;
+		s++;
+		keyword++;
+	}
+
+	if (s < end && !IsSpace(*s))
+		return false;
+
+	p = s;
+	return true;
+}
+
+// rest of the line without the surrounding spaces
+static std::string ReadName(const char *p, const char *end)
+{
+	p = SkipSpace(p, end);
+	while (end > p && IsSpace(end[-1]))
+		end--;
+	return std::string(p, end - p);
+}
+
+static inline bool ParseInt(const char *&p, const char *end, long long *result)
+{
+	const char *s = p;
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+'))
+	{
+		negative = *s == '-';
+		s++;
+	}
+
+	if (s >= end || !IsDigit(*s))
+		return false;
+
+	long long value = 0;
+	while (s < end && IsDigit(*s))
+	{
+		value = value * 10 + (*s - '0');
+		s++;
+	}
+
+	*result = negative ? -value : value;
+	p = s;
+	return true;
+}
+
+// 0-based index of a 1-based (or negative, relative to 'count') OBJ index, false if out of [0, total)
+static inline bool ResolveIndex(long long index, UINT64 count, UINT64 total, UINT *result)
+{
+	if (index > 0)
+		index = index - 1;
+	else if (index < 0)
+		index = (long long)count + index;
+	else
+		return false;
+
+	if (index < 0 || (UINT64)index >= total)
+		return false;
+
+	*result = (UINT)index;
+	return true;
+}
+
+// open addressing table of the unique corners (v, vt, vn) of a mesh
+class CornerHash
+{
+protected:
+	// vertex + 1, 0: empty
+	std::vector<UINT> m_slots;
+	size_t m_mask;
+
+	// 3 per vertex
+	std::vector<UINT> m_keys;
+
+public:
+	CornerHash()
+	{
+		m_slots.resize(1024, 0);
+		m_mask = m_slots.size() - 1;
+	}
+
+	const std::vector<UINT>& GetKeys()
+	{
+		return m_keys;
+	}
+
+	UINT Insert(const UINT *corner)
+	{
+		if ((m_keys.size() / 3 + 1) * 2 > m_slots.size())
+			Grow();
+
+		size_t slot = Hash(corner) & m_mask;
+		while (true)
+		{
+			UINT vertex = m_slots[slot];
+			if (vertex == 0)
+				break;
+
+			const UINT *key = &m_keys[(vertex - 1) * 3];
+			if (key[0] == corner[0] && key[1] == corner[1] && key[2] == corner[2])
+				return vertex - 1;
+
+			slot = (slot + 1) & m_mask;
+		}
+
+		m_keys.insert(m_keys.end(), corner, corner + 3);
+
+		UINT vertex = (UINT)(m_keys.size() / 3);
+		m_slots[slot] = vertex;
+		return vertex - 1;
+	}
+
+protected:
+	static inline size_t Hash(const UINT *corner)
+	{
+		UINT h = corner[0] * 0x9E3779B1u ^ corner[1] * 0x85EBCA77u ^ corner[2] * 0xC2B2AE3Du;
+		h ^= h >> 16;
+		h *= 0x7FEB352Du;
+		h ^= h >> 15;
+		return h;
+	}
+
+	void Grow()
+	{
+		m_slots.assign(m_slots.size() * 2, 0);
+		m_mask = m_slots.size() - 1;
+
+		UINT numVertices = (UINT)(m_keys.size() / 3);
+		for (UINT i = 0; i < numVertices; i++)
+		{
+			size_t slot = Hash(&m_keys[i * 3]) & m_mask;
+			while (m_slots[slot] != 0)
+				slot = (slot + 1) & m_mask;
+			m_slots[slot] = i + 1;
+		}
+	}
+};
+
+OBJImporter::OBJImporter()
+	:m_numTriangles(0),
+	m_numVertices(0),
+	m_numErrors(0)
+{
+}
+
+OBJImporter::~OBJImporter()
+{
+}
+
+float OBJImporter::ParseFloat(const char *&p, const char *end)
+{
+	const char *s = p;
+
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+'))
+	{
+		negative = *s == '-';
+		s++;
+	}
+
+	// up to 19 significant digits in the mantissa, the others only move the exponent
+	UINT64 mantissa = 0;
+	int numDigits = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+
+	while (s < end && IsDigit(*s))
+	{
+		if (numDigits < 19)
+		{
+			mantissa = mantissa * 10 + (*s - '0');
+			if (mantissa != 0)
+				numDigits++;
+		}
+		else
+			exponent++;
+
+		hasDigits = true;
+		s++;
+	}
+
+	if (s < end && *s == '.')
+	{
+		s++;
+		while (s < end && IsDigit(*s))
+		{
+			if (numDigits < 19)
+			{
+				mantissa = mantissa * 10 + (*s - '0');
+				if (mantissa != 0)
+					numDigits++;
+				exponent--;
+			}
+
+			hasDigits = true;
+			s++;
+		}
+	}
+
+	bool fallback = !hasDigits;
+
+	if (!fallback && s < end && (*s == 'e' || *s == 'E'))
+	{
+		s++;
+		long long e;
+		if (ParseInt(s, end, &e) && e > -1000 && e < 1000)
+			exponent += (int)e;
+		else
+			fallback = true;
+	}
+
+	// nan, inf, 1.#INF...
+	if (fallback || (s < end && !IsSpace(*s) && *s != '\n' && *s != '/'))
+	{
+		char text[64];
+		size_t length = 0;
+		for (const char *t = p; t < end && length < sizeof(text) - 1 && !IsSpace(*t) && *t != '\n'; t++)
+			text[length++] = *t;
+		text[length] = 0;
+
+		char *last = text;
+		double value = strtod(text, &last);
+		p += last - text;
+		return (float)value;
+	}
+
+	double value = (double)mantissa;
+	if (exponent < 0)
+		value = -exponent <= 22 ? value / s_pow10[-exponent] : value * pow(10.0, exponent);
+	else if (exponent > 0)
+		value = exponent <= 22 ? value * s_pow10[exponent] : value * pow(10.0, exponent);
+
+	p = s;
+	return (float)(negative ? -value : value);
+}
+
+bool OBJImporter::Load(const char *path, int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = GetDefaultNumThreads();
+
+	if (!m_file.Open(path))
+		return false;
+
+	char folder[MAX_PATH];
+	char name[MAX_PATH];
+	CStringImp::getFolderPath(folder, path);
+	CStringImp::getFileNameNoExt(name, path);
+	m_folder = folder;
+	m_name = name;
+
+	const char *data = (const char*)m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	// line-aligned chunks
+	size_t numChunks = size / OBJ_CHUNK_SIZE + 1;
+	const char *begin = data;
+	for (size_t i = 0; i < numChunks && begin < data + size; i++)
+	{
+		const char *end = data + (i + 1 == numChunks ? size : (i + 1) * (size / numChunks));
+		if (end < begin)
+			end = begin;
+		end = end < data + size ? FindLineEnd(end, data + size) : data + size;
+		if (end < data + size)
+			end++;
+
+		Chunk chunk;
+		chunk.Begin = begin;
+		chunk.End = end;
+		chunk.NumPositions = chunk.NumTexcoords = chunk.NumNormals = 0;
+		chunk.FirstPosition = chunk.FirstTexcoord = chunk.FirstNormal = 0;
+		chunk.NumErrors = 0;
+		m_chunks.push_back(chunk);
+
+		begin = end;
+	}
+
+	// pass 1: first v/vt/vn of each chunk
+	ParallelFor(m_chunks.size(), numThreads, [&](size_t i, int)
+	{
+		CountChunk(m_chunks[i]);
+	});
+
+	UINT64 numPositions = 0, numTexcoords = 0, numNormals = 0;
+	for (size_t i = 0; i < m_chunks.size(); i++)
+	{
+		Chunk& chunk = m_chunks[i];
+		chunk.FirstPosition = numPositions;
+		chunk.FirstTexcoord = numTexcoords;
+		chunk.FirstNormal = numNormals;
+		numPositions += chunk.NumPositions;
+		numTexcoords += chunk.NumTexcoords;
+		numNormals += chunk.NumNormals;
+	}
+
+	m_positions.resize(numPositions * 3);
+	m_texcoords.resize(numTexcoords * 2);
+	m_normals.resize(numNormals * 3);
+
+	// pass 2: values in place, faces & states per chunk
+	ParallelFor(m_chunks.size(), numThreads, [&](size_t i, int)
+	{
+		ParseChunk(m_chunks[i]);
+	});
+
+	std::vector<std::string> libraries;
+	for (size_t i = 0; i < m_chunks.size(); i++)
+	{
+		Chunk& chunk = m_chunks[i];
+		m_numErrors += chunk.NumErrors;
+		m_numTriangles += chunk.Corners.size() / 9;
+
+		for (size_t j = 0; j < chunk.Libraries.size(); j++)
+		{
+			if (std::find(libraries.begin(), libraries.end(), chunk.Libraries[j]) == libraries.end())
+				libraries.push_back(chunk.Libraries[j]);
+		}
+	}
+
+	for (size_t i = 0; i < libraries.size(); i++)
+	{
+		std::string library = m_folder.empty() ? libraries[i] : m_folder + "/" + libraries[i];
+		if (!LoadMaterials(library.c_str()))
+			LogError() << "Warning: can not open material library: " << library << "\n";
+	}
+
+	BuildMeshes();
+	return true;
+}
+
+void OBJImporter::CountChunk(Chunk& chunk)
+{
+	const char *p = chunk.Begin;
+	const char *end = chunk.End;
+
+	while (p < end)
+	{
+		const char *lineEnd = FindLineEnd(p, end);
+		const char *s = SkipSpace(p, lineEnd);
+
+		// the same tests as ParseChunk
+		if (s < lineEnd && s[0] == 'v')
+		{
+			if (MatchKeyword(s, lineEnd, "v"))
+				chunk.NumPositions++;
+			else if (MatchKeyword(s, lineEnd, "vt"))
+				chunk.NumTexcoords++;
+			else if (MatchKeyword(s, lineEnd, "vn"))
+				chunk.NumNormals++;
+		}
+
+		p = lineEnd + 1;
+	}
+}
+
+bool OBJImporter::ParseCorner(const char *&p, const char *end, UINT64 numPositions, UINT64 numTexcoords, UINT64 numNormals, UINT *corner)
+{
+	long long index;
+	if (!ParseInt(p, end, &index) || !ResolveIndex(index, numPositions, m_positions.size() / 3, &corner[0]))
+		return false;
+
+	corner[1] = OBJ_NO_INDEX;
+	corner[2] = OBJ_NO_INDEX;
+
+	// v, v/vt, v//vn, v/vt/vn (indices of absent attributes are ignored, some exporters always write them)
+	if (p < end && *p == '/')
+	{
+		p++;
+		if (p < end && *p != '/')
+		{
+			if (!ParseInt(p, end, &index))
+				return false;
+			if (!m_texcoords.empty() && !ResolveIndex(index, numTexcoords, m_texcoords.size() / 2, &corner[1]))
+				return false;
+		}
+
+		if (p < end && *p == '/')
+		{
+			p++;
+			if (!ParseInt(p, end, &index))
+				return false;
+			if (!m_normals.empty() && !ResolveIndex(index, numNormals, m_normals.size() / 3, &corner[2]))
+				return false;
+		}
+	}
+
+	return p >= end || IsSpace(*p);
+}
+
+void OBJImporter::ParseChunk(Chunk& chunk)
+{
+	UINT64 numPositions = chunk.FirstPosition;
+	UINT64 numTexcoords = chunk.FirstTexcoord;
+	UINT64 numNormals = chunk.FirstNormal;
+
+	std::vector<UINT> polygon;
+
+	const char *p = chunk.Begin;
+	const char *end = chunk.End;
+
+	while (p < end)
+	{
+		const char *lineEnd = FindLineEnd(p, end);
+		const char *s = SkipSpace(p, lineEnd);
+		p = lineEnd + 1;
+
+		if (s >= lineEnd || *s == '#')
+			continue;
+
+		if (s[0] == 'v')
+		{
+			// counted by CountChunk: always stored, zeros if it can not be read
+			float *values = NULL;
+			int numValues = 0;
+
+			if (MatchKeyword(s, lineEnd, "v"))
+			{
+				values = &m_positions[numPositions++ * 3];
+				numValues = 3;
+			}
+			else if (MatchKeyword(s, lineEnd, "vt"))
+			{
+				values = &m_texcoords[numTexcoords++ * 2];
+				numValues = 2;
+			}
+			else if (MatchKeyword(s, lineEnd, "vn"))
+			{
+				values = &m_normals[numNormals++ * 3];
+				numValues = 3;
+			}
+
+			if (values == NULL)
+				continue;
+
+			for (int i = 0; i < numValues; i++)
+			{
+				s = SkipSpace(s, lineEnd);
+				const char *before = s;
+				values[i] = s < lineEnd ? ParseFloat(s, lineEnd) : 0.0f;
+
+				// vt: the v component is optional
+				if (s == before && !(numValues == 2 && i == 1))
+				{
+					chunk.NumErrors++;
+					break;
+				}
+			}
+
+			// V flipped like the sdkmesh texcoords (SubsetDecoder flips them back)
+			if (numValues == 2)
+				values[1] = 1.0f - values[1];
+		}
+		else if (MatchKeyword(s, lineEnd, "f"))
+		{
+			polygon.clear();
+
+			bool valid = true;
+			while (valid)
+			{
+				s = SkipSpace(s, lineEnd);
+				if (s >= lineEnd)
+					break;
+
+				UINT corner[3];
+				valid = ParseCorner(s, lineEnd, numPositions, numTexcoords, numNormals, corner);
+				if (valid)
+					polygon.insert(polygon.end(), corner, corner + 3);
+			}
+
+			if (!valid || polygon.size() < 9)
+			{
+				chunk.NumErrors++;
+				continue;
+			}
+
+			// fan
+			for (size_t i = 2, n = polygon.size() / 3; i < n; i++)
+			{
+				chunk.Corners.insert(chunk.Corners.end(), &polygon[0], &polygon[0] + 3);
+				chunk.Corners.insert(chunk.Corners.end(), &polygon[(i - 1) * 3], &polygon[(i - 1) * 3] + 3);
+				chunk.Corners.insert(chunk.Corners.end(), &polygon[i * 3], &polygon[i * 3] + 3);
+			}
+		}
+		else if (s[0] == 'o' || s[0] == 'g' || s[0] == 'u')
+		{
+			State state;
+			if (MatchKeyword(s, lineEnd, "o"))
+				state.Type = ST_OBJECT;
+			else if (MatchKeyword(s, lineEnd, "g"))
+				state.Type = ST_GROUP;
+			else if (MatchKeyword(s, lineEnd, "usemtl"))
+				state.Type = ST_MATERIAL;
+			else
+				continue;
+
+			state.Corner = chunk.Corners.size() / 3;
+			state.Name = ReadName(s, lineEnd);
+			chunk.States.push_back(state);
+		}
+		else if (MatchKeyword(s, lineEnd, "mtllib"))
+		{
+			// space separated file names
+			while (true)
+			{
+				s = SkipSpace(s, lineEnd);
+				if (s >= lineEnd)
+					break;
+
+				const char *name = s;
+				while (s < lineEnd && !IsSpace(*s))
+					s++;
+				chunk.Libraries.push_back(std::string(name, s - name));
+			}
+		}
+
+		// s, l, p, curves...: ignored
+	}
+}
+
+bool OBJImporter::LoadMaterials(const char *path)
+{
+	FILE *file = fopen(path, "rt");
+	if (file == NULL)
+		return false;
+
+	SDKMESH_MATERIAL *material = NULL;
+	bool hasPower = false;
+
+	char line[1024];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		const char *end = line + strlen(line);
+		const char *s = SkipSpace(line, end);
+		while (end > s && (IsSpace(end[-1]) || end[-1] == '\n'))
+			end--;
+
+		if (s >= end || *s == '#')
+			continue;
+
+		if (MatchKeyword(s, end, "newmtl"))
+		{
+			std::string name = ReadName(s, end);
+
+			// the first definition of a name is used
+			material = NULL;
+			if (m_materialIDs.find(name) != m_materialIDs.end())
+				continue;
+
+			SDKMESH_MATERIAL newMaterial;
+			SDKMeshWriter::InitMaterial(newMaterial, name.c_str());
+			m_materials.push_back(newMaterial);
+			m_materialIDs[name] = (UINT)m_materials.size() - 1;
+
+			material = &m_materials.back();
+			hasPower = false;
+			continue;
+		}
+
+		if (material == NULL)
+			continue;
+
+		D3DXVECTOR4 *color = NULL;
+		if (MatchKeyword(s, end, "Kd"))
+			color = &material->Diffuse;
+		else if (MatchKeyword(s, end, "Ka"))
+			color = &material->Ambient;
+		else if (MatchKeyword(s, end, "Ks"))
+			color = &material->Specular;
+		else if (MatchKeyword(s, end, "Ke"))
+			color = &material->Emissive;
+
+		if (color != NULL)
+		{
+			// r g b [a]
+			float *values = &color->x;
+			for (int i = 0; i < 4; i++)
+			{
+				s = SkipSpace(s, end);
+				if (s >= end)
+					break;
+				values[i] = ParseFloat(s, end);
+			}
+		}
+		else if (MatchKeyword(s, end, "Ns"))
+		{
+			s = SkipSpace(s, end);
+			material->Power = ParseFloat(s, end);
+			hasPower = true;
+		}
+		else if (MatchKeyword(s, end, "illum"))
+		{
+			// the OBJ exporter writes the power as illum
+			s = SkipSpace(s, end);
+			if (!hasPower)
+				material->Power = ParseFloat(s, end);
+		}
+		else if (MatchKeyword(s, end, "d"))
+		{
+			s = SkipSpace(s, end);
+			material->Diffuse.w = ParseFloat(s, end);
+		}
+		else if (MatchKeyword(s, end, "Tr"))
+		{
+			s = SkipSpace(s, end);
+			material->Diffuse.w = 1.0f - ParseFloat(s, end);
+		}
+		else
+		{
+			char *texture = NULL;
+			if (MatchKeyword(s, end, "map_Kd"))
+				texture = material->DiffuseTexture;
+			else if (MatchKeyword(s, end, "map_bump") || MatchKeyword(s, end, "bump") || MatchKeyword(s, end, "norm"))
+				texture = material->NormalTexture;
+			else if (MatchKeyword(s, end, "map_Ks"))
+				texture = material->SpecularTexture;
+
+			if (texture != NULL)
+			{
+				// the file name is last, after the options (-bm 1...)
+				const char *name = end;
+				while (name > s && !IsSpace(name[-1]))
+					name--;
+				SDKMeshWriter::CopyName(texture, std::string(name, end - name).c_str(), MAX_TEXTURE_NAME);
+			}
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+UINT OBJImporter::GetMaterial(const std::string& name)
+{
+	std::map<std::string, UINT>::iterator it = m_materialIDs.find(name);
+	if (it != m_materialIDs.end())
+		return it->second;
+
+	// not in the libraries, or no usemtl
+	SDKMESH_MATERIAL material;
+	SDKMeshWriter::InitMaterial(material, name.empty() ? "default" : name.c_str());
+	m_materials.push_back(material);
+
+	UINT id = (UINT)m_materials.size() - 1;
+	m_materialIDs[name] = id;
+	return id;
+}
+
+void OBJImporter::BuildMeshes()
+{
+	std::map<std::string, UINT> meshIDs;
+
+	std::string object = m_name;
+	std::string group;
+	std::string material;
+	int meshID = -1;
+
+	for (UINT i = 0; i < (UINT)m_chunks.size(); i++)
+	{
+		Chunk& chunk = m_chunks[i];
+		size_t corner = 0;
+
+		for (size_t j = 0; j <= chunk.States.size(); j++)
+		{
+			size_t next = j < chunk.States.size() ? chunk.States[j].Corner : chunk.Corners.size() / 3;
+
+			if (next > corner)
+			{
+				// meshes are created by their first face, objects of the same name are merged
+				if (meshID < 0)
+				{
+					std::map<std::string, UINT>::iterator it = meshIDs.find(object);
+					if (it == meshIDs.end())
+					{
+						m_meshes.push_back(Mesh());
+						m_meshes.back().Name = object;
+						meshID = (int)m_meshes.size() - 1;
+						meshIDs[object] = (UINT)meshID;
+					}
+					else
+						meshID = (int)it->second;
+				}
+
+				Mesh& mesh = m_meshes[meshID];
+
+				std::string key = group + "\n" + material;
+				std::map<std::string, UINT>::iterator it = mesh.SubsetIDs.find(key);
+
+				UINT subsetID;
+				if (it == mesh.SubsetIDs.end())
+				{
+					Subset subset;
+					subset.Name = group.empty() ? (material.empty() ? "default" : material) : group;
+					subset.Material = GetMaterial(material);
+					mesh.Subsets.push_back(subset);
+
+					subsetID = (UINT)mesh.Subsets.size() - 1;
+					mesh.SubsetIDs[key] = subsetID;
+				}
+				else
+					subsetID = it->second;
+
+				Span span;
+				span.Chunk = i;
+				span.Begin = corner;
+				span.End = next;
+				mesh.Subsets[subsetID].Spans.push_back(span);
+
+				corner = next;
+			}
+
+			if (j == chunk.States.size())
+				break;
+
+			const State& state = chunk.States[j];
+			if (state.Type == ST_OBJECT)
+			{
+				object = state.Name.empty() ? m_name : state.Name;
+				meshID = -1;
+			}
+			else if (state.Type == ST_GROUP)
+				group = state.Name;
+			else
+				material = state.Name;
+		}
+	}
+}
+
+void OBJImporter::BuildBuffers(const Mesh& mesh, MeshBuffers& buffers)
+{
+	CornerHash hash;
+
+	for (size_t i = 0; i < mesh.Subsets.size(); i++)
+	{
+		buffers.SubsetStarts.push_back(buffers.Indices.size());
+
+		const std::vector<Span>& spans = mesh.Subsets[i].Spans;
+		for (size_t j = 0; j < spans.size(); j++)
+		{
+			const Span& span = spans[j];
+			const UINT *corners = m_chunks[span.Chunk].Corners.data();
+
+			for (size_t k = span.Begin; k < span.End; k++)
+				buffers.Indices.push_back(hash.Insert(corners + k * 3));
+		}
+	}
+	buffers.SubsetStarts.push_back(buffers.Indices.size());
+
+	const std::vector<UINT>& keys = hash.GetKeys();
+	size_t numVertices = keys.size() / 3;
+
+	bool hasTexcoord = false;
+	bool hasNormal = false;
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		hasTexcoord |= keys[i * 3 + 1] != OBJ_NO_INDEX;
+		hasNormal |= keys[i * 3 + 2] != OBJ_NO_INDEX;
+	}
+
+	// position, [normal], [texcoord]
+	UINT numElements = 0;
+	WORD offset = 0;
+
+	D3DVERTEXELEMENT9 position = { 0, offset, D3DDECLTYPE_FLOAT3, 0, D3DDECLUSAGE_POSITION, 0 };
+	buffers.Declaration[numElements++] = position;
+	offset += 12;
+
+	if (hasNormal)
+	{
+		D3DVERTEXELEMENT9 normal = { 0, offset, D3DDECLTYPE_FLOAT3, 0, D3DDECLUSAGE_NORMAL, 0 };
+		buffers.Declaration[numElements++] = normal;
+		offset += 12;
+	}
+
+	if (hasTexcoord)
+	{
+		D3DVERTEXELEMENT9 texcoord = { 0, offset, D3DDECLTYPE_FLOAT2, 0, D3DDECLUSAGE_TEXCOORD, 0 };
+		buffers.Declaration[numElements++] = texcoord;
+		offset += 8;
+	}
+
+	D3DVERTEXELEMENT9 last = { (WORD)0xFF, 0, D3DDECLTYPE_UNUSED, 0, 0, 0 };
+	buffers.Declaration[numElements] = last;
+
+	buffers.Stride = offset;
+	buffers.NumVertices = numVertices;
+	buffers.Vertices.resize(numVertices * buffers.Stride);
+
+	float minPos[3] = { 0.0f, 0.0f, 0.0f };
+	float maxPos[3] = { 0.0f, 0.0f, 0.0f };
+
+	static const float zero[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		const UINT *key = &keys[i * 3];
+		BYTE *vertex = buffers.Vertices.data() + i * buffers.Stride;
+
+		const float *p = &m_positions[(size_t)key[0] * 3];
+		memcpy(vertex, p, 12);
+		vertex += 12;
+
+		for (int j = 0; j < 3; j++)
+		{
+			if (i == 0 || p[j] < minPos[j])
+				minPos[j] = p[j];
+			if (i == 0 || p[j] > maxPos[j])
+				maxPos[j] = p[j];
+		}
+
+		if (hasNormal)
+		{
+			memcpy(vertex, key[2] != OBJ_NO_INDEX ? &m_normals[(size_t)key[2] * 3] : zero, 12);
+			vertex += 12;
+		}
+
+		if (hasTexcoord)
+			memcpy(vertex, key[1] != OBJ_NO_INDEX ? &m_texcoords[(size_t)key[1] * 2] : zero, 8);
+	}
+
+	buffers.Center.x = (minPos[0] + maxPos[0]) * 0.5f;
+	buffers.Center.y = (minPos[1] + maxPos[1]) * 0.5f;
+	buffers.Center.z = (minPos[2] + maxPos[2]) * 0.5f;
+	buffers.Extents.x = (maxPos[0] - minPos[0]) * 0.5f;
+	buffers.Extents.y = (maxPos[1] - minPos[1]) * 0.5f;
+	buffers.Extents.z = (maxPos[2] - minPos[2]) * 0.5f;
+}
+
+bool OBJImporter::Build(SDKMeshWriter& writer, int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = GetDefaultNumThreads();
+
+	// one task per mesh
+	std::vector<MeshBuffers> buffers(m_meshes.size());
+	ParallelFor(m_meshes.size(), numThreads, [&](size_t i, int)
+	{
+		BuildBuffers(m_meshes[i], buffers[i]);
+	});
+
+	for (size_t i = 0; i < m_materials.size(); i++)
+		writer.AddMaterial(m_materials[i]);
+
+	m_numVertices = 0;
+
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		const Mesh& mesh = m_meshes[i];
+		MeshBuffers& meshBuffers = buffers[i];
+
+		m_numVertices += meshBuffers.NumVertices;
+
+		UINT vb = writer.AddVertexBuffer(meshBuffers.Declaration, meshBuffers.Stride, meshBuffers.Vertices);
+		UINT ib = writer.AddIndexBuffer(meshBuffers.Indices);
+		UINT meshID = writer.AddMesh(mesh.Name.c_str(), vb, ib, meshBuffers.Center, meshBuffers.Extents);
+
+		// indices are absolute in the mesh vertex buffer: every subset spans all its vertices
+		for (size_t j = 0; j < mesh.Subsets.size(); j++)
+		{
+			UINT64 start = meshBuffers.SubsetStarts[j];
+			UINT64 count = meshBuffers.SubsetStarts[j + 1] - start;
+			writer.AddSubset(meshID, mesh.Subsets[j].Name.c_str(), mesh.Subsets[j].Material, start, count, 0, meshBuffers.NumVertices);
+		}
+	}
+
+	return true;
+}
+
+void OBJImporter::PrintStats()
+{
+	UINT64 numSubsets = 0;
+	for (size_t i = 0; i < m_meshes.size(); i++)
+		numSubsets += m_meshes[i].Subsets.size();
+
+	LogInfo() << "\n# OBJ import (" << m_chunks.size() << " chunks):\n";
+	LogInfo() << " Positions: " << m_positions.size() / 3 << ", texcoords: " << m_texcoords.size() / 2 << ", normals: " << m_normals.size() / 3 << "\n";
+	LogInfo() << " Meshes: " << m_meshes.size() << ", subsets: " << numSubsets << ", materials: " << m_materials.size() << "\n";
+	LogInfo() << " Triangles: " << m_numTriangles << ", vertices: " << m_numVertices << "\n";
+
+	if (m_numErrors > 0)
+		LogError() << "Warning: " << m_numErrors << " lines can not be read!\n";
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "SDKMeshWriter.h"
+#include "MappedFile.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// bytes of OBJ text parsed per task
+#define OBJ_CHUNK_SIZE (1024 * 1024)
+
+// no texcoord / normal on a face corner
+#define OBJ_NO_INDEX 0xFFFFFFFF
+
+// Wavefront OBJ/MTL reader building an sdkmesh:
+// - the mapped file is cut in line-aligned chunks, parsed in parallel: a counting pass gives the first
+//   v/vt/vn of each chunk (negative indices), then the values are parsed in place in the shared arrays
+// - 'o' starts a mesh, each ('g', 'usemtl') pair of a mesh is a subset, polygons are fanned into triangles
+// - the unique (v, vt, vn) corners of a mesh become its vertices: position, [normal], [texcoord]
+class OBJImporter
+{
+protected:
+	enum StateType
+	{
+		ST_OBJECT = 0,
+		ST_GROUP,
+		ST_MATERIAL,
+	};
+
+	// o/g/usemtl before the corner 'Corner' of the chunk
+	struct State
+	{
+		size_t Corner;
+		StateType Type;
+		std::string Name;
+	};
+
+	struct Chunk
+	{
+		const char *Begin;
+		const char *End;
+
+		UINT64 NumPositions;
+		UINT64 NumTexcoords;
+		UINT64 NumNormals;
+
+		UINT64 FirstPosition;
+		UINT64 FirstTexcoord;
+		UINT64 FirstNormal;
+
+		// 3 per triangle corner: v, vt, vn (OBJ_NO_INDEX)
+		std::vector<UINT> Corners;
+		std::vector<State> States;
+		std::vector<std::string> Libraries;
+
+		UINT64 NumErrors;
+	};
+
+	// corners [Begin, End) of a chunk
+	struct Span
+	{
+		UINT Chunk;
+		size_t Begin;
+		size_t End;
+	};
+
+	struct Subset
+	{
+		std::string Name;
+		UINT Material;
+		std::vector<Span> Spans;
+	};
+
+	struct Mesh
+	{
+		std::string Name;
+		std::vector<Subset> Subsets;
+		std::map<std::string, UINT> SubsetIDs;
+	};
+
+	// vertex & index buffer built from a mesh
+	struct MeshBuffers
+	{
+		D3DVERTEXELEMENT9 Declaration[4];
+		UINT Stride;
+		std::vector<BYTE> Vertices;
+		UINT64 NumVertices;
+
+		// first index of each subset, then the end
+		std::vector<UINT> Indices;
+		std::vector<UINT64> SubsetStarts;
+
+		D3DXVECTOR3 Center;
+		D3DXVECTOR3 Extents;
+	};
+
+	MappedFile m_file;
+	std::string m_folder;
+	std::string m_name;
+
+	std::vector<Chunk> m_chunks;
+
+	std::vector<float> m_positions;
+	std::vector<float> m_texcoords;
+	std::vector<float> m_normals;
+
+	std::vector<Mesh> m_meshes;
+	std::vector<SDKMESH_MATERIAL> m_materials;
+	std::map<std::string, UINT> m_materialIDs;
+
+	UINT64 m_numTriangles;
+	UINT64 m_numVertices;
+	UINT64 m_numErrors;
+
+public:
+	OBJImporter();
+
+	virtual ~OBJImporter();
+
+	// parse the OBJ and its MTL libraries
+	bool Load(const char *path, int numThreads);
+
+	// one vertex & index buffer per mesh
+	bool Build(SDKMeshWriter& writer, int numThreads);
+
+	void PrintStats();
+
+	UINT64 GetNumTriangles()
+	{
+		return m_numTriangles;
+	}
+
+	// faces and lines that could not be read
+	UINT64 GetNumErrors()
+	{
+		return m_numErrors;
+	}
+
+	// decimal float, p is moved after it (strtod for the forms it does not handle)
+	static float ParseFloat(const char *&p, const char *end);
+
+protected:
+	void CountChunk(Chunk& chunk);
+
+	void ParseChunk(Chunk& chunk);
+
+	bool ParseCorner(const char *&p, const char *end, UINT64 numPositions, UINT64 numTexcoords, UINT64 numNormals, UINT *corner);
+
+	bool LoadMaterials(const char *path);
+
+	UINT GetMaterial(const std::string& name);
+
+	void BuildMeshes();
+
+	void BuildBuffers(const Mesh& mesh, MeshBuffers& buffers);
+};
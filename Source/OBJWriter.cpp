@@ -1,308 +1,491 @@
 #include "OBJWriter.h"
 #include "CStringImp.h"
+#include "Log.h"
 
-#include <string>
+#include <new>
 
 using namespace Skylicht;
 
 OBJWriter::OBJWriter(SDKMesh *mesh, const char *output)
-	:m_sdkMesh(mesh)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_stats(NULL),
+	m_budget(NULL),
+	m_outChunk((OutputSink*)NULL),
+	m_matChunk((OutputSink*)NULL),
+	m_scratch(m_remap)
 {
-	m_file = fopen(output, "wt");
-
+	// the MTL is written next to the OBJ and referenced by its name
 	char material[MAX_PATH];
+	char materialName[MAX_PATH];
 	strcpy(material, output);
-	CStringImp::replaceExt(material, ".mtl");
+	CStringImp::replacePathExt(material, ".mtl");
+	strcpy(materialName, output);
+	CStringImp::replaceExt(materialName, ".mtl");
 
-	fprintf(m_file, "# exported by SDKMesh Expoter\n");
-	fprintf(m_file, "mtllib %s\n", material);
+	if (m_objFile.Open(output, "wt") && m_mtlFile.Open(material, "wt"))
+		Init(&m_objFile, &m_mtlFile, materialName);
+	else
+		Init(NULL, NULL, NULL);
+}
 
-	m_mat = fopen(material, "wt");
-	fprintf(m_mat, "# exported by SDKMesh Expoter\n");
+OBJWriter::OBJWriter(SDKMesh *mesh, OutputSink *obj, OutputSink *mtl, const char *materialName)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_stats(NULL),
+	m_budget(NULL),
+	m_outChunk((OutputSink*)NULL),
+	m_matChunk((OutputSink*)NULL),
+	m_scratch(m_remap)
+{
+	Init(obj, mtl, materialName);
+}
 
+void OBJWriter::Init(OutputSink *obj, OutputSink *mtl, const char *materialName)
+{
 	m_group = 0;
 	m_numVertex = 1;
+
+	m_attributes = VA_ALL;
+	m_numTexcoord = 1;
+	m_numNormal = 1;
+
+	m_transform = NULL;
+
+	m_decoder = NULL;
+	m_decoderMesh = 0;
+
+	m_out = NULL;
+	m_mat = NULL;
+
+	if (obj != NULL)
+	{
+		m_outChunk.SetSink(obj);
+		m_out = &m_outChunk;
+	}
+
+	if (mtl != NULL)
+	{
+		m_matChunk.SetSink(mtl);
+		m_mat = &m_matChunk;
+	}
+
+	if (m_out != NULL)
+	{
+		m_out->Print("# exported by SDKMesh Expoter\n");
+		if (materialName != NULL)
+			m_out->Print("mtllib %s\n", materialName);
+	}
+
+	if (m_mat != NULL)
+		m_mat->Print("# exported by SDKMesh Expoter\n");
 }
 
 bool OBJWriter::CanWrite()
 {
-	if (m_file == NULL)
+	if (m_out == NULL)
 		return false;
 
 	return true;
 }
 
-OBJWriter::~OBJWriter()
+bool OBJWriter::Finish()
 {
-	if (m_file != NULL)
+	bool success = true;
+
+	if (m_out != NULL)
 	{
-		fclose(m_file);
-		m_file = NULL;
+		m_out->Flush();
+		success = !m_out->HasError();
 	}
 
 	if (m_mat != NULL)
 	{
-		fclose(m_mat);
-		m_mat = NULL;
+		m_mat->Flush();
+		success = success && !m_mat->HasError();
 	}
+
+	return success;
+}
+
+void OBJWriter::SetStats(ConvertStats *stats)
+{
+	m_stats = stats;
+
+	if (m_out != NULL)
+		m_out->SetStats(stats);
+	if (m_mat != NULL)
+		m_mat->SetStats(stats);
+}
+
+OBJWriter::~OBJWriter()
+{
+	if (m_decoder != NULL)
+		m_decoder->~SubsetDecoder();
+
+	// before the files are closed
+	m_outChunk.Flush();
+	m_matChunk.Flush();
+
+	m_objFile.Close();
+	m_mtlFile.Close();
 }
 
 bool OBJWriter::WriteMaterial(SDKMESH_MATERIAL *material)
 {
-	fprintf(m_mat, "newmtl %s\n", material->Name);
-	fprintf(m_mat, "Kd %f %f %f %f\n", 
+	if (m_mat == NULL)
+		return false;
+
+	return WriteMaterial(*m_mat, material);
+}
+
+bool OBJWriter::WriteMaterial(FILE *file, SDKMESH_MATERIAL *material)
+{
+	ChunkWriter out(file);
+	WriteMaterial(out, material);
+	out.Flush();
+	return !out.HasError();
+}
+
+bool OBJWriter::WriteMaterial(ChunkWriter& file, SDKMESH_MATERIAL *material)
+{
+	file.Print("newmtl %s\n", material->Name);
+	file.Print("Kd %f %f %f %f\n", 
 		material->Diffuse.x,
 		material->Diffuse.y,
 		material->Diffuse.z,
 		material->Diffuse.w);
 
-	fprintf(m_mat, "Ka %f %f %f %f\n",
+	file.Print("Ka %f %f %f %f\n",
 		material->Ambient.x,
 		material->Ambient.y,
 		material->Ambient.z,
 		material->Ambient.w);
 
-	fprintf(m_mat, "Ks %f %f %f %f\n",
+	file.Print("Ks %f %f %f %f\n",
 		material->Specular.x,
 		material->Specular.y,
 		material->Specular.z,
 		material->Specular.w);
 
-	fprintf(m_mat, "Ke %f %f %f %f\n",
+	file.Print("Ke %f %f %f %f\n",
 		material->Emissive.x,
 		material->Emissive.y,
 		material->Emissive.z,
 		material->Emissive.w);
 
-	fprintf(m_mat, "illum %f\n", material->Power);
+	file.Print("illum %f\n", material->Power);
 
 	if (strlen(material->DiffuseTexture))
-		fprintf(m_mat, "map_Kd %s\n", material->DiffuseTexture);
+		file.Print("map_Kd %s\n", material->DiffuseTexture);
 
 	if (strlen(material->NormalTexture))
-		fprintf(m_mat, "map_bump %s\n", material->NormalTexture);
+		file.Print("map_bump %s\n", material->NormalTexture);
 
 	if (strlen(material->SpecularTexture))
-		fprintf(m_mat, "map_Ks %s\n", material->SpecularTexture);
+		file.Print("map_Ks %s\n", material->SpecularTexture);
 
 	return true;
 }
 
 void OBJWriter::WriteObject(const char *name)
 {
-	fprintf(m_file, "o %s\n", name);
+	m_out->Print("o %s\n", name);
 }
 
-bool OBJWriter::WriteSubset(UINT meshID, SDKMESH_MESH* mesh, SDKMESH_SUBSET *subset, bool writeGroup)
-{	
-	BYTE* vertexBufferData = m_sdkMesh->GetRawVerticesAt(mesh->VertexBuffers[0]);
-	BYTE* indexBufferData = m_sdkMesh->GetRawIndicesAt(mesh->IndexBuffer);
-	UINT vertexStride = m_sdkMesh->GetVertexStride(meshID, 0);
-
-	std::map<BYTE, const char *> nameMap;
-	nameMap[D3DDECLUSAGE_POSITION] = "POSITION";
-	nameMap[D3DDECLUSAGE_BLENDWEIGHT] = "BLENDWEIGHT";
-	nameMap[D3DDECLUSAGE_BLENDINDICES] = "BLENDINDICES";
-	nameMap[D3DDECLUSAGE_NORMAL] = "NORMAL";
-	nameMap[D3DDECLUSAGE_TEXCOORD] = "TEXCOORD";
-	nameMap[D3DDECLUSAGE_TANGENT] = "TANGENT";
-	nameMap[D3DDECLUSAGE_BINORMAL] = "BINORMAL";
-	nameMap[D3DDECLUSAGE_COLOR] = "COLOR";
-
-	std::map<BYTE, const char*> formatMap;
-	formatMap[D3DDECLTYPE_FLOAT1] = "DXGI_FORMAT_R32_FLOAT";
-	formatMap[D3DDECLTYPE_FLOAT2] = "DXGI_FORMAT_R32G32_FLOAT";
-	formatMap[D3DDECLTYPE_FLOAT3] = "DXGI_FORMAT_R32G32B32_FLOAT";
-	formatMap[D3DDECLTYPE_FLOAT4] = "DXGI_FORMAT_R32G32B32A32_FLOAT";
-	formatMap[D3DDECLTYPE_D3DCOLOR] = "DXGI_FORMAT_R8G8B8A8_UNORM";
-	formatMap[D3DDECLTYPE_UBYTE4] = "DXGI_FORMAT_R8G8B8A8_UINT";
-	formatMap[D3DDECLTYPE_SHORT2] = "DXGI_FORMAT_R16G16_SINT";
-	formatMap[D3DDECLTYPE_SHORT4] = "DXGI_FORMAT_R16G16B16A16_SINT";
-	formatMap[D3DDECLTYPE_UBYTE4N] = "DXGI_FORMAT_R8G8B8A8_UNORM";
-	formatMap[D3DDECLTYPE_SHORT2N] = "DXGI_FORMAT_R16G16_SNORM";
-	formatMap[D3DDECLTYPE_SHORT4N] = "DXGI_FORMAT_R16G16B16A16_SNORM";
-	formatMap[D3DDECLTYPE_USHORT2N] = "DXGI_FORMAT_R16G16_UNORM";
-	formatMap[D3DDECLTYPE_USHORT4N] = "DXGI_FORMAT_R16G16B16A16_UNORM";
-	formatMap[D3DDECLTYPE_UDEC3] = "DXGI_FORMAT_R10G10B10A2_UINT";
-	formatMap[D3DDECLTYPE_DEC3N] = "DXGI_FORMAT_R10G10B10A2_UNORM";
-	formatMap[D3DDECLTYPE_FLOAT16_2] = "DXGI_FORMAT_R16G16_FLOAT";
-	formatMap[D3DDECLTYPE_FLOAT16_4] = "DXGI_FORMAT_R16G16B16A16_FLOAT";
+void OBJWriter::UpdateDecoder(UINT meshID)
+{
+	if (m_decoder == NULL || m_decoderMesh != meshID)
+	{
+		if (m_decoder != NULL)
+			m_decoder->~SubsetDecoder();
+		else
+			m_decoderStorage.Resize(sizeof(SubsetDecoder));
 
-	bool success = true;
+		m_decoder = new (m_decoderStorage.Data()) SubsetDecoder(m_sdkMesh, meshID, m_processor, m_attributes);
+		m_decoder->SetTransform(m_transform);
+		m_decoder->SetBudget(m_budget);
+		m_decoderMesh = meshID;
+	}
+}
 
-	std::vector<unsigned long> vertices;
-	std::map<unsigned long, unsigned long> map;
+bool OBJWriter::WriteSubset(UINT meshID, SDKMESH_SUBSET *subset, bool writeGroup)
+{
+	UpdateDecoder(meshID);
 
-	if (m_sdkMesh->GetIndexType(meshID) == IT_32BIT)
+	if (writeGroup)
+		m_out->Print("g grp %d \n", m_group++);
+
+	if (m_budget != NULL && m_decoder->CanRemapWindows() && subset->IndexCount > m_budget->GetWindowIndices())
+		return WriteSubsetWindows(meshID, subset);
+
+	bool success;
 	{
-		// 32bit
-		DWORD *indices = (DWORD*)indexBufferData;
-		for (UINT64 i = subset->IndexStart; i < subset->IndexStart + subset->IndexCount; i += 3)
-		{
-			int i0 = indices[i];
-			int i1 = indices[i + 1];
-			int i2 = indices[i + 2];
-
-			if (map.find(i0) == map.end())
-			{				
-				map[i0] = vertices.size();
-				vertices.push_back(i0);
-			}
+		StatsScope scope(m_stats, SP_REMAP);
+		success = m_decoder->Remap(subset, m_remap);
+	}
 
-			if (map.find(i1) == map.end())
-			{				
-				map[i1] = vertices.size();
-				vertices.push_back(i1);
-			}
+	const std::vector<UINT>& vertices = m_remap.Vertices;
+	const std::vector<UINT>& indices = m_remap.Indices;
 
-			if (map.find(i2) == map.end())
-			{				
-				map[i2] = vertices.size();
-				vertices.push_back(i2);
-			}
-		}
+	if (m_stats != NULL)
+	{
+		m_stats->Add(SC_SUBSETS, 1);
+		m_stats->Add(SC_VERTICES, vertices.size());
+		m_stats->Add(SC_FACES, indices.size() / 3);
+		m_stats->Add(SC_REMAP_HITS, indices.size() - vertices.size());
 	}
-	else
+
+	UINT written = WriteVertices(meshID, vertices, true);
+
+	SDKMESH_MATERIAL* mat = m_sdkMesh->GetMaterial(subset->MaterialID);
+
+	m_out->Print("usemtl %s\n", mat->Name);
+	m_out->Print("s off\n");
+
+	WriteFaces(indices, written);
+	EndSubset((UINT)vertices.size(), written);
+
+	if (m_budget != NULL)
+		m_budget->Consume(subset->IndexCount * m_decoder->GetIndexSize());
+
+	return success;
+}
+
+bool OBJWriter::WriteSubsetWindows(UINT meshID, SDKMESH_SUBSET *subset)
+{
+	// the material comes first, each window then adds its new vertices and its faces
+	SDKMESH_MATERIAL* mat = m_sdkMesh->GetMaterial(subset->MaterialID);
+
+	m_out->Print("usemtl %s\n", mat->Name);
+	m_out->Print("s off\n");
+
+	UINT64 window = m_budget->GetWindowIndices();
+	UINT64 numIndices = subset->IndexCount / 3 * 3;
+	UINT numVertices = 0;
+	UINT written = 0;
+
+	bool success = true;
+
+	for (UINT64 first = 0; first < numIndices; first += window)
 	{
-		// 16bit
-		WORD *indices = (WORD*)indexBufferData;
-		for (UINT64 i = subset->IndexStart; i < subset->IndexStart + subset->IndexCount; i += 3)
+		bool remapped;
 		{
-			int i0 = indices[i];
-			int i1 = indices[i + 1];
-			int i2 = indices[i + 2];
-
-			if (map.find(i0) == map.end())
-			{				
-				map[i0] = vertices.size();
-				vertices.push_back(i0);
-			}
+			StatsScope scope(m_stats, SP_REMAP);
+			remapped = m_decoder->RemapWindow(subset, first, window, numVertices, m_remap);
+		}
 
-			if (map.find(i1) == map.end())
-			{				
-				map[i1] = vertices.size();
-				vertices.push_back(i1);
-			}
+		const std::vector<UINT>& vertices = m_remap.Vertices;
+		const std::vector<UINT>& indices = m_remap.Indices;
 
-			if (map.find(i2) == map.end())
-			{				
-				map[i2] = vertices.size();
-				vertices.push_back(i2);
-			}
+		if (m_stats != NULL)
+		{
+			m_stats->Add(SC_VERTICES, vertices.size());
+			m_stats->Add(SC_FACES, indices.size() / 3);
+			m_stats->Add(SC_REMAP_HITS, indices.size() - vertices.size());
+		}
+
+		UINT windowWritten = WriteVertices(meshID, vertices, first == 0);
+		WriteFaces(indices, windowWritten);
+		written |= windowWritten;
+
+		numVertices += (UINT)vertices.size();
+
+		m_budget->Consume(indices.size() * m_decoder->GetIndexSize());
+
+		if (!remapped)
+		{
+			success = false;
+			break;
 		}
 	}
 
-	if (writeGroup)
-		fprintf(m_file, "g grp %d \n", m_group++);
+	m_decoder->EndWindows();
+
+	if (m_stats != NULL)
+		m_stats->Add(SC_SUBSETS, 1);
+
+	EndSubset(numVertices, written);
+
+	return success;
+}
+
+UINT OBJWriter::WriteVertices(UINT meshID, const std::vector<UINT>& vertices, bool log)
+{
+	const UINT chunkSize = 1024;
+	float f[chunkSize * 4];
 
 	const D3DVERTEXELEMENT9* declaration = m_sdkMesh->VBElements(meshID, 0);
 	UINT numInputElements = 0;
+	bool hasNormal = false;
+	UINT written = 0;
+	UINT seen = 0;
 	while (declaration[numInputElements].Stream != 0xFF)
 	{
 		const D3DVERTEXELEMENT9& element9 = declaration[numInputElements];
 
-		std::string name = nameMap[element9.Usage];
-		std::string format = formatMap[element9.Type];
+		const char *name = SubsetDecoder::GetUsageName(element9.Usage);
+		const char *format = SubsetDecoder::GetFormatName(element9.Type);
+
+		if (element9.Usage == D3DDECLUSAGE_NORMAL)
+			hasNormal = true;
 
-		int offset = element9.Offset;
+		UINT attribute = 0;
+		if (element9.Usage == D3DDECLUSAGE_POSITION)
+			attribute = VA_POSITION;
+		else if (element9.Usage == D3DDECLUSAGE_NORMAL)
+			attribute = VA_NORMAL;
+		else if (element9.Usage == D3DDECLUSAGE_TEXCOORD)
+			attribute = VA_TEXCOORD;
 
-		if (name == "POSITION")
+		if (attribute != 0 && m_attributes != VA_ALL && ((m_attributes & attribute) == 0 || (written & attribute) != 0))
 		{
-			if (format == "DXGI_FORMAT_R32G32B32_FLOAT")
-			{				
-				for (unsigned int i = 0; i < vertices.size(); i++)
-				{
-					BYTE *vtxData = vertexBufferData + vertices[i] * vertexStride + offset;
-					float *f = (float*)vtxData;
-					fprintf(m_file, "v %f %f %f\n", f[0], f[1], f[2]);
-				}
-			}
-			else
-				std::cout << "  -> Error: " << name << "Can not support format: " << format << std::endl;
+			// stripped, or a second element of the usage: one stream per face slot
 		}
-		else if (name == "NORMAL")
+		else if (attribute != 0)
 		{
-			if (format == "DXGI_FORMAT_R32G32B32_FLOAT")
+			bool complete = true;
+			for (UINT begin = 0, n = (UINT)vertices.size(); begin < n; begin += chunkSize)
 			{
-				for (unsigned int i = 0; i < vertices.size(); i++)
+				UINT count = n - begin < chunkSize ? n - begin : chunkSize;
+				const UINT *chunk = vertices.data() + begin;
+
+				bool decoded;
 				{
-					BYTE *vtxData = vertexBufferData + vertices[i] * vertexStride + offset;
-					float *f = (float*)vtxData;
-					fprintf(m_file, "vn %f %f %f\n", f[0], f[1], f[2]);
+					StatsScope scope(m_stats, SP_DECODE);
+					decoded = m_decoder->DecodeSet(&element9, chunk, count, f);
 				}
-			}
-			else
-				std::cout << "  -> Error: " << name << "Can not support format: " << format << std::endl;
-		}
-		else if (name == "TEXCOORD")
-		{
-			if (format == "DXGI_FORMAT_R32G32_FLOAT")
-			{
-				for (unsigned int i = 0; i < vertices.size(); i++)
+
+				if (!decoded && (seen & attribute) != 0 && m_sdkMesh->GetCache() != NULL)
+				{
+					if (log)
+						LogDebug() << "  -> Warning: Skipped: " << name << " (the mesh cache keeps the first set)\n";
+					complete = false;
+					break;
+				}
+
+				if (!decoded)
 				{
-					BYTE *vtxData = vertexBufferData + vertices[i] * vertexStride + offset;
-					float *f = (float*)vtxData;
-					fprintf(m_file, "vt %f %f\n", f[0], 1.0f - f[1]);
+					LogError() << "  -> Error: " << name << "Can not support format: " << format << "\n";
+					complete = false;
+					break;
+				}
+
+				if (element9.Usage == D3DDECLUSAGE_POSITION)
+				{
+					for (UINT i = 0; i < count; i++)
+						m_out->Print("v %f %f %f\n", f[i * 3], f[i * 3 + 1], f[i * 3 + 2]);
+				}
+				else if (element9.Usage == D3DDECLUSAGE_NORMAL)
+				{
+					for (UINT i = 0; i < count; i++)
+						m_out->Print("vn %f %f %f\n", f[i * 3], f[i * 3 + 1], f[i * 3 + 2]);
+				}
+				else
+				{
+					for (UINT i = 0; i < count; i++)
+						m_out->Print("vt %f %f\n", f[i * 2], f[i * 2 + 1]);
 				}
 			}
-			else
-				std::cout << "  -> Error: " << name << "Can not support format: " << format << std::endl;
+
+			if (complete)
+				written |= attribute;
+			seen |= attribute;
 		}
-		else
+		else if ((element9.Usage == D3DDECLUSAGE_BLENDWEIGHT || element9.Usage == D3DDECLUSAGE_BLENDINDICES) && m_decoder->IsSkinned())
 		{
-			std::cout << "  -> Warning: Missing: " << name << std::endl;
+			// baked into the positions & normals
+		}
+		else if (log)
+		{
+			LogDebug() << "  -> Warning: Missing: " << name << "\n";
 		}
 
 		numInputElements++;
 	}
 
-	SDKMESH_MATERIAL* mat = m_sdkMesh->GetMaterial(subset->MaterialID);
-
-	fprintf(m_file, "usemtl %s\n", mat->Name);
-	fprintf(m_file, "s off\n");
-	
-	if (m_sdkMesh->GetIndexType(meshID) == IT_32BIT)
+	// no NORMAL element: normals generated by the processor
+	if (!hasNormal && m_decoder->HasNormal())
 	{
-		// 32bit
-		DWORD *indices = (DWORD*)indexBufferData;
-		for (UINT64 i = subset->IndexStart; i < subset->IndexStart + subset->IndexCount; i += 3)
+		written |= VA_NORMAL;
+
+		for (UINT begin = 0, n = (UINT)vertices.size(); begin < n; begin += chunkSize)
 		{
-			int i0 = indices[i];
-			int i1 = indices[i + 1];
-			int i2 = indices[i + 2];
-
-			int m0 = map[i0] + m_numVertex;
-			int m1 = map[i1] + m_numVertex;
-			int m2 = map[i2] + m_numVertex;
-
-			fprintf(m_file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", 
-				m0, m0, m0,
-				m1, m1, m1,
-				m2, m2, m2);
+			UINT count = n - begin < chunkSize ? n - begin : chunkSize;
+
+			bool decoded;
+			{
+				StatsScope scope(m_stats, SP_DECODE);
+				decoded = m_decoder->DecodeNormals(vertices.data() + begin, count, f);
+			}
+
+			if (!decoded)
+			{
+				written &= ~VA_NORMAL;
+				break;
+			}
+
+			for (UINT i = 0; i < count; i++)
+				m_out->Print("vn %f %f %f\n", f[i * 3], f[i * 3 + 1], f[i * 3 + 2]);
 		}
 	}
-	else
+
+	return written;
+}
+
+void OBJWriter::WriteFaces(const std::vector<UINT>& indices, UINT written)
+{
+	if (m_attributes != VA_ALL)
 	{
-		// 16bit
-		WORD *indices = (WORD*)indexBufferData;
-		for (UINT64 i = subset->IndexStart; i < subset->IndexStart + subset->IndexCount; i += 3)
+		// only the written streams, each one with its own numbering
+		int t = m_numTexcoord - m_numVertex;
+		int n = m_numNormal - m_numVertex;
+		bool texcoord = (written & VA_TEXCOORD) != 0;
+		bool normal = (written & VA_NORMAL) != 0;
+
+		for (size_t i = 0, count = indices.size(); i < count; i += 3)
 		{
-			int i0 = indices[i];
-			int i1 = indices[i + 1];
-			int i2 = indices[i + 2];
-
-			int m0 = map[i0] + m_numVertex;
-			int m1 = map[i1] + m_numVertex;
-			int m2 = map[i2] + m_numVertex;
-
-			fprintf(m_file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
-				m0, m0, m0,
-				m1, m1, m1,
-				m2, m2, m2);
+			int m0 = indices[i] + m_numVertex;
+			int m1 = indices[i + 1] + m_numVertex;
+			int m2 = indices[i + 2] + m_numVertex;
+
+			if (m_transform != NULL)
+				m_transform->OrderTriangle(m1, m2);
+
+			if (texcoord && normal)
+				m_out->Print("f %d/%d/%d %d/%d/%d %d/%d/%d\n", m0, m0 + t, m0 + n, m1, m1 + t, m1 + n, m2, m2 + t, m2 + n);
+			else if (texcoord)
+				m_out->Print("f %d/%d %d/%d %d/%d\n", m0, m0 + t, m1, m1 + t, m2, m2 + t);
+			else if (normal)
+				m_out->Print("f %d//%d %d//%d %d//%d\n", m0, m0 + n, m1, m1 + n, m2, m2 + n);
+			else
+				m_out->Print("f %d %d %d\n", m0, m1, m2);
 		}
+		return;
 	}
 
-	m_numVertex += vertices.size();
+	for (size_t i = 0, n = indices.size(); i < n; i += 3)
+	{
+		int m0 = indices[i] + m_numVertex;
+		int m1 = indices[i + 1] + m_numVertex;
+		int m2 = indices[i + 2] + m_numVertex;
 
-	return success;
+		if (m_transform != NULL)
+			m_transform->OrderTriangle(m1, m2);
+
+		m_out->Print("f %d/%d/%d %d/%d/%d %d/%d/%d\n",
+			m0, m0, m0,
+			m1, m1, m1,
+			m2, m2, m2);
+	}
+}
+
+void OBJWriter::EndSubset(UINT numVertices, UINT written)
+{
+	m_numVertex += numVertices;
+
+	if (written & VA_TEXCOORD)
+		m_numTexcoord += numVertices;
+	if (written & VA_NORMAL)
+		m_numNormal += numVertices;
 }
\ No newline at end of file
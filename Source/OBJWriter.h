@@ -1,27 +1,112 @@
 #pragma once
 
 #include "SDKMesh.h"
+#include "SubsetDecoder.h"
+#include "ChunkWriter.h"
+#include "MemoryBudget.h"
+#include "VertexTransform.h"
 
 class OBJWriter
 {
 protected:
 	SDKMesh *m_sdkMesh;
-	
-	FILE *m_file;
-	FILE *m_mat;
+	MeshProcessor *m_processor;
+	ConvertStats *m_stats;
+	MemoryBudget *m_budget;
+
+	// files of the path constructor
+	FileSink m_objFile;
+	FileSink m_mtlFile;
+
+	// NULL when the stream is not written
+	ChunkWriter *m_out;
+	ChunkWriter *m_mat;
+	ChunkWriter m_outChunk;
+	ChunkWriter m_matChunk;
 
 	int m_group;
 	int m_numVertex;
+
+	// VERTEX_ATTRIBUTE flags, VA_ALL: every element with v/vt/vn faces;
+	// otherwise the vt & vn lines are numbered apart and the faces list only the written ones
+	UINT m_attributes;
+	int m_numTexcoord;
+	int m_numNormal;
+
+	// coordinate conversion & winding (not owned), NULL: none
+	const VertexTransform *m_transform;
+
+	// decoder of the current mesh, built in place (no heap call per mesh)
+	SubsetDecoder *m_decoder;
+	ArenaArray<char> m_decoderStorage;
+	UINT m_decoderMesh;
+
+	SubsetRemap m_remap;
+	RemapScratch m_scratch;
 public:
+	// OUTPUT.obj and OUTPUT.mtl next to it
 	OBJWriter(SDKMesh *mesh, const char *output);
 
+	// separate OBJ & MTL streams (mtl can be NULL), materialName is the mtllib reference (NULL: none)
+	OBJWriter(SDKMesh *mesh, OutputSink *obj, OutputSink *mtl, const char *materialName);
+
 	virtual ~OBJWriter();
 
 	bool CanWrite();
 
+	// flush the streams, false if a write failed
+	bool Finish();
+
+	void SetProcessor(MeshProcessor *processor)
+	{
+		m_processor = processor;
+	}
+
+	// remap, decode & flush times and the written counters, NULL: off
+	void SetStats(ConvertStats *stats);
+
+	// -attributes: the stripped elements are not decoded, set before the first subset
+	void SetAttributes(UINT attributes)
+	{
+		m_attributes = attributes;
+	}
+
+	// -axes, -scale, -transform & -flipwinding, set before the first subset
+	void SetTransform(const VertexTransform *transform)
+	{
+		m_transform = transform;
+	}
+
+	// subsets larger than a window are written window by window, the consumed input is reported
+	void SetBudget(MemoryBudget *budget)
+	{
+		m_budget = budget;
+	}
+
 	void WriteObject(const char *name);
 
-	bool WriteSubset(UINT meshID, SDKMESH_MESH* mesh, SDKMESH_SUBSET *subset, bool writeGroup);
+	bool WriteSubset(UINT meshID, SDKMESH_SUBSET *subset, bool writeGroup);
 
 	bool WriteMaterial(SDKMESH_MATERIAL *material);
+
+	static bool WriteMaterial(FILE *mat, SDKMESH_MATERIAL *material);
+
+	static bool WriteMaterial(ChunkWriter& mat, SDKMESH_MATERIAL *material);
+
+protected:
+	void Init(OutputSink *obj, OutputSink *mtl, const char *materialName);
+
+	void UpdateDecoder(UINT meshID);
+
+	// v, vn & vt lines of the listed vertices, logging the skipped elements if 'log';
+	// returns the VERTEX_ATTRIBUTE flags of the written lines
+	UINT WriteVertices(UINT meshID, const std::vector<UINT>& vertices, bool log);
+
+	// f lines, indices numbered from the first vertex of the subset
+	void WriteFaces(const std::vector<UINT>& indices, UINT written);
+
+	// next vt & vn numbers after a subset of numVertices
+	void EndSubset(UINT numVertices, UINT written);
+
+	bool WriteSubsetWindows(UINT meshID, SDKMESH_SUBSET *subset);
 };
\ No newline at end of file
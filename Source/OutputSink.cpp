@@ -0,0 +1,32 @@
+#include "OutputSink.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+bool DescriptorSink::Write(const void *data, size_t size)
+{
+	const char *p = (const char*)data;
+
+	// partial writes on pipes and sockets
+	while (size > 0)
+	{
+#if defined(_WIN32)
+		int n = _write(m_fd, p, size > 0x40000000 ? 0x40000000 : (unsigned int)size);
+#else
+		ssize_t n = write(m_fd, p, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+#endif
+		if (n <= 0)
+			return false;
+
+		p += n;
+		size -= (size_t)n;
+	}
+
+	return true;
+}
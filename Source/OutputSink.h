@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdio.h>
+#include <functional>
+#include <vector>
+
+// Destination of a written stream: a file, a memory buffer, a callback or a file descriptor.
+// The writers buffer their output (ChunkWriter) and hand it over in chunks.
+class OutputSink
+{
+public:
+	virtual ~OutputSink()
+	{
+	}
+
+	// false on error, data is only valid during the call
+	virtual bool Write(const void *data, size_t size) = 0;
+};
+
+// FILE*, closed by the sink when it opened it
+class FileSink : public OutputSink
+{
+protected:
+	FILE *m_file;
+	bool m_owned;
+
+public:
+	FileSink(FILE *file = NULL)
+		:m_file(file),
+		m_owned(false)
+	{
+	}
+
+	virtual ~FileSink()
+	{
+		Close();
+	}
+
+	// replaced, not truncated: the old file may be a hard link into the conversion cache
+	bool Open(const char *path, const char *mode = "wb")
+	{
+		Close();
+		remove(path);
+		m_file = fopen(path, mode);
+		m_owned = true;
+		return m_file != NULL;
+	}
+
+	// false if the file could not be written or closed
+	bool Close()
+	{
+		bool success = true;
+		if (m_file != NULL && m_owned)
+			success = fclose(m_file) == 0;
+		m_file = NULL;
+		m_owned = false;
+		return success;
+	}
+
+	bool IsOpen()
+	{
+		return m_file != NULL;
+	}
+
+	virtual bool Write(const void *data, size_t size)
+	{
+		return m_file != NULL && fwrite(data, size, 1, m_file) == 1;
+	}
+};
+
+// growable memory buffer
+class MemorySink : public OutputSink
+{
+protected:
+	std::vector<unsigned char> m_data;
+
+public:
+	virtual bool Write(const void *data, size_t size)
+	{
+		const unsigned char *p = (const unsigned char*)data;
+		m_data.insert(m_data.end(), p, p + size);
+		return true;
+	}
+
+	const unsigned char* GetData()
+	{
+		return m_data.data();
+	}
+
+	size_t GetSize()
+	{
+		return m_data.size();
+	}
+
+	// move the content out, the sink is empty after
+	void Swap(std::vector<unsigned char>& data)
+	{
+		m_data.swap(data);
+	}
+
+	void Clear()
+	{
+		m_data.clear();
+	}
+};
+
+// each chunk to a function (network upload, hashing...), returning false stops the writer
+class CallbackSink : public OutputSink
+{
+public:
+	typedef std::function<bool(const void *data, size_t size)> Callback;
+
+protected:
+	Callback m_callback;
+
+public:
+	CallbackSink(const Callback& callback)
+		:m_callback(callback)
+	{
+	}
+
+	virtual bool Write(const void *data, size_t size)
+	{
+		return m_callback(data, size);
+	}
+};
+
+// file descriptor (pipe, socket), not closed by the sink
+class DescriptorSink : public OutputSink
+{
+protected:
+	int m_fd;
+
+public:
+	DescriptorSink(int fd)
+		:m_fd(fd)
+	{
+	}
+
+	virtual bool Write(const void *data, size_t size);
+};
@@ -0,0 +1,306 @@
+#include "PLYWriter.h"
+#include "ChunkWriter.h"
+#include "MemoryBudget.h"
+
+// vertices decoded per chunk
+#define PLY_CHUNK_VERTICES 1024
+
+PLYWriter::PLYWriter(SDKMesh *mesh, const char *output)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_stats(NULL),
+	m_budget(NULL),
+	m_attributes(VA_ALL),
+	m_transform(NULL),
+	m_sink(NULL)
+{
+	if (m_file.Open(output, "wb"))
+		m_sink = &m_file;
+}
+
+PLYWriter::PLYWriter(SDKMesh *mesh, OutputSink *sink)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_stats(NULL),
+	m_budget(NULL),
+	m_attributes(VA_ALL),
+	m_transform(NULL),
+	m_sink(sink)
+{
+}
+
+PLYWriter::~PLYWriter()
+{
+	m_file.Close();
+}
+
+bool PLYWriter::CanWrite()
+{
+	if (m_sink == NULL)
+		return false;
+
+	return true;
+}
+
+UINT64 PLYWriter::GetWindowIndices(SubsetDecoder& decoder, SDKMESH_SUBSET *subset)
+{
+	if (m_budget == NULL || !decoder.CanRemapWindows() || subset->IndexCount <= m_budget->GetWindowIndices())
+		return subset->IndexCount > 0 ? subset->IndexCount : 1;
+
+	return m_budget->GetWindowIndices();
+}
+
+bool PLYWriter::RemapWindow(SubsetDecoder& decoder, SDKMESH_SUBSET *subset, UINT64 first, UINT64 window, UINT base, SubsetRemap& remap)
+{
+	bool remapped;
+	{
+		StatsScope scope(m_stats, SP_REMAP);
+		if (window >= subset->IndexCount)
+			remapped = decoder.Remap(subset, remap);
+		else
+			remapped = decoder.RemapWindow(subset, first, window, base, remap);
+	}
+
+	if (m_budget != NULL)
+		m_budget->Consume(remap.Indices.size() * decoder.GetIndexSize());
+
+	return remapped;
+}
+
+bool PLYWriter::Write()
+{
+	bool success = true;
+
+	// pass 1: count vertices, faces and the attributes used by any mesh
+	UINT64 numVertices = 0;
+	UINT64 numFaces = 0;
+	bool hasNormal = false;
+	bool hasTexcoord = false;
+	bool hasColor = false;
+
+	SubsetRemap remap;
+	RemapScratch scratch(remap);
+
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SubsetDecoder decoder(m_sdkMesh, meshIdx, m_processor, m_attributes);
+		decoder.SetTransform(m_transform);
+		decoder.SetBudget(m_budget);
+		if (!decoder.HasPosition())
+			continue;
+
+		hasNormal |= decoder.HasNormal();
+		hasTexcoord |= decoder.HasTexcoord();
+		hasColor |= decoder.HasColor();
+
+		UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			SDKMESH_SUBSET* subset = m_sdkMesh->GetSubset(meshIdx, i);
+			if (subset->PrimitiveType != PT_TRIANGLE_LIST)
+				continue;
+
+			// -budget: large subsets in windows, the vertices of a window follow the previous ones
+			UINT64 window = GetWindowIndices(decoder, subset);
+			UINT base = 0;
+
+			for (UINT64 first = 0; first < subset->IndexCount || first == 0; first += window)
+			{
+				if (!RemapWindow(decoder, subset, first, window, base, remap))
+					success = false;
+
+				base += (UINT)remap.Vertices.size();
+				numVertices += remap.Vertices.size();
+				numFaces += remap.Indices.size() / 3;
+
+				if (m_stats != NULL)
+				{
+					m_stats->Add(SC_VERTICES, remap.Vertices.size());
+					m_stats->Add(SC_FACES, remap.Indices.size() / 3);
+					m_stats->Add(SC_REMAP_HITS, remap.Indices.size() - remap.Vertices.size());
+				}
+			}
+
+			if (window < subset->IndexCount)
+				decoder.EndWindows();
+
+			if (m_stats != NULL)
+				m_stats->Add(SC_SUBSETS, 1);
+		}
+	}
+
+	ChunkWriter out(m_sink);
+	out.SetStats(m_stats);
+
+	out.Print("ply\n");
+	out.Print("format binary_little_endian 1.0\n");
+	out.Print("comment exported by SDKMesh Expoter\n");
+	out.Print("element vertex %llu\n", (unsigned long long)numVertices);
+	out.Print("property float x\n");
+	out.Print("property float y\n");
+	out.Print("property float z\n");
+	if (hasNormal)
+	{
+		out.Print("property float nx\n");
+		out.Print("property float ny\n");
+		out.Print("property float nz\n");
+	}
+	if (hasTexcoord)
+	{
+		out.Print("property float s\n");
+		out.Print("property float t\n");
+	}
+	if (hasColor)
+	{
+		out.Print("property uchar red\n");
+		out.Print("property uchar green\n");
+		out.Print("property uchar blue\n");
+		out.Print("property uchar alpha\n");
+	}
+	out.Print("element face %llu\n", (unsigned long long)numFaces);
+	out.Print("property list uchar int vertex_indices\n");
+	out.Print("end_header\n");
+
+	float positions[PLY_CHUNK_VERTICES * 3];
+	float normals[PLY_CHUNK_VERTICES * 3];
+	float texcoords[PLY_CHUNK_VERTICES * 2];
+	float colors[PLY_CHUNK_VERTICES * 4];
+
+	// pass 2: vertices
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SubsetDecoder decoder(m_sdkMesh, meshIdx, m_processor, m_attributes);
+		decoder.SetTransform(m_transform);
+		decoder.SetBudget(m_budget);
+		if (!decoder.HasPosition())
+			continue;
+
+		UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			SDKMESH_SUBSET* subset = m_sdkMesh->GetSubset(meshIdx, i);
+			if (subset->PrimitiveType != PT_TRIANGLE_LIST)
+				continue;
+
+			UINT64 window = GetWindowIndices(decoder, subset);
+			UINT base = 0;
+
+			for (UINT64 first = 0; first < subset->IndexCount || first == 0; first += window)
+			{
+				RemapWindow(decoder, subset, first, window, base, remap);
+				base += (UINT)remap.Vertices.size();
+
+				for (UINT begin = 0, n = (UINT)remap.Vertices.size(); begin < n; begin += PLY_CHUNK_VERTICES)
+				{
+					UINT count = n - begin < PLY_CHUNK_VERTICES ? n - begin : PLY_CHUNK_VERTICES;
+					const UINT *chunk = remap.Vertices.data() + begin;
+
+					{
+						StatsScope scope(m_stats, SP_DECODE);
+
+						decoder.DecodePositions(chunk, count, positions);
+
+						if (hasNormal && !decoder.DecodeNormals(chunk, count, normals))
+							memset(normals, 0, sizeof(float) * 3 * count);
+
+						if (hasTexcoord && !decoder.DecodeTexcoords(chunk, count, texcoords))
+							memset(texcoords, 0, sizeof(float) * 2 * count);
+
+						if (hasColor && !decoder.DecodeColors(chunk, count, colors))
+						{
+							for (UINT j = 0; j < count * 4; j++)
+								colors[j] = 1.0f;
+						}
+					}
+
+					for (UINT j = 0; j < count; j++)
+					{
+						out.Write(positions + j * 3, sizeof(float) * 3);
+
+						if (hasNormal)
+							out.Write(normals + j * 3, sizeof(float) * 3);
+
+						if (hasTexcoord)
+							out.Write(texcoords + j * 2, sizeof(float) * 2);
+
+						if (hasColor)
+						{
+							BYTE rgba[4];
+							for (int k = 0; k < 4; k++)
+							{
+								float c = colors[j * 4 + k];
+								c = c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+								rgba[k] = (BYTE)(c * 255.0f + 0.5f);
+							}
+							out.Write(rgba, 4);
+						}
+					}
+				}
+			}
+
+			if (window < subset->IndexCount)
+				decoder.EndWindows();
+		}
+	}
+
+	// pass 3: faces
+	UINT64 vertexOffset = 0;
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SubsetDecoder decoder(m_sdkMesh, meshIdx, m_processor, m_attributes);
+		decoder.SetTransform(m_transform);
+		decoder.SetBudget(m_budget);
+		if (!decoder.HasPosition())
+			continue;
+
+		UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			SDKMESH_SUBSET* subset = m_sdkMesh->GetSubset(meshIdx, i);
+			if (subset->PrimitiveType != PT_TRIANGLE_LIST)
+				continue;
+
+			// the window indices are numbered from the start of the subset
+			UINT64 window = GetWindowIndices(decoder, subset);
+			UINT base = 0;
+
+			for (UINT64 first = 0; first < subset->IndexCount || first == 0; first += window)
+			{
+				RemapWindow(decoder, subset, first, window, base, remap);
+				base += (UINT)remap.Vertices.size();
+
+				const std::vector<UINT>& indices = remap.Indices;
+				for (size_t j = 0, n = indices.size(); j < n; j += 3)
+				{
+					BYTE face[13];
+					face[0] = 3;
+
+					int f[3];
+					f[0] = (int)(indices[j] + vertexOffset);
+					f[1] = (int)(indices[j + 1] + vertexOffset);
+					f[2] = (int)(indices[j + 2] + vertexOffset);
+
+					if (m_transform != NULL)
+						m_transform->OrderTriangle(f[1], f[2]);
+
+					memcpy(face + 1, f, sizeof(f));
+
+					out.Write(face, sizeof(face));
+				}
+			}
+
+			if (window < subset->IndexCount)
+				decoder.EndWindows();
+
+			vertexOffset += base;
+		}
+	}
+
+	out.Flush();
+
+	if (out.HasError())
+		success = false;
+
+	return success;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "SubsetDecoder.h"
+#include "OutputSink.h"
+#include "VertexTransform.h"
+
+class ConvertStats;
+class MemoryBudget;
+
+// Binary little-endian PLY (positions, normals, uvs, colors)
+class PLYWriter
+{
+protected:
+	SDKMesh *m_sdkMesh;
+	MeshProcessor *m_processor;
+	ConvertStats *m_stats;
+	MemoryBudget *m_budget;
+
+	// VERTEX_ATTRIBUTE flags, the properties of the stripped ones are not written
+	UINT m_attributes;
+
+	// coordinate conversion & winding (not owned), NULL: none
+	const VertexTransform *m_transform;
+
+	FileSink m_file;
+	OutputSink *m_sink;
+
+public:
+	PLYWriter(SDKMesh *mesh, const char *output);
+
+	// write to a memory buffer, a callback or a descriptor, the sink is not owned
+	PLYWriter(SDKMesh *mesh, OutputSink *sink);
+
+	virtual ~PLYWriter();
+
+	bool CanWrite();
+
+	void SetProcessor(MeshProcessor *processor)
+	{
+		m_processor = processor;
+	}
+
+	// remap, decode & flush times and the written counters, NULL: off
+	void SetStats(ConvertStats *stats)
+	{
+		m_stats = stats;
+	}
+
+	// -attributes: x y z only for VA_POSITION
+	void SetAttributes(UINT attributes)
+	{
+		m_attributes = attributes;
+	}
+
+	void SetTransform(const VertexTransform *transform)
+	{
+		m_transform = transform;
+	}
+
+	// large subsets are remapped in windows, the consumed input is reported
+	void SetBudget(MemoryBudget *budget)
+	{
+		m_budget = budget;
+	}
+
+	// write all TRIANGLE_LIST subsets of all meshes
+	bool Write();
+
+protected:
+	// indices of a window: the whole subset without a budget
+	UINT64 GetWindowIndices(SubsetDecoder& decoder, SDKMESH_SUBSET *subset);
+
+	bool RemapWindow(SubsetDecoder& decoder, SDKMESH_SUBSET *subset, UINT64 first, UINT64 window, UINT base, SubsetRemap& remap);
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include "TaskPool.h"
+
+// Number of worker threads to use when the user did not set one
+inline int GetDefaultNumThreads()
+{
+	unsigned int n = std::thread::hardware_concurrency();
+	return n > 0 ? (int)n : 1;
+}
+
+// Run func(index, threadID) for index in [0, count) on numThreads threads.
+// Items are handed out one by one so uneven items balance across threads.
+// Called from a TaskPool worker, the items run as tasks of the pool (idle workers steal them).
+template<class T>
+void ParallelFor(size_t count, int numThreads, T func)
+{
+	if (numThreads < 1)
+		numThreads = 1;
+
+	if ((size_t)numThreads > count)
+		numThreads = (int)count;
+
+	if (numThreads <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+			func(i, 0);
+		return;
+	}
+
+	TaskPool *pool = TaskPool::GetCurrent();
+	if (pool != NULL)
+	{
+		pool->ParallelFor(count, numThreads, func);
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.push_back(std::thread([&next, &func, count, t]()
+		{
+			size_t i;
+			while ((i = next.fetch_add(1)) < count)
+				func(i, t);
+		}));
+	}
+
+	for (size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+}
@@ -9,6 +9,12 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 //--------------------------------------------------------------------------------------
 #include "SDKMesh.h"
+#include "MeshCache.h"
+#include "MatrixMath.h"
+#include "Arena.h"
+#include "Log.h"
+
+#include <cstring>
 
 #ifndef SAFE_DELETE
 #define SAFE_DELETE(p)       { if (p) { delete (p);     (p)=NULL; } }
@@ -71,6 +77,10 @@ HRESULT SDKMesh::CreateFromMemory(BYTE* pData,
 {
 	HRESULT hr = E_FAIL;
 
+	// during a conversion session the copies come from its arena
+	Arena* pArena = Arena::GetCurrent();
+	m_bArenaData = pArena != NULL;
+
 	// Set outstanding resources to zero
 	m_NumOutstandingResources = 0;
 
@@ -79,11 +89,19 @@ HRESULT SDKMesh::CreateFromMemory(BYTE* pData,
 		SDKMESH_HEADER* pHeader = (SDKMESH_HEADER*)pData;
 
 		SIZE_T StaticSize = (SIZE_T)(pHeader->HeaderSize + pHeader->NonBufferDataSize);
-		m_pHeapData = new BYTE[StaticSize];
-		if (!m_pHeapData)
-			return hr;
-
-		m_pStaticMeshData = m_pHeapData;
+		if (pArena)
+		{
+			m_pHeapData = NULL;
+			m_pStaticMeshData = pArena->Allocate<BYTE>(StaticSize);
+		}
+		else
+		{
+			m_pHeapData = new BYTE[StaticSize];
+			if (!m_pHeapData)
+				return hr;
+
+			m_pStaticMeshData = m_pHeapData;
+		}
 
 		memcpy(m_pStaticMeshData, pData, StaticSize);
 	}
@@ -94,20 +112,7 @@ HRESULT SDKMesh::CreateFromMemory(BYTE* pData,
 	}
 
 	// Pointer fixup
-	m_pMeshHeader = (SDKMESH_HEADER*)m_pStaticMeshData;
-	m_pVertexBufferArray = (SDKMESH_VERTEX_BUFFER_HEADER*)(m_pStaticMeshData + m_pMeshHeader->VertexStreamHeadersOffset);
-	m_pIndexBufferArray = (SDKMESH_INDEX_BUFFER_HEADER*)(m_pStaticMeshData + m_pMeshHeader->IndexStreamHeadersOffset);
-	m_pMeshArray = (SDKMESH_MESH*)(m_pStaticMeshData + m_pMeshHeader->MeshDataOffset);
-	m_pSubsetArray = (SDKMESH_SUBSET*)(m_pStaticMeshData + m_pMeshHeader->SubsetDataOffset);
-	m_pFrameArray = (SDKMESH_FRAME*)(m_pStaticMeshData + m_pMeshHeader->FrameDataOffset);
-	m_pMaterialArray = (SDKMESH_MATERIAL*)(m_pStaticMeshData + m_pMeshHeader->MaterialDataOffset);
-
-	// Setup subsets
-	for (UINT i = 0; i < m_pMeshHeader->NumMeshes; i++)
-	{
-		m_pMeshArray[i].pSubsets = (UINT*)(m_pStaticMeshData + m_pMeshArray[i].SubsetOffset);
-		m_pMeshArray[i].pFrameInfluences = (UINT*)(m_pStaticMeshData + m_pMeshArray[i].FrameInfluenceOffset);
-	}
+	FixupPointers();
 
 	// error condition
 	if (m_pMeshHeader->Version != SDKMESH_FILE_VERSION)
@@ -123,7 +128,7 @@ HRESULT SDKMesh::CreateFromMemory(BYTE* pData,
 	UINT64 BufferDataStart = m_pMeshHeader->HeaderSize + m_pMeshHeader->NonBufferDataSize;
 
 	// Create VBs
-	m_ppVertices = new BYTE*[m_pMeshHeader->NumVertexBuffers];
+	m_ppVertices = pArena ? pArena->Allocate<BYTE*>(m_pMeshHeader->NumVertexBuffers) : new BYTE*[m_pMeshHeader->NumVertexBuffers];
 	for (UINT i = 0; i < m_pMeshHeader->NumVertexBuffers; i++)
 	{
 		BYTE* pVertices = NULL;
@@ -133,7 +138,7 @@ HRESULT SDKMesh::CreateFromMemory(BYTE* pData,
 	}
 
 	// Create IBs
-	m_ppIndices = new BYTE*[m_pMeshHeader->NumIndexBuffers];
+	m_ppIndices = pArena ? pArena->Allocate<BYTE*>(m_pMeshHeader->NumIndexBuffers) : new BYTE*[m_pMeshHeader->NumIndexBuffers];
 	for (UINT i = 0; i < m_pMeshHeader->NumIndexBuffers; i++)
 	{
 		BYTE* pIndices = NULL;
@@ -148,6 +153,131 @@ Error:
 	return hr;
 }
 
+//--------------------------------------------------------------------------------------
+HRESULT SDKMesh::CreateFromCache(MeshCache* pCache)
+{
+	UINT64 size = 0;
+	BYTE* pData = pCache->GetSDKMeshData(&size);
+
+	SDKMESH_HEADER* pHeader = (SDKMESH_HEADER*)pData;
+	if (size < sizeof(SDKMESH_HEADER) ||
+		pHeader->Version != SDKMESH_FILE_VERSION ||
+		pHeader->HeaderSize + pHeader->NonBufferDataSize != size)
+		return E_FAIL;
+
+	// The header data lives in the (copy-on-write) mapped cache, there are no buffers
+	m_NumOutstandingResources = 0;
+	m_pHeapData = NULL;
+	m_pStaticMeshData = pData;
+	m_pCache = pCache;
+
+	FixupPointers();
+
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+static bool IsInRange(UINT64 Offset, UINT64 Count, UINT64 Stride, UINT64 Size)
+{
+	return Offset <= Size && Count <= (Size - Offset) / Stride;
+}
+
+HRESULT SDKMesh::CreateFromHeaders(BYTE* pData, UINT64 DataBytes)
+{
+	SDKMESH_HEADER* pHeader = (SDKMESH_HEADER*)pData;
+	if (DataBytes < sizeof(SDKMESH_HEADER) ||
+		pHeader->Version != SDKMESH_FILE_VERSION ||
+		pHeader->HeaderSize > DataBytes ||
+		pHeader->NonBufferDataSize > DataBytes - pHeader->HeaderSize)
+		return E_FAIL;
+
+	// every array must be in the static data
+	UINT64 Size = pHeader->HeaderSize + pHeader->NonBufferDataSize;
+	if (!IsInRange(pHeader->VertexStreamHeadersOffset, pHeader->NumVertexBuffers, sizeof(SDKMESH_VERTEX_BUFFER_HEADER), Size) ||
+		!IsInRange(pHeader->IndexStreamHeadersOffset, pHeader->NumIndexBuffers, sizeof(SDKMESH_INDEX_BUFFER_HEADER), Size) ||
+		!IsInRange(pHeader->MeshDataOffset, pHeader->NumMeshes, sizeof(SDKMESH_MESH), Size) ||
+		!IsInRange(pHeader->SubsetDataOffset, pHeader->NumTotalSubsets, sizeof(SDKMESH_SUBSET), Size) ||
+		!IsInRange(pHeader->FrameDataOffset, pHeader->NumFrames, sizeof(SDKMESH_FRAME), Size) ||
+		!IsInRange(pHeader->MaterialDataOffset, pHeader->NumMaterials, sizeof(SDKMESH_MATERIAL), Size))
+		return E_FAIL;
+
+	SDKMESH_MESH* pMeshes = (SDKMESH_MESH*)(pData + pHeader->MeshDataOffset);
+	for (UINT i = 0; i < pHeader->NumMeshes; i++)
+	{
+		SDKMESH_MESH& mesh = pMeshes[i];
+		if (mesh.NumVertexBuffers > MAX_VERTEX_STREAMS ||
+			mesh.IndexBuffer >= pHeader->NumIndexBuffers ||
+			!IsInRange(mesh.SubsetOffset, mesh.NumSubsets, sizeof(UINT), Size) ||
+			!IsInRange(mesh.FrameInfluenceOffset, mesh.NumFrameInfluences, sizeof(UINT), Size))
+			return E_FAIL;
+
+		for (UINT j = 0; j < mesh.NumVertexBuffers; j++)
+		{
+			if (mesh.VertexBuffers[j] >= pHeader->NumVertexBuffers)
+				return E_FAIL;
+		}
+
+		const UINT* pSubsets = (const UINT*)(pData + mesh.SubsetOffset);
+		for (UINT j = 0; j < mesh.NumSubsets; j++)
+		{
+			if (pSubsets[j] >= pHeader->NumTotalSubsets)
+				return E_FAIL;
+		}
+	}
+
+	// No buffers: vertex & index data are not read
+	m_NumOutstandingResources = 0;
+	m_pHeapData = NULL;
+	m_pStaticMeshData = pData;
+
+	FixupPointers();
+
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+void SDKMesh::FixupPointers()
+{
+	m_pMeshHeader = (SDKMESH_HEADER*)m_pStaticMeshData;
+	m_pVertexBufferArray = (SDKMESH_VERTEX_BUFFER_HEADER*)(m_pStaticMeshData + m_pMeshHeader->VertexStreamHeadersOffset);
+	m_pIndexBufferArray = (SDKMESH_INDEX_BUFFER_HEADER*)(m_pStaticMeshData + m_pMeshHeader->IndexStreamHeadersOffset);
+	m_pMeshArray = (SDKMESH_MESH*)(m_pStaticMeshData + m_pMeshHeader->MeshDataOffset);
+	m_pSubsetArray = (SDKMESH_SUBSET*)(m_pStaticMeshData + m_pMeshHeader->SubsetDataOffset);
+	m_pFrameArray = (SDKMESH_FRAME*)(m_pStaticMeshData + m_pMeshHeader->FrameDataOffset);
+	m_pMaterialArray = (SDKMESH_MATERIAL*)(m_pStaticMeshData + m_pMeshHeader->MaterialDataOffset);
+
+	// Setup subsets
+	for (UINT i = 0; i < m_pMeshHeader->NumMeshes; i++)
+	{
+		m_pMeshArray[i].pSubsets = (UINT*)(m_pStaticMeshData + m_pMeshArray[i].SubsetOffset);
+		m_pMeshArray[i].pFrameInfluences = (UINT*)(m_pStaticMeshData + m_pMeshArray[i].FrameInfluenceOffset);
+	}
+
+	// Frame matrices, identity until TransformBindPose/TransformMesh
+	DestroyFrameMatrices();
+
+	Arena* pArena = m_bArenaData ? Arena::GetCurrent() : NULL;
+	if (pArena)
+	{
+		m_pBindPoseFrameMatrices = pArena->Allocate<D3DXMATRIX>(m_pMeshHeader->NumFrames);
+		m_pTransformedFrameMatrices = pArena->Allocate<D3DXMATRIX>(m_pMeshHeader->NumFrames);
+		m_pWorldPoseFrameMatrices = pArena->Allocate<D3DXMATRIX>(m_pMeshHeader->NumFrames);
+	}
+	else
+	{
+		m_pBindPoseFrameMatrices = new D3DXMATRIX[m_pMeshHeader->NumFrames];
+		m_pTransformedFrameMatrices = new D3DXMATRIX[m_pMeshHeader->NumFrames];
+		m_pWorldPoseFrameMatrices = new D3DXMATRIX[m_pMeshHeader->NumFrames];
+	}
+
+	for (UINT i = 0; i < m_pMeshHeader->NumFrames; i++)
+	{
+		MatrixIdentity(&m_pBindPoseFrameMatrices[i]);
+		MatrixIdentity(&m_pTransformedFrameMatrices[i]);
+		MatrixIdentity(&m_pWorldPoseFrameMatrices[i]);
+	}
+}
+
 #define MAX_D3D11_VERTEX_STREAMS D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT
 
 
@@ -163,9 +293,12 @@ SDKMesh::SDKMesh() : m_NumOutstandingResources(0),
 	m_pAnimationHeader(NULL),
 	m_ppVertices(NULL),
 	m_ppIndices(NULL),
+	m_bArenaData(false),
+	m_bSharedBuffers(false),
 	m_pBindPoseFrameMatrices(NULL),
 	m_pTransformedFrameMatrices(NULL),
-	m_pWorldPoseFrameMatrices(NULL)
+	m_pWorldPoseFrameMatrices(NULL),
+	m_pCache(NULL)
 {
 }
 
@@ -188,6 +321,41 @@ HRESULT SDKMesh::Create(BYTE* pData, UINT DataBytes, bool bCreateAdjacencyIndice
 	return CreateFromMemory(pData, DataBytes, bCreateAdjacencyIndices, bCopyStatic);
 }
 
+//--------------------------------------------------------------------------------------
+HRESULT SDKMesh::Create(MeshCache* pCache)
+{
+	return CreateFromCache(pCache);
+}
+
+//--------------------------------------------------------------------------------------
+HRESULT SDKMesh::CreateHeadersOnly(BYTE* pData, UINT64 DataBytes)
+{
+	return CreateFromHeaders(pData, DataBytes);
+}
+
+//--------------------------------------------------------------------------------------
+void SDKMesh::SetBuffers(BYTE** ppVertices, BYTE** ppIndices)
+{
+	m_ppVertices = ppVertices;
+	m_ppIndices = ppIndices;
+	m_bSharedBuffers = true;
+}
+
+//--------------------------------------------------------------------------------------
+void SDKMesh::DestroyFrameMatrices()
+{
+	if (m_bArenaData)
+	{
+		m_pBindPoseFrameMatrices = NULL;
+		m_pTransformedFrameMatrices = NULL;
+		m_pWorldPoseFrameMatrices = NULL;
+	}
+
+	SAFE_DELETE_ARRAY(m_pBindPoseFrameMatrices);
+	SAFE_DELETE_ARRAY(m_pTransformedFrameMatrices);
+	SAFE_DELETE_ARRAY(m_pWorldPoseFrameMatrices);
+}
+
 //--------------------------------------------------------------------------------------
 void SDKMesh::Destroy()
 {
@@ -196,9 +364,15 @@ void SDKMesh::Destroy()
 	SAFE_DELETE_ARRAY(m_pHeapData);
 	m_pStaticMeshData = NULL;
 	SAFE_DELETE_ARRAY(m_pAnimationData);
-	SAFE_DELETE_ARRAY(m_pBindPoseFrameMatrices);
-	SAFE_DELETE_ARRAY(m_pTransformedFrameMatrices);
-	SAFE_DELETE_ARRAY(m_pWorldPoseFrameMatrices);
+	DestroyFrameMatrices();
+
+	if (m_bArenaData || m_bSharedBuffers)
+	{
+		m_ppVertices = NULL;
+		m_ppIndices = NULL;
+		m_bArenaData = false;
+		m_bSharedBuffers = false;
+	}
 
 	SAFE_DELETE_ARRAY(m_ppVertices);
 	SAFE_DELETE_ARRAY(m_ppIndices);
@@ -214,6 +388,222 @@ void SDKMesh::Destroy()
 	m_pAnimationHeader = NULL;
 	m_pAnimationFrameData = NULL;
 
+	m_pCache = NULL;
+
+}
+
+//--------------------------------------------------------------------------------------
+HRESULT SDKMesh::LoadAnimation(const char* szFileName)
+{
+	if (!m_pMeshHeader)
+		return E_FAIL;
+
+	FILE* hFile = fopen(szFileName, "rb");
+	if (hFile == NULL)
+		return E_FAIL;
+
+	// Get the file size
+	fseek(hFile, 0, SEEK_END);
+	SIZE_T fileSize = ftell(hFile);
+	fseek(hFile, 0, SEEK_SET);
+
+	SDKANIMATION_FILE_HEADER fileheader;
+	if (fileSize < sizeof(SDKANIMATION_FILE_HEADER) ||
+		!fread(&fileheader, sizeof(SDKANIMATION_FILE_HEADER), 1, hFile))
+	{
+		fclose(hFile);
+		return E_FAIL;
+	}
+
+	UINT64 dataSize = sizeof(SDKANIMATION_FILE_HEADER) + fileheader.AnimationDataSize;
+	if (dataSize > fileSize || fileheader.NumAnimationKeys == 0)
+	{
+		fclose(hFile);
+		return E_FAIL;
+	}
+
+	// Allocate and read the whole animation
+	SAFE_DELETE_ARRAY(m_pAnimationData);
+	m_pAnimationHeader = NULL;
+	m_pAnimationFrameData = NULL;
+
+	m_pAnimationData = new BYTE[(SIZE_T)dataSize];
+
+	fseek(hFile, 0, SEEK_SET);
+	bool success = fread(m_pAnimationData, (SIZE_T)dataSize, 1, hFile) == 1;
+	fclose(hFile);
+
+	SDKANIMATION_FILE_HEADER* pHeader = (SDKANIMATION_FILE_HEADER*)m_pAnimationData;
+	UINT64 BaseOffset = sizeof(SDKANIMATION_FILE_HEADER);
+	UINT64 keysSize = (UINT64)pHeader->NumAnimationKeys * sizeof(SDKANIMATION_DATA);
+
+	if (success)
+		success = pHeader->AnimationDataOffset + (UINT64)pHeader->NumFrames * sizeof(SDKANIMATION_FRAME_DATA) <= dataSize;
+
+	// Pointer fixup
+	SDKANIMATION_FRAME_DATA* pFrameData = (SDKANIMATION_FRAME_DATA*)(m_pAnimationData + pHeader->AnimationDataOffset);
+	for (UINT i = 0; success && i < pHeader->NumFrames; i++)
+	{
+		if (pFrameData[i].DataOffset + BaseOffset + keysSize > dataSize)
+		{
+			success = false;
+			break;
+		}
+
+		pFrameData[i].pAnimationData = (SDKANIMATION_DATA*)(m_pAnimationData + pFrameData[i].DataOffset + BaseOffset);
+	}
+
+	if (!success)
+	{
+		SAFE_DELETE_ARRAY(m_pAnimationData);
+		return E_FAIL;
+	}
+
+	m_pAnimationHeader = pHeader;
+	m_pAnimationFrameData = pFrameData;
+
+	// Link the frames to their keys
+	for (UINT i = 0; i < m_pMeshHeader->NumFrames; i++)
+		m_pFrameArray[i].AnimationDataIndex = INVALID_ANIMATION_DATA;
+
+	for (UINT i = 0; i < m_pAnimationHeader->NumFrames; i++)
+	{
+		SDKMESH_FRAME* pFrame = FindFrame(m_pAnimationFrameData[i].FrameName);
+		if (pFrame)
+			pFrame->AnimationDataIndex = i;
+	}
+
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+// transform the bind pose
+//--------------------------------------------------------------------------------------
+void SDKMesh::TransformBindPose(const D3DXMATRIX* pWorld)
+{
+	if (m_pMeshHeader && m_pMeshHeader->NumFrames > 0)
+		TransformBindPoseFrame(0, pWorld);
+}
+
+//--------------------------------------------------------------------------------------
+// transform the mesh frames according to the animation for time fTime
+//--------------------------------------------------------------------------------------
+void SDKMesh::TransformMesh(const D3DXMATRIX* pWorld, double fTime)
+{
+	if (!m_pMeshHeader || m_pMeshHeader->NumFrames == 0)
+		return;
+
+	if (m_pAnimationHeader == NULL || FTT_RELATIVE == m_pAnimationHeader->FrameTransformType)
+	{
+		TransformFrame(0, pWorld, fTime);
+
+		// For each frame, move the transform to the bind pose, then
+		// move it to the final position
+		D3DXMATRIX mInvBindPose;
+		for (UINT i = 0; i < m_pMeshHeader->NumFrames; i++)
+		{
+			MatrixInverse(&mInvBindPose, &m_pBindPoseFrameMatrices[i]);
+			MatrixMultiply(&m_pTransformedFrameMatrices[i], &mInvBindPose, &m_pTransformedFrameMatrices[i]);
+		}
+	}
+	else if (FTT_ABSOLUTE == m_pAnimationHeader->FrameTransformType)
+	{
+		for (UINT i = 0; i < m_pMeshHeader->NumFrames; i++)
+			TransformFrameAbsolute(i, fTime);
+	}
+}
+
+//--------------------------------------------------------------------------------------
+void SDKMesh::TransformBindPoseFrame(UINT iFrame, const D3DXMATRIX* pParentWorld)
+{
+	if (iFrame >= m_pMeshHeader->NumFrames)
+		return;
+
+	// Transform ourselves
+	D3DXMATRIX LocalWorld;
+	MatrixMultiply(&LocalWorld, &m_pFrameArray[iFrame].Matrix, pParentWorld);
+	m_pBindPoseFrameMatrices[iFrame] = LocalWorld;
+
+	// Transform our siblings
+	if (m_pFrameArray[iFrame].SiblingFrame != INVALID_FRAME)
+		TransformBindPoseFrame(m_pFrameArray[iFrame].SiblingFrame, pParentWorld);
+
+	// Transform our children
+	if (m_pFrameArray[iFrame].ChildFrame != INVALID_FRAME)
+		TransformBindPoseFrame(m_pFrameArray[iFrame].ChildFrame, &LocalWorld);
+}
+
+//--------------------------------------------------------------------------------------
+void SDKMesh::TransformFrame(UINT iFrame, const D3DXMATRIX* pParentWorld, double fTime)
+{
+	if (iFrame >= m_pMeshHeader->NumFrames)
+		return;
+
+	// Get the tick data
+	D3DXMATRIX LocalTransform;
+	UINT iTick = GetAnimationKeyFromTime(fTime);
+
+	if (m_pAnimationHeader && INVALID_ANIMATION_DATA != m_pFrameArray[iFrame].AnimationDataIndex &&
+		m_pFrameArray[iFrame].AnimationDataIndex < m_pAnimationHeader->NumFrames)
+	{
+		SDKANIMATION_FRAME_DATA* pFrameData = &m_pAnimationFrameData[m_pFrameArray[iFrame].AnimationDataIndex];
+		SDKANIMATION_DATA* pData = &pFrameData->pAnimationData[iTick];
+
+		// turn it into a matrix (Ignore scaling for now)
+		D3DXMATRIX mTranslate;
+		MatrixTranslation(&mTranslate, pData->Translation.x, pData->Translation.y, pData->Translation.z);
+
+		D3DXMATRIX mQuat;
+		MatrixRotationQuaternion(&mQuat, &pData->Orientation);
+
+		MatrixMultiply(&LocalTransform, &mQuat, &mTranslate);
+	}
+	else
+	{
+		LocalTransform = m_pFrameArray[iFrame].Matrix;
+	}
+
+	// Transform ourselves
+	D3DXMATRIX LocalWorld;
+	MatrixMultiply(&LocalWorld, &LocalTransform, pParentWorld);
+	m_pTransformedFrameMatrices[iFrame] = LocalWorld;
+	m_pWorldPoseFrameMatrices[iFrame] = LocalWorld;
+
+	// Transform our siblings
+	if (m_pFrameArray[iFrame].SiblingFrame != INVALID_FRAME)
+		TransformFrame(m_pFrameArray[iFrame].SiblingFrame, pParentWorld, fTime);
+
+	// Transform our children
+	if (m_pFrameArray[iFrame].ChildFrame != INVALID_FRAME)
+		TransformFrame(m_pFrameArray[iFrame].ChildFrame, &LocalWorld, fTime);
+}
+
+//--------------------------------------------------------------------------------------
+void SDKMesh::TransformFrameAbsolute(UINT iFrame, double fTime)
+{
+	UINT iTick = GetAnimationKeyFromTime(fTime);
+
+	if (INVALID_ANIMATION_DATA == m_pFrameArray[iFrame].AnimationDataIndex ||
+		m_pFrameArray[iFrame].AnimationDataIndex >= m_pAnimationHeader->NumFrames)
+		return;
+
+	SDKANIMATION_FRAME_DATA* pFrameData = &m_pAnimationFrameData[m_pFrameArray[iFrame].AnimationDataIndex];
+	SDKANIMATION_DATA* pData = &pFrameData->pAnimationData[iTick];
+	SDKANIMATION_DATA* pDataOrig = &pFrameData->pAnimationData[0];
+
+	// inverse of the first key: translate back then rotate by the conjugate
+	D3DXMATRIX mTrans1, mRot1, mInvTo;
+	MatrixTranslation(&mTrans1, -pDataOrig->Translation.x, -pDataOrig->Translation.y, -pDataOrig->Translation.z);
+	MatrixRotationQuaternion(&mRot1, &pDataOrig->Orientation);
+	MatrixTranspose(&mRot1, &mRot1);
+	MatrixMultiply(&mInvTo, &mTrans1, &mRot1);
+
+	D3DXMATRIX mTrans2, mRot2, mFrom;
+	MatrixTranslation(&mTrans2, pData->Translation.x, pData->Translation.y, pData->Translation.z);
+	MatrixRotationQuaternion(&mRot2, &pData->Orientation);
+	MatrixMultiply(&mFrom, &mRot2, &mTrans2);
+
+	MatrixMultiply(&m_pTransformedFrameMatrices[iFrame], &mInvTo, &mFrom);
 }
 
 
@@ -271,6 +661,18 @@ DXGI_FORMAT SDKMesh::GetIBFormat11( UINT iMesh )
 }
 */
 
+//--------------------------------------------------------------------------------------
+SDKMESH_HEADER* SDKMesh::GetHeader()
+{
+	return m_pMeshHeader;
+}
+
+//--------------------------------------------------------------------------------------
+MeshCache* SDKMesh::GetCache()
+{
+	return m_pCache;
+}
+
 //--------------------------------------------------------------------------------------
 UINT SDKMesh::GetNumMeshes()
 {
@@ -345,6 +747,31 @@ UINT SDKMesh::GetVertexStride(UINT iMesh, UINT iVB)
 	return (UINT)m_pVertexBufferArray[m_pMeshArray[iMesh].VertexBuffers[iVB]].StrideBytes;
 }
 
+//--------------------------------------------------------------------------------------
+UINT SDKMesh::GetNumFrames()
+{
+	if (!m_pMeshHeader)
+		return 0;
+	return m_pMeshHeader->NumFrames;
+}
+
+//--------------------------------------------------------------------------------------
+SDKMESH_FRAME* SDKMesh::GetFrame(UINT iFrame)
+{
+	return &m_pFrameArray[iFrame];
+}
+
+//--------------------------------------------------------------------------------------
+SDKMESH_FRAME* SDKMesh::FindFrame(char* pszName)
+{
+	for (UINT i = 0; i < GetNumFrames(); i++)
+	{
+		if (strncmp(m_pFrameArray[i].Name, pszName, MAX_FRAME_NAME) == 0)
+			return &m_pFrameArray[i];
+	}
+	return NULL;
+}
+
 //--------------------------------------------------------------------------------------
 UINT64 SDKMesh::GetNumVertices(UINT iMesh, UINT iVB)
 {
@@ -367,8 +794,59 @@ const D3DVERTEXELEMENT9* SDKMesh::VBElements(UINT iMesh, UINT iVB)
 	return m_pVertexBufferArray[m_pMeshArray[iMesh].VertexBuffers[iVB]].Decl;
 }
 
+//--------------------------------------------------------------------------------------
+SDKANIMATION_FILE_HEADER* SDKMesh::GetAnimationHeader()
+{
+	return m_pAnimationHeader;
+}
+
+//--------------------------------------------------------------------------------------
+UINT SDKMesh::GetAnimationKeyFromTime(double fTime)
+{
+	if (m_pAnimationHeader == NULL || m_pAnimationHeader->NumAnimationKeys < 2)
+		return 0;
+
+	// key 0 is the reference pose, the loop plays keys 1..NumAnimationKeys-1
+	UINT iTick = (UINT)(m_pAnimationHeader->AnimationFPS * fTime);
+
+	iTick = iTick % (m_pAnimationHeader->NumAnimationKeys - 1);
+	iTick++;
+
+	return iTick;
+}
+
+//--------------------------------------------------------------------------------------
+UINT SDKMesh::GetNumInfluences(UINT iMesh)
+{
+	return m_pMeshArray[iMesh].NumFrameInfluences;
+}
+
+//--------------------------------------------------------------------------------------
+const D3DXMATRIX* SDKMesh::GetMeshInfluenceMatrix(UINT iMesh, UINT iInfluence)
+{
+	UINT iFrame = m_pMeshArray[iMesh].pFrameInfluences[iInfluence];
+	if (iFrame >= GetNumFrames())
+		return NULL;
+	return &m_pTransformedFrameMatrices[iFrame];
+}
+
+//--------------------------------------------------------------------------------------
+const D3DXMATRIX* SDKMesh::GetWorldMatrix(UINT iFrameIndex)
+{
+	return &m_pWorldPoseFrameMatrices[iFrameIndex];
+}
+
+//--------------------------------------------------------------------------------------
+const D3DXMATRIX* SDKMesh::GetBindMatrix(UINT iFrameIndex)
+{
+	return &m_pBindPoseFrameMatrices[iFrameIndex];
+}
+
 void SDKMesh::PrintVBElements(const D3DVERTEXELEMENT9* declaration)
 {
+	if (!Log::IsEnabled(LOG_DEBUG))
+		return;
+
 	std::map<BYTE, const char *> nameMap;
 	nameMap[D3DDECLUSAGE_POSITION] = "POSITION";
 	nameMap[D3DDECLUSAGE_BLENDWEIGHT] = "BLENDWEIGHT";
@@ -403,7 +881,7 @@ void SDKMesh::PrintVBElements(const D3DVERTEXELEMENT9* declaration)
 	while (declaration[numInputElements].Stream != 0xFF)
 	{
 		const D3DVERTEXELEMENT9& element9 = declaration[numInputElements];
-		std::cout << "  + " << nameMap[element9.Usage] << " - " << formatMap[element9.Type] << " - " << element9.Offset << std::endl;
+		LogDebug() << "  + " << nameMap[element9.Usage] << " - " << formatMap[element9.Type] << " - " << element9.Offset << "\n";
 		numInputElements++;
 	}
 }
\ No newline at end of file
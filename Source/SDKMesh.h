@@ -339,6 +339,8 @@ struct SDKANIMATION_FRAME_DATA
 
 #ifndef _CONVERTER_APP_
 
+class MeshCache;
+
 //--------------------------------------------------------------------------------------
 // CDXUTSDKMesh class.  This class reads the sdkmesh file format for use by the samples
 //--------------------------------------------------------------------------------------
@@ -352,6 +354,12 @@ protected:
 	BYTE** m_ppVertices;
 	BYTE** m_ppIndices;
 
+	// the static copy and the buffer pointers are in the session arena (not deleted)
+	bool m_bArenaData;
+
+	// the buffer pointers belong to the caller (SetBuffers)
+	bool m_bSharedBuffers;
+
 	WORD m_NumOutstandingResources;
 
 	//General mesh info
@@ -373,6 +381,9 @@ protected:
 	D3DXMATRIX* m_pTransformedFrameMatrices;
 	D3DXMATRIX* m_pWorldPoseFrameMatrices;
 
+	// Decoded streams when the mesh is loaded from a converted mesh cache (not owned)
+	MeshCache* m_pCache;
+
 protected:
 	virtual HRESULT CreateFromFile(const char* szFileName, bool bCreateAdjacencyIndices);
 
@@ -380,14 +391,39 @@ protected:
 		UINT DataBytes,
 		bool bCreateAdjacencyIndices,
 		bool bCopyStatic);
+
+	virtual HRESULT CreateFromCache(MeshCache* pCache);
+
+	virtual HRESULT CreateFromHeaders(BYTE* pData, UINT64 DataBytes);
+
+	void FixupPointers();
+
+	void DestroyFrameMatrices();
+
+	void TransformBindPoseFrame(UINT iFrame, const D3DXMATRIX* pParentWorld);
+	void TransformFrame(UINT iFrame, const D3DXMATRIX* pParentWorld, double fTime);
+	void TransformFrameAbsolute(UINT iFrame, double fTime);
 public:
 	SDKMesh();
 	virtual ~SDKMesh();
 
 	virtual HRESULT Create(const char* szFileName, bool bCreateAdjacencyIndices = false);
 	virtual HRESULT Create(BYTE* pData, UINT DataBytes, bool bCreateAdjacencyIndices = false, bool bCopyStatic = false);
+	virtual HRESULT Create(MeshCache* pCache);
+
+	// header & non-buffer data only (not copied, not owned): meshes, subsets, frames,
+	// materials and buffer headers, without vertex & index data; the offsets are validated
+	virtual HRESULT CreateHeadersOnly(BYTE* pData, UINT64 DataBytes);
+
+	// vertex & index buffers of a headers-only mesh, read apart: a pointer per buffer,
+	// NULL for the buffers that are not read (not copied, not owned)
+	void SetBuffers(BYTE** ppVertices, BYTE** ppIndices);
 	virtual void Destroy();
 
+	//Frame manipulation
+	HRESULT LoadAnimation(const char* szFileName);
+	void TransformBindPose(const D3DXMATRIX* pWorld);
+	void TransformMesh(const D3DXMATRIX* pWorld, double fTime);
 
 	// Helpers (D3D11 specific)
 	// static D3D11_PRIMITIVE_TOPOLOGY GetPrimitiveType11(SDKMESH_PRIMITIVE_TYPE PrimType);
@@ -395,6 +431,8 @@ public:
 	SDKMESH_INDEX_TYPE              GetIndexType(UINT iMesh);
 
 	//Helpers (general)
+	SDKMESH_HEADER*                 GetHeader();
+	MeshCache*                      GetCache();
 	UINT                            GetNumMeshes();
 	UINT                            GetNumMaterials();
 	UINT                            GetNumVBs();
@@ -413,6 +451,15 @@ public:
 	UINT64                          GetNumVertices(UINT iMesh, UINT iVB);
 	UINT64                          GetNumIndices(UINT iMesh);
 	const D3DVERTEXELEMENT9*        VBElements(UINT iMesh, UINT iV);
+
+	//Animation helpers
+	SDKANIMATION_FILE_HEADER*       GetAnimationHeader();
+	UINT                            GetAnimationKeyFromTime(double fTime);
+	UINT                            GetNumInfluences(UINT iMesh);
+	const D3DXMATRIX*               GetMeshInfluenceMatrix(UINT iMesh, UINT iInfluence);
+	const D3DXMATRIX*               GetWorldMatrix(UINT iFrameIndex);
+	const D3DXMATRIX*               GetBindMatrix(UINT iFrameIndex);
+
 	void							PrintVBElements(const D3DVERTEXELEMENT9* declaration);
 };
 
@@ -0,0 +1,300 @@
+#include "SDKMeshWriter.h"
+#include "ChunkWriter.h"
+
+#include <cstring>
+
+static UINT64 AlignOffset(UINT64 offset)
+{
+	return (offset + SDKMESHWRITER_ALIGNMENT - 1) / SDKMESHWRITER_ALIGNMENT * SDKMESHWRITER_ALIGNMENT;
+}
+
+static void WritePadding(ChunkWriter& out, UINT64& offset, UINT64 alignedOffset)
+{
+	static const BYTE zero[SDKMESHWRITER_ALIGNMENT] = { 0 };
+	out.Write(zero, (size_t)(alignedOffset - offset));
+	offset = alignedOffset;
+}
+
+SDKMeshWriter::SDKMeshWriter()
+{
+}
+
+SDKMeshWriter::~SDKMeshWriter()
+{
+	for (size_t i = 0; i < m_vertexBuffers.size(); i++)
+		delete m_vertexBuffers[i];
+
+	for (size_t i = 0; i < m_indexBuffers.size(); i++)
+		delete m_indexBuffers[i];
+}
+
+void SDKMeshWriter::CopyName(char *dst, const char *src, size_t size)
+{
+	// at most size - 1 characters, the rest of the field is zeroed
+	memset(dst, 0, size);
+	if (src == NULL)
+		return;
+
+	size_t length = strlen(src);
+	memcpy(dst, src, length < size - 1 ? length : size - 1);
+	dst[size - 1] = '\0';
+}
+
+void SDKMeshWriter::InitMaterial(SDKMESH_MATERIAL& material, const char *name)
+{
+	memset(&material, 0, sizeof(SDKMESH_MATERIAL));
+	CopyName(material.Name, name, MAX_MATERIAL_NAME);
+
+	D3DXVECTOR4 white = { 1.0f, 1.0f, 1.0f, 1.0f };
+	D3DXVECTOR4 black = { 0.0f, 0.0f, 0.0f, 1.0f };
+	material.Diffuse = white;
+	material.Ambient = black;
+	material.Specular = black;
+	material.Emissive = black;
+}
+
+UINT SDKMeshWriter::AddVertexBuffer(const D3DVERTEXELEMENT9 *declaration, UINT stride, std::vector<BYTE>& data)
+{
+	VertexBuffer *vb = new VertexBuffer();
+	memset(&vb->Header, 0, sizeof(SDKMESH_VERTEX_BUFFER_HEADER));
+
+	// copy up to the end element, the unused elements are end elements too
+	UINT n = 0;
+	while (n < MAX_VERTEX_ELEMENTS - 1 && declaration[n].Stream != 0xFF)
+	{
+		vb->Header.Decl[n] = declaration[n];
+		n++;
+	}
+
+	for (; n < MAX_VERTEX_ELEMENTS; n++)
+	{
+		vb->Header.Decl[n].Stream = 0xFF;
+		vb->Header.Decl[n].Type = D3DDECLTYPE_UNUSED;
+	}
+
+	vb->Header.StrideBytes = stride;
+	vb->Header.SizeBytes = data.size();
+	vb->Header.NumVertices = stride > 0 ? data.size() / stride : 0;
+	vb->Data.swap(data);
+
+	m_vertexBuffers.push_back(vb);
+	return (UINT)m_vertexBuffers.size() - 1;
+}
+
+UINT SDKMeshWriter::AddIndexBuffer(const std::vector<UINT>& indices, bool index32)
+{
+	IndexBuffer *ib = new IndexBuffer();
+	memset(&ib->Header, 0, sizeof(SDKMESH_INDEX_BUFFER_HEADER));
+
+	// 0xFFFF is the strip cut value of 16 bit buffers
+	bool index16 = !index32;
+	for (size_t i = 0, n = indices.size(); i < n && index16; i++)
+		index16 = indices[i] < 0xFFFF;
+
+	ib->Header.NumIndices = indices.size();
+	ib->Header.IndexType = index16 ? IT_16BIT : IT_32BIT;
+
+	if (index16)
+	{
+		ib->Data.resize(indices.size() * 2);
+		unsigned short *dst = (unsigned short*)ib->Data.data();
+		for (size_t i = 0, n = indices.size(); i < n; i++)
+			dst[i] = (unsigned short)indices[i];
+	}
+	else
+	{
+		ib->Data.resize(indices.size() * 4);
+		if (!indices.empty())
+			memcpy(ib->Data.data(), indices.data(), ib->Data.size());
+	}
+
+	ib->Header.SizeBytes = ib->Data.size();
+
+	m_indexBuffers.push_back(ib);
+	return (UINT)m_indexBuffers.size() - 1;
+}
+
+UINT SDKMeshWriter::AddMaterial(const SDKMESH_MATERIAL& material)
+{
+	m_materials.push_back(material);
+	return (UINT)m_materials.size() - 1;
+}
+
+UINT SDKMeshWriter::AddMesh(const char *name, UINT vertexBuffer, UINT indexBuffer, const D3DXVECTOR3& center, const D3DXVECTOR3& extents)
+{
+	SDKMESH_MESH mesh;
+	memset(&mesh, 0, sizeof(SDKMESH_MESH));
+	CopyName(mesh.Name, name, MAX_MESH_NAME);
+
+	mesh.NumVertexBuffers = 1;
+	mesh.VertexBuffers[0] = vertexBuffer;
+	mesh.IndexBuffer = indexBuffer;
+	mesh.BoundingBoxCenter = center;
+	mesh.BoundingBoxExtents = extents;
+
+	m_meshes.push_back(mesh);
+	m_meshSubsets.push_back(std::vector<UINT>());
+	return (UINT)m_meshes.size() - 1;
+}
+
+UINT SDKMeshWriter::AddSubset(UINT mesh, const char *name, UINT material, UINT64 indexStart, UINT64 indexCount, UINT64 vertexStart, UINT64 vertexCount)
+{
+	SDKMESH_SUBSET subset;
+	memset(&subset, 0, sizeof(SDKMESH_SUBSET));
+	CopyName(subset.Name, name, MAX_SUBSET_NAME);
+
+	subset.MaterialID = material;
+	subset.PrimitiveType = PT_TRIANGLE_LIST;
+	subset.IndexStart = indexStart;
+	subset.IndexCount = indexCount;
+	subset.VertexStart = vertexStart;
+	subset.VertexCount = vertexCount;
+
+	m_subsets.push_back(subset);
+
+	UINT id = (UINT)m_subsets.size() - 1;
+	m_meshSubsets[mesh].push_back(id);
+	m_meshes[mesh].NumSubsets++;
+	return id;
+}
+
+bool SDKMeshWriter::Write(const char *path)
+{
+	FileSink file;
+	if (!file.Open(path, "wb"))
+		return false;
+
+	bool success = Write(&file);
+	return file.Close() && success;
+}
+
+bool SDKMeshWriter::Write(OutputSink *sink)
+{
+	UINT numMeshes = (UINT)m_meshes.size();
+	UINT numVBs = (UINT)m_vertexBuffers.size();
+	UINT numIBs = (UINT)m_indexBuffers.size();
+
+	SDKMESH_HEADER header;
+	memset(&header, 0, sizeof(SDKMESH_HEADER));
+	header.Version = SDKMESH_FILE_VERSION;
+	header.IsBigEndian = 0;
+	header.HeaderSize = sizeof(SDKMESH_HEADER);
+	header.NumVertexBuffers = numVBs;
+	header.NumIndexBuffers = numIBs;
+	header.NumMeshes = numMeshes;
+	header.NumTotalSubsets = (UINT)m_subsets.size();
+	header.NumFrames = numMeshes;
+	header.NumMaterials = (UINT)m_materials.size();
+
+	// non-buffer data
+	UINT64 offset = header.HeaderSize;
+	header.VertexStreamHeadersOffset = offset;
+	offset += numVBs * sizeof(SDKMESH_VERTEX_BUFFER_HEADER);
+	header.IndexStreamHeadersOffset = offset;
+	offset += numIBs * sizeof(SDKMESH_INDEX_BUFFER_HEADER);
+	header.MeshDataOffset = offset;
+	offset += numMeshes * sizeof(SDKMESH_MESH);
+	header.SubsetDataOffset = offset;
+	offset += m_subsets.size() * sizeof(SDKMESH_SUBSET);
+	header.FrameDataOffset = offset;
+	offset += numMeshes * sizeof(SDKMESH_FRAME);
+	header.MaterialDataOffset = offset;
+	offset += m_materials.size() * sizeof(SDKMESH_MATERIAL);
+
+	std::vector<SDKMESH_MESH> meshes = m_meshes;
+	for (UINT i = 0; i < numMeshes; i++)
+	{
+		// no frame influences: the offset is not read
+		meshes[i].SubsetOffset = offset;
+		meshes[i].FrameInfluenceOffset = offset;
+		offset += m_meshSubsets[i].size() * sizeof(UINT);
+	}
+
+	header.NonBufferDataSize = offset - header.HeaderSize;
+
+	// buffer data
+	UINT64 bufferStart = AlignOffset(offset);
+	UINT64 dataOffset = bufferStart;
+
+	std::vector<SDKMESH_VERTEX_BUFFER_HEADER> vbs(numVBs);
+	for (UINT i = 0; i < numVBs; i++)
+	{
+		vbs[i] = m_vertexBuffers[i]->Header;
+		vbs[i].DataOffset = dataOffset;
+		dataOffset = AlignOffset(dataOffset + vbs[i].SizeBytes);
+	}
+
+	std::vector<SDKMESH_INDEX_BUFFER_HEADER> ibs(numIBs);
+	for (UINT i = 0; i < numIBs; i++)
+	{
+		ibs[i] = m_indexBuffers[i]->Header;
+		ibs[i].DataOffset = dataOffset;
+		dataOffset = AlignOffset(dataOffset + ibs[i].SizeBytes);
+	}
+
+	// the loader reads the buffers from the end of the non-buffer data
+	header.BufferDataSize = dataOffset - header.HeaderSize - header.NonBufferDataSize;
+
+	std::vector<SDKMESH_FRAME> frames(numMeshes);
+	for (UINT i = 0; i < numMeshes; i++)
+	{
+		SDKMESH_FRAME& frame = frames[i];
+		memset(&frame, 0, sizeof(SDKMESH_FRAME));
+		CopyName(frame.Name, m_meshes[i].Name, MAX_FRAME_NAME);
+
+		frame.Mesh = i;
+		frame.ParentFrame = INVALID_FRAME;
+		frame.ChildFrame = INVALID_FRAME;
+		frame.SiblingFrame = i + 1 < numMeshes ? i + 1 : INVALID_FRAME;
+		frame.AnimationDataIndex = INVALID_ANIMATION_DATA;
+
+		for (int j = 0; j < 4; j++)
+			frame.Matrix.m[j][j] = 1.0f;
+	}
+
+	ChunkWriter out(sink);
+
+	out.Write(&header, sizeof(SDKMESH_HEADER));
+	if (numVBs > 0)
+		out.Write(vbs.data(), numVBs * sizeof(SDKMESH_VERTEX_BUFFER_HEADER));
+	if (numIBs > 0)
+		out.Write(ibs.data(), numIBs * sizeof(SDKMESH_INDEX_BUFFER_HEADER));
+	if (numMeshes > 0)
+		out.Write(meshes.data(), numMeshes * sizeof(SDKMESH_MESH));
+	if (!m_subsets.empty())
+		out.Write(m_subsets.data(), m_subsets.size() * sizeof(SDKMESH_SUBSET));
+	if (numMeshes > 0)
+		out.Write(frames.data(), numMeshes * sizeof(SDKMESH_FRAME));
+	if (!m_materials.empty())
+		out.Write(m_materials.data(), m_materials.size() * sizeof(SDKMESH_MATERIAL));
+
+	for (UINT i = 0; i < numMeshes; i++)
+	{
+		if (!m_meshSubsets[i].empty())
+			out.Write(m_meshSubsets[i].data(), m_meshSubsets[i].size() * sizeof(UINT));
+	}
+
+	WritePadding(out, offset, bufferStart);
+
+	for (UINT i = 0; i < numVBs; i++)
+	{
+		const std::vector<BYTE>& data = m_vertexBuffers[i]->Data;
+		if (!data.empty())
+			out.Write(data.data(), data.size());
+		offset += data.size();
+		WritePadding(out, offset, AlignOffset(offset));
+	}
+
+	for (UINT i = 0; i < numIBs; i++)
+	{
+		const std::vector<BYTE>& data = m_indexBuffers[i]->Data;
+		if (!data.empty())
+			out.Write(data.data(), data.size());
+		offset += data.size();
+		WritePadding(out, offset, AlignOffset(offset));
+	}
+
+	out.Flush();
+
+	return !out.HasError();
+}
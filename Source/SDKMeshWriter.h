@@ -0,0 +1,81 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "OutputSink.h"
+
+#include <string>
+#include <vector>
+
+// buffer data offsets in the written file
+#define SDKMESHWRITER_ALIGNMENT 16
+
+// Builds a version 101 sdkmesh (the layout SDKMesh loads):
+//   header, vertex & index buffer headers, meshes, subsets, frames, materials,
+//   subset lists of the meshes, then the vertex & index buffer data.
+// Each mesh gets a root frame of the same name (identity matrix, no animation).
+class SDKMeshWriter
+{
+protected:
+	struct VertexBuffer
+	{
+		SDKMESH_VERTEX_BUFFER_HEADER Header;
+		std::vector<BYTE> Data;
+	};
+
+	struct IndexBuffer
+	{
+		SDKMESH_INDEX_BUFFER_HEADER Header;
+		std::vector<BYTE> Data;
+	};
+
+	std::vector<VertexBuffer*> m_vertexBuffers;
+	std::vector<IndexBuffer*> m_indexBuffers;
+
+	std::vector<SDKMESH_MESH> m_meshes;
+	std::vector<std::vector<UINT> > m_meshSubsets;
+	std::vector<SDKMESH_SUBSET> m_subsets;
+	std::vector<SDKMESH_MATERIAL> m_materials;
+
+public:
+	SDKMeshWriter();
+
+	virtual ~SDKMeshWriter();
+
+	// declaration ends with a Stream 0xFF element, the data is moved in (data is empty after)
+	UINT AddVertexBuffer(const D3DVERTEXELEMENT9 *declaration, UINT stride, std::vector<BYTE>& data);
+
+	// 16 bit indices when they all fit (and index32 is false), 32 bit otherwise
+	UINT AddIndexBuffer(const std::vector<UINT>& indices, bool index32 = false);
+
+	UINT AddMaterial(const SDKMESH_MATERIAL& material);
+
+	UINT AddMesh(const char *name, UINT vertexBuffer, UINT indexBuffer, const D3DXVECTOR3& center, const D3DXVECTOR3& extents);
+
+	// indices of the subset are absolute in the vertex buffer of the mesh
+	UINT AddSubset(UINT mesh, const char *name, UINT material, UINT64 indexStart, UINT64 indexCount, UINT64 vertexStart, UINT64 vertexCount);
+
+	UINT GetNumMeshes()
+	{
+		return (UINT)m_meshes.size();
+	}
+
+	UINT GetNumSubsets()
+	{
+		return (UINT)m_subsets.size();
+	}
+
+	UINT GetNumMaterials()
+	{
+		return (UINT)m_materials.size();
+	}
+
+	bool Write(const char *path);
+
+	bool Write(OutputSink *sink);
+
+	// default white material
+	static void InitMaterial(SDKMESH_MATERIAL& material, const char *name);
+
+	// truncated to the fixed size name fields
+	static void CopyName(char *dst, const char *src, size_t size);
+};
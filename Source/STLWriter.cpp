@@ -0,0 +1,281 @@
+#include "STLWriter.h"
+#include "ChunkWriter.h"
+#include "MemoryBudget.h"
+
+#include <math.h>
+
+// triangles decoded per chunk
+#define STL_CHUNK_TRIANGLES 1024
+
+STLWriter::STLWriter(SDKMesh *mesh, const char *output)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_stats(NULL),
+	m_budget(NULL),
+	m_transform(NULL),
+	m_sink(NULL)
+{
+	if (m_file.Open(output, "wb"))
+		m_sink = &m_file;
+}
+
+STLWriter::STLWriter(SDKMesh *mesh, OutputSink *sink)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_stats(NULL),
+	m_budget(NULL),
+	m_transform(NULL),
+	m_sink(sink)
+{
+}
+
+STLWriter::~STLWriter()
+{
+	m_file.Close();
+}
+
+bool STLWriter::CanWrite()
+{
+	if (m_sink == NULL)
+		return false;
+
+	return true;
+}
+
+void STLWriter::OrderTriangles(UINT *vertices, UINT count)
+{
+	if (m_transform == NULL)
+		return;
+
+	for (UINT j = 0; j < count; j++)
+		m_transform->OrderTriangle(vertices[j * 3 + 1], vertices[j * 3 + 2]);
+}
+
+void STLWriter::WriteTriangles(ChunkWriter& out, const float *positions, UINT count)
+{
+	for (UINT j = 0; j < count; j++)
+	{
+		const float *p = positions + j * 9;
+
+		float e1[3] = { p[3] - p[0], p[4] - p[1], p[5] - p[2] };
+		float e2[3] = { p[6] - p[0], p[7] - p[1], p[8] - p[2] };
+
+		float n[3] = {
+			e1[1] * e2[2] - e1[2] * e2[1],
+			e1[2] * e2[0] - e1[0] * e2[2],
+			e1[0] * e2[1] - e1[1] * e2[0]
+		};
+
+		float l = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (l > 0.0f)
+		{
+			n[0] /= l;
+			n[1] /= l;
+			n[2] /= l;
+		}
+
+		BYTE triangle[50];
+		memcpy(triangle, n, 12);
+		memcpy(triangle + 12, p, 36);
+		triangle[48] = 0;
+		triangle[49] = 0;
+
+		out.Write(triangle, sizeof(triangle));
+	}
+}
+
+bool STLWriter::Write()
+{
+	bool success = true;
+
+	// pass 1: count the triangles of the remaps (the processed level), the header comes first
+	UINT64 numTriangles = 0;
+
+	SubsetRemap remap;
+	RemapScratch scratch(remap);
+
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SubsetDecoder decoder(m_sdkMesh, meshIdx, m_processor);
+
+		UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			SDKMESH_SUBSET* subset = m_sdkMesh->GetSubset(meshIdx, i);
+			if (subset->PrimitiveType != PT_TRIANGLE_LIST)
+				continue;
+
+			// -budget: streamed from the index buffer, every triangle is written
+			if (m_budget != NULL && decoder.CanRemapWindows())
+			{
+				numTriangles += subset->IndexCount / 3;
+				continue;
+			}
+
+			bool remapped;
+			{
+				StatsScope scope(m_stats, SP_REMAP);
+				remapped = decoder.Remap(subset, remap);
+			}
+
+			// skipped by the second pass
+			if (!remapped)
+			{
+				success = false;
+				continue;
+			}
+
+			numTriangles += remap.Indices.size() / 3;
+		}
+	}
+
+	if (numTriangles > 0xFFFFFFFF)
+		return false;
+
+	ChunkWriter out(m_sink);
+	out.SetStats(m_stats);
+
+	char header[80];
+	memset(header, 0, sizeof(header));
+	strcpy(header, "exported by SDKMesh Expoter");
+	out.Write(header, sizeof(header));
+
+	DWORD count32 = (DWORD)numTriangles;
+	out.Write(&count32, 4);
+
+	UINT vertices[STL_CHUNK_TRIANGLES * 3];
+	float positions[STL_CHUNK_TRIANGLES * 9];
+
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SubsetDecoder decoder(m_sdkMesh, meshIdx, m_processor);
+		decoder.SetTransform(m_transform);
+		decoder.SetBudget(m_budget);
+
+		UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			SDKMESH_SUBSET* subset = m_sdkMesh->GetSubset(meshIdx, i);
+			if (subset->PrimitiveType != PT_TRIANGLE_LIST)
+				continue;
+
+			// -budget: no remap, the corners are read from the index buffer chunk by chunk
+			if (m_budget != NULL && decoder.CanRemapWindows())
+			{
+				if (!WriteSubsetStream(out, decoder, subset))
+					success = false;
+				continue;
+			}
+
+			bool remapped;
+			{
+				StatsScope scope(m_stats, SP_REMAP);
+				remapped = decoder.Remap(subset, remap);
+			}
+
+			// not counted in the header
+			if (!remapped)
+				continue;
+
+			if (m_budget != NULL)
+				m_budget->Consume(remap.Indices.size() * decoder.GetIndexSize());
+
+			if (m_stats != NULL)
+			{
+				m_stats->Add(SC_SUBSETS, 1);
+				m_stats->Add(SC_VERTICES, remap.Vertices.size());
+				m_stats->Add(SC_FACES, remap.Indices.size() / 3);
+				m_stats->Add(SC_REMAP_HITS, remap.Indices.size() - remap.Vertices.size());
+			}
+
+			UINT numSubsetTriangles = (UINT)(remap.Indices.size() / 3);
+
+			for (UINT begin = 0; begin < numSubsetTriangles; begin += STL_CHUNK_TRIANGLES)
+			{
+				UINT count = numSubsetTriangles - begin < STL_CHUNK_TRIANGLES ? numSubsetTriangles - begin : STL_CHUNK_TRIANGLES;
+
+				const UINT *indices = remap.Indices.data() + begin * 3;
+				for (UINT j = 0; j < count * 3; j++)
+					vertices[j] = remap.Vertices[indices[j]];
+
+				OrderTriangles(vertices, count);
+
+				bool decoded;
+				{
+					StatsScope scope(m_stats, SP_DECODE);
+					decoded = decoder.DecodePositions(vertices, count * 3, positions);
+				}
+
+				if (!decoded)
+				{
+					memset(positions, 0, sizeof(float) * 9 * count);
+					success = false;
+				}
+
+				WriteTriangles(out, positions, count);
+			}
+		}
+	}
+
+	out.Flush();
+
+	if (out.HasError())
+		success = false;
+
+	return success;
+}
+
+bool STLWriter::WriteSubsetStream(ChunkWriter& out, SubsetDecoder& decoder, SDKMESH_SUBSET *subset)
+{
+	bool success = true;
+
+	UINT vertices[STL_CHUNK_TRIANGLES * 3];
+	float positions[STL_CHUNK_TRIANGLES * 9];
+
+	UINT64 numTriangles = subset->IndexCount / 3;
+	UINT64 numVertices = decoder.GetNumVertices();
+
+	for (UINT64 begin = 0; begin < numTriangles; begin += STL_CHUNK_TRIANGLES)
+	{
+		UINT count = numTriangles - begin < STL_CHUNK_TRIANGLES ? (UINT)(numTriangles - begin) : STL_CHUNK_TRIANGLES;
+
+		UINT64 first = subset->IndexStart + begin * 3;
+		for (UINT j = 0; j < count * 3; j++)
+		{
+			UINT index = decoder.GetIndex(first + j);
+			if (index >= numVertices)
+			{
+				index = 0;
+				success = false;
+			}
+			vertices[j] = index;
+		}
+
+		OrderTriangles(vertices, count);
+
+		bool decoded;
+		{
+			StatsScope scope(m_stats, SP_DECODE);
+			decoded = decoder.DecodePositions(vertices, count * 3, positions);
+		}
+
+		if (!decoded)
+		{
+			memset(positions, 0, sizeof(float) * 9 * count);
+			success = false;
+		}
+
+		WriteTriangles(out, positions, count);
+
+		m_budget->Consume(count * 3 * decoder.GetIndexSize());
+	}
+
+	if (m_stats != NULL)
+	{
+		m_stats->Add(SC_SUBSETS, 1);
+		m_stats->Add(SC_FACES, numTriangles);
+	}
+
+	return success;
+}
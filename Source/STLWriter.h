@@ -0,0 +1,70 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "SubsetDecoder.h"
+#include "OutputSink.h"
+#include "VertexTransform.h"
+
+class ConvertStats;
+class ChunkWriter;
+class MemoryBudget;
+
+// Binary STL (triangles with face normal)
+class STLWriter
+{
+protected:
+	SDKMesh *m_sdkMesh;
+	MeshProcessor *m_processor;
+	ConvertStats *m_stats;
+	MemoryBudget *m_budget;
+
+	// coordinate conversion & winding (not owned), NULL: none
+	const VertexTransform *m_transform;
+
+	FileSink m_file;
+	OutputSink *m_sink;
+
+public:
+	STLWriter(SDKMesh *mesh, const char *output);
+
+	// write to a memory buffer, a callback or a descriptor, the sink is not owned
+	STLWriter(SDKMesh *mesh, OutputSink *sink);
+
+	virtual ~STLWriter();
+
+	bool CanWrite();
+
+	void SetProcessor(MeshProcessor *processor)
+	{
+		m_processor = processor;
+	}
+
+	// remap, decode & flush times and the written counters, NULL: off
+	void SetStats(ConvertStats *stats)
+	{
+		m_stats = stats;
+	}
+
+	void SetTransform(const VertexTransform *transform)
+	{
+		m_transform = transform;
+	}
+
+	// subsets are streamed chunk by chunk, the consumed input is reported
+	void SetBudget(MemoryBudget *budget)
+	{
+		m_budget = budget;
+	}
+
+	// write all TRIANGLE_LIST subsets of all meshes
+	bool Write();
+
+protected:
+	// 9 floats per triangle
+	void WriteTriangles(ChunkWriter& out, const float *positions, UINT count);
+
+	bool WriteSubsetStream(ChunkWriter& out, SubsetDecoder& decoder, SDKMESH_SUBSET *subset);
+
+	// corners of 'count' triangles in the written winding
+	void OrderTriangles(UINT *vertices, UINT count);
+};
@@ -0,0 +1,323 @@
+#include "SequenceWriter.h"
+#include "OBJWriter.h"
+#include "Skinning.h"
+#include "MatrixMath.h"
+#include "ParallelFor.h"
+#include "CStringImp.h"
+#include "Log.h"
+
+using namespace Skylicht;
+
+SequenceWriter::SequenceWriter(SDKMesh *mesh)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_attributes(VA_ALL),
+	m_transform(NULL)
+{
+}
+
+SequenceWriter::~SequenceWriter()
+{
+}
+
+bool SequenceWriter::Prepare()
+{
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+	m_meshes.clear();
+	m_meshes.resize(numMeshes);
+
+	bool success = true;
+
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SubsetDecoder decoder(m_sdkMesh, meshIdx, m_processor, m_attributes);
+
+		// rest pose, the samples are skinned from it
+		decoder.SetBones(NULL, 0);
+
+		SequenceMesh& mesh = m_meshes[meshIdx];
+		mesh.Skinned = decoder.HasSkin() && m_sdkMesh->GetNumInfluences(meshIdx) > 0;
+
+		// the rest pose of a skinned mesh stays in the source space
+		decoder.SetTransform(mesh.Skinned ? NULL : m_transform);
+
+		UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+		mesh.Subsets.resize(numSubsets);
+
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			SDKMESH_SUBSET *subset = m_sdkMesh->GetSubset(meshIdx, i);
+			SequenceSubset& s = mesh.Subsets[i];
+
+			s.MaterialID = subset->MaterialID;
+			s.Valid = subset->PrimitiveType == PT_TRIANGLE_LIST;
+			if (!s.Valid)
+				continue;
+
+			if (!decoder.Remap(subset, s.Remap))
+				success = false;
+
+			const UINT *vertices = s.Remap.Vertices.data();
+			UINT numVertices = (UINT)s.Remap.Vertices.size();
+
+			s.Positions.resize(numVertices * 3);
+			if (!decoder.DecodePositions(vertices, numVertices, s.Positions.data()))
+			{
+				s.Valid = false;
+				success = false;
+				continue;
+			}
+
+			if (decoder.HasNormal())
+			{
+				s.Normals.resize(numVertices * 3);
+				decoder.DecodeNormals(vertices, numVertices, s.Normals.data());
+			}
+
+			if (decoder.HasTexcoord())
+			{
+				s.Texcoords.resize(numVertices * 2);
+				decoder.DecodeTexcoords(vertices, numVertices, s.Texcoords.data());
+			}
+
+			if (mesh.Skinned)
+			{
+				s.Weights.resize(numVertices * 4);
+				s.BlendIndices.resize(numVertices * 4);
+				decoder.DecodeBlendWeights(vertices, numVertices, s.Weights.data());
+				decoder.DecodeBlendIndices(vertices, numVertices, s.BlendIndices.data());
+			}
+		}
+	}
+
+	return success;
+}
+
+UINT SequenceWriter::SamplePoses(double start, double end)
+{
+	m_poses.clear();
+	m_times.clear();
+
+	SDKANIMATION_FILE_HEADER *header = m_sdkMesh->GetAnimationHeader();
+	if (header == NULL || header->AnimationFPS == 0 || header->NumAnimationKeys < 2)
+		return 0;
+
+	double fps = (double)header->AnimationFPS;
+	if (end < 0.0)
+		end = (header->NumAnimationKeys - 1) / fps;
+
+	if (start < 0.0)
+		start = 0.0;
+
+	// sample in the middle of each key so rounding never skips or repeats a key
+	for (UINT k = 0; start + k / fps < end; k++)
+		m_times.push_back(start + (k + 0.5) / fps);
+
+	// the frame transforms live in the mesh: pose the samples one by one
+	D3DXMATRIX identity;
+	MatrixIdentity(&identity);
+
+	m_sdkMesh->TransformBindPose(&identity);
+
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+	m_poses.resize(m_times.size());
+
+	for (size_t sample = 0; sample < m_times.size(); sample++)
+	{
+		m_sdkMesh->TransformMesh(&identity, m_times[sample]);
+
+		m_poses[sample].resize(numMeshes);
+		for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+			Skinning::GetBones(m_sdkMesh, meshIdx, m_poses[sample][meshIdx]);
+	}
+
+	return (UINT)m_times.size();
+}
+
+int SequenceWriter::Write(const char *output, int numThreads)
+{
+	char material[MAX_PATH];
+	char materialName[MAX_PATH];
+	strcpy(material, output);
+	CStringImp::replacePathExt(material, ".mtl");
+	strcpy(materialName, output);
+	CStringImp::replaceExt(materialName, ".mtl");
+
+	// shared material file, next to the frames
+	remove(material);
+	FILE *mat = fopen(material, "wt");
+	if (mat == NULL)
+	{
+		LogError() << "Can not write: " << material << "\n";
+		return -1;
+	}
+
+	fprintf(mat, "# exported by SDKMesh Expoter\n");
+	for (UINT i = 0, n = m_sdkMesh->GetNumMaterials(); i < n; ++i)
+		OBJWriter::WriteMaterial(mat, m_sdkMesh->GetMaterial(i));
+	fclose(mat);
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	// skinned streams of the thread, reused between its frames
+	std::vector<std::vector<float> > positions(numThreads);
+	std::vector<std::vector<float> > normals(numThreads);
+
+	std::atomic<int> errorCount(0);
+
+	ParallelFor(m_times.size(), numThreads, [&](size_t sample, int thread)
+	{
+		char path[MAX_PATH];
+		GetFramePath(output, (UINT)sample, path);
+
+		if (!WriteFrame(path, materialName, (UINT)sample, positions[thread], normals[thread]))
+			errorCount++;
+	});
+
+	return errorCount;
+}
+
+void SequenceWriter::GetFramePath(const char *output, UINT sample, char *path)
+{
+	char frameExt[64];
+	strcpy(path, output);
+	sprintf(frameExt, "_%04d.obj", (int)sample);
+	CStringImp::replacePathExt(path, frameExt);
+}
+
+bool SequenceWriter::WriteFrame(const char *path, const char *material, UINT sample,
+	std::vector<float>& positions, std::vector<float>& normals)
+{
+	remove(path);
+	FILE *file = fopen(path, "wt");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "# exported by SDKMesh Expoter\n");
+	fprintf(file, "# time %f\n", m_times[sample]);
+	fprintf(file, "mtllib %s\n", material);
+
+	int group = 0;
+	int numVertex = 1;
+	int numTexcoord = 1;
+	int numNormal = 1;
+
+	for (size_t meshIdx = 0; meshIdx < m_meshes.size(); ++meshIdx)
+	{
+		const SequenceMesh& mesh = m_meshes[meshIdx];
+		const std::vector<D3DXMATRIX>& bones = m_poses[sample][meshIdx];
+
+		fprintf(file, "o %s\n", m_sdkMesh->GetMesh((UINT)meshIdx)->Name);
+
+		for (size_t i = 0; i < mesh.Subsets.size(); ++i)
+		{
+			const SequenceSubset& s = mesh.Subsets[i];
+			if (!s.Valid)
+				continue;
+
+			UINT numVertices = (UINT)s.Remap.Vertices.size();
+			const float *p = s.Positions.data();
+			const float *n = s.Normals.empty() ? NULL : s.Normals.data();
+
+			if (mesh.Skinned && !bones.empty())
+			{
+				positions.resize(numVertices * 3);
+				Skinning::SkinPositions(p, s.Weights.data(), s.BlendIndices.data(), numVertices,
+					bones.data(), (UINT)bones.size(), positions.data());
+				p = positions.data();
+
+				if (n)
+				{
+					normals.resize(numVertices * 3);
+					Skinning::SkinNormals(n, s.Weights.data(), s.BlendIndices.data(), numVertices,
+						bones.data(), (UINT)bones.size(), normals.data());
+					n = normals.data();
+				}
+			}
+
+			// in the skinned streams of the thread, while they are in cache
+			if (mesh.Skinned && m_transform != NULL)
+			{
+				if (p != positions.data())
+				{
+					positions.assign(p, p + numVertices * 3);
+					p = positions.data();
+				}
+				m_transform->TransformPositions(positions.data(), numVertices);
+
+				if (n)
+				{
+					if (n != normals.data())
+					{
+						normals.assign(n, n + numVertices * 3);
+						n = normals.data();
+					}
+					m_transform->TransformNormals(normals.data(), numVertices);
+				}
+			}
+
+			if (mesh.Subsets.size() > 1)
+				fprintf(file, "g grp %d \n", group++);
+
+			for (UINT v = 0; v < numVertices; v++)
+				fprintf(file, "v %f %f %f\n", p[v * 3], p[v * 3 + 1], p[v * 3 + 2]);
+
+			if (n)
+			{
+				for (UINT v = 0; v < numVertices; v++)
+					fprintf(file, "vn %f %f %f\n", n[v * 3], n[v * 3 + 1], n[v * 3 + 2]);
+			}
+
+			for (UINT v = 0, m = (UINT)s.Texcoords.size() / 2; v < m; v++)
+				fprintf(file, "vt %f %f\n", s.Texcoords[v * 2], s.Texcoords[v * 2 + 1]);
+
+			fprintf(file, "usemtl %s\n", m_sdkMesh->GetMaterial(s.MaterialID)->Name);
+			fprintf(file, "s off\n");
+
+			const std::vector<UINT>& indices = s.Remap.Indices;
+			bool texcoord = !s.Texcoords.empty();
+			for (size_t t = 0, m = indices.size(); t < m; t += 3)
+			{
+				int m0 = indices[t] + numVertex;
+				int m1 = indices[t + 1] + numVertex;
+				int m2 = indices[t + 2] + numVertex;
+
+				if (m_transform != NULL)
+					m_transform->OrderTriangle(m1, m2);
+
+				if (m_attributes == VA_ALL)
+				{
+					fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
+						m0, m0, m0,
+						m1, m1, m1,
+						m2, m2, m2);
+					continue;
+				}
+
+				// -attributes: the written streams only, numbered apart
+				int vt = numTexcoord - numVertex;
+				int vn = numNormal - numVertex;
+				if (texcoord && n)
+					fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", m0, m0 + vt, m0 + vn, m1, m1 + vt, m1 + vn, m2, m2 + vt, m2 + vn);
+				else if (texcoord)
+					fprintf(file, "f %d/%d %d/%d %d/%d\n", m0, m0 + vt, m1, m1 + vt, m2, m2 + vt);
+				else if (n)
+					fprintf(file, "f %d//%d %d//%d %d//%d\n", m0, m0 + vn, m1, m1 + vn, m2, m2 + vn);
+				else
+					fprintf(file, "f %d %d %d\n", m0, m1, m2);
+			}
+
+			numVertex += numVertices;
+			if (texcoord)
+				numTexcoord += numVertices;
+			if (n)
+				numNormal += numVertices;
+		}
+	}
+
+	bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+}
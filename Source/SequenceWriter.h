@@ -0,0 +1,90 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "SubsetDecoder.h"
+#include "VertexTransform.h"
+
+// Write one skinned OBJ per animation sample: OUTPUT_0000.obj, OUTPUT_0001.obj... sharing OUTPUT.mtl
+// The rest pose streams are decoded once and shared read-only by the frame threads.
+class SequenceWriter
+{
+protected:
+	struct SequenceSubset
+	{
+		UINT MaterialID;
+		bool Valid;
+
+		SubsetRemap Remap;
+
+		// rest pose streams of the remapped vertices
+		std::vector<float> Positions;
+		std::vector<float> Normals;
+		std::vector<float> Texcoords;
+		std::vector<float> Weights;
+		std::vector<UINT> BlendIndices;
+	};
+
+	struct SequenceMesh
+	{
+		bool Skinned;
+		std::vector<SequenceSubset> Subsets;
+	};
+
+	SDKMesh *m_sdkMesh;
+	MeshProcessor *m_processor;
+
+	// VERTEX_ATTRIBUTE flags decoded by Prepare
+	UINT m_attributes;
+
+	// coordinate conversion & winding (not owned), NULL: none
+	const VertexTransform *m_transform;
+
+	std::vector<SequenceMesh> m_meshes;
+
+	// bone matrices of each sample, per mesh
+	std::vector<std::vector<std::vector<D3DXMATRIX> > > m_poses;
+	std::vector<double> m_times;
+
+public:
+	SequenceWriter(SDKMesh *mesh);
+
+	virtual ~SequenceWriter();
+
+	// the processed remaps are used when set
+	void SetProcessor(MeshProcessor *processor)
+	{
+		m_processor = processor;
+	}
+
+	// -attributes: the faces then list only the written streams
+	void SetAttributes(UINT attributes)
+	{
+		m_attributes = attributes;
+	}
+
+	// the skinned meshes are converted after their skinning in each frame
+	void SetTransform(const VertexTransform *transform)
+	{
+		m_transform = transform;
+	}
+
+	// decode the rest pose streams of all subsets
+	bool Prepare();
+
+	// one sample per animation key in [start, end) seconds, end < 0: to the end of the animation
+	UINT SamplePoses(double start, double end);
+
+	// write the samples on numThreads threads, returns the number of failed frames
+	int Write(const char *output, int numThreads);
+
+	UINT GetNumSamples()
+	{
+		return (UINT)m_times.size();
+	}
+
+	// OUTPUT_0000.obj...
+	static void GetFramePath(const char *output, UINT sample, char *path);
+
+protected:
+	bool WriteFrame(const char *path, const char *material, UINT sample, std::vector<float>& positions, std::vector<float>& normals);
+};
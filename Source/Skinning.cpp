@@ -0,0 +1,187 @@
+#include "Skinning.h"
+#include "MatrixMath.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SKINNING_SSE
+#include <xmmintrin.h>
+#endif
+
+#ifdef SKINNING_SSE
+
+// the 4 rows of the weighted sum of the vertex bones, false if no influence is valid
+static inline bool BlendBones(const float *w, const UINT *idx, const D3DXMATRIX *bones, UINT numBones, __m128 *r)
+{
+	r[0] = r[1] = r[2] = r[3] = _mm_setzero_ps();
+	bool valid = false;
+
+	for (int k = 0; k < 4; k++)
+	{
+		if (w[k] == 0.0f || idx[k] >= numBones)
+			continue;
+
+		const float *m = &bones[idx[k]].m[0][0];
+		__m128 wk = _mm_set1_ps(w[k]);
+
+		r[0] = _mm_add_ps(r[0], _mm_mul_ps(wk, _mm_loadu_ps(m)));
+		r[1] = _mm_add_ps(r[1], _mm_mul_ps(wk, _mm_loadu_ps(m + 4)));
+		r[2] = _mm_add_ps(r[2], _mm_mul_ps(wk, _mm_loadu_ps(m + 8)));
+		r[3] = _mm_add_ps(r[3], _mm_mul_ps(wk, _mm_loadu_ps(m + 12)));
+		valid = true;
+	}
+
+	return valid;
+}
+
+void Skinning::SkinPositions(const float *positions, const float *weights, const UINT *indices, UINT count,
+	const D3DXMATRIX *bones, UINT numBones, float *out)
+{
+	__m128 r[4];
+	float p[4];
+
+	for (UINT i = 0; i < count; i++)
+	{
+		const float *v = positions + i * 3;
+
+		if (!BlendBones(weights + i * 4, indices + i * 4, bones, numBones, r))
+		{
+			memmove(out + i * 3, v, sizeof(float) * 3);
+			continue;
+		}
+
+		// row vector: x * r0 + y * r1 + z * r2 + r3
+		__m128 s = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), r[0]), _mm_mul_ps(_mm_set1_ps(v[1]), r[1])),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[2]), r[2]), r[3]));
+
+		_mm_storeu_ps(p, s);
+		memcpy(out + i * 3, p, sizeof(float) * 3);
+	}
+}
+
+void Skinning::SkinNormals(const float *normals, const float *weights, const UINT *indices, UINT count,
+	const D3DXMATRIX *bones, UINT numBones, float *out)
+{
+	__m128 r[4];
+	float n[4];
+
+	for (UINT i = 0; i < count; i++)
+	{
+		const float *v = normals + i * 3;
+
+		if (!BlendBones(weights + i * 4, indices + i * 4, bones, numBones, r))
+		{
+			memmove(out + i * 3, v, sizeof(float) * 3);
+			continue;
+		}
+
+		__m128 s = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), r[0]), _mm_mul_ps(_mm_set1_ps(v[1]), r[1])),
+			_mm_mul_ps(_mm_set1_ps(v[2]), r[2]));
+
+		_mm_storeu_ps(n, s);
+
+		float l = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (l > 0.0f)
+		{
+			n[0] /= l;
+			n[1] /= l;
+			n[2] /= l;
+		}
+
+		memcpy(out + i * 3, n, sizeof(float) * 3);
+	}
+}
+
+#else
+
+static inline bool BlendBones(const float *w, const UINT *idx, const D3DXMATRIX *bones, UINT numBones, float *r)
+{
+	for (int j = 0; j < 16; j++)
+		r[j] = 0.0f;
+
+	bool valid = false;
+
+	for (int k = 0; k < 4; k++)
+	{
+		if (w[k] == 0.0f || idx[k] >= numBones)
+			continue;
+
+		const float *m = &bones[idx[k]].m[0][0];
+		for (int j = 0; j < 16; j++)
+			r[j] += w[k] * m[j];
+		valid = true;
+	}
+
+	return valid;
+}
+
+void Skinning::SkinPositions(const float *positions, const float *weights, const UINT *indices, UINT count,
+	const D3DXMATRIX *bones, UINT numBones, float *out)
+{
+	float r[16];
+
+	for (UINT i = 0; i < count; i++)
+	{
+		float v[3] = { positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2] };
+
+		if (!BlendBones(weights + i * 4, indices + i * 4, bones, numBones, r))
+		{
+			memmove(out + i * 3, v, sizeof(float) * 3);
+			continue;
+		}
+
+		for (int j = 0; j < 3; j++)
+			out[i * 3 + j] = v[0] * r[j] + v[1] * r[4 + j] + v[2] * r[8 + j] + r[12 + j];
+	}
+}
+
+void Skinning::SkinNormals(const float *normals, const float *weights, const UINT *indices, UINT count,
+	const D3DXMATRIX *bones, UINT numBones, float *out)
+{
+	float r[16];
+
+	for (UINT i = 0; i < count; i++)
+	{
+		float v[3] = { normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2] };
+
+		if (!BlendBones(weights + i * 4, indices + i * 4, bones, numBones, r))
+		{
+			memmove(out + i * 3, v, sizeof(float) * 3);
+			continue;
+		}
+
+		float n[3];
+		for (int j = 0; j < 3; j++)
+			n[j] = v[0] * r[j] + v[1] * r[4 + j] + v[2] * r[8 + j];
+
+		float l = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (l > 0.0f)
+		{
+			n[0] /= l;
+			n[1] /= l;
+			n[2] /= l;
+		}
+
+		memcpy(out + i * 3, n, sizeof(float) * 3);
+	}
+}
+
+#endif
+
+void Skinning::GetBones(SDKMesh *mesh, UINT meshID, std::vector<D3DXMATRIX>& bones)
+{
+	UINT numInfluences = mesh->GetNumInfluences(meshID);
+
+	bones.resize(numInfluences);
+	for (UINT i = 0; i < numInfluences; i++)
+	{
+		const D3DXMATRIX *m = mesh->GetMeshInfluenceMatrix(meshID, i);
+		if (m)
+			bones[i] = *m;
+		else
+			MatrixIdentity(&bones[i]);
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+// Linear blend skinning of decoded streams.
+// The streams are contiguous: positions/normals 3 floats, weights 4 floats and indices 4 UINTs per vertex.
+// 'bones' is indexed by the blend indices (the frame influences of the mesh), indices out of range are skipped.
+class Skinning
+{
+public:
+	// out can be positions (in place), vertices without a valid influence keep their position
+	static void SkinPositions(const float *positions, const float *weights, const UINT *indices, UINT count,
+		const D3DXMATRIX *bones, UINT numBones, float *out);
+
+	// rotate by the blended 3x3 and renormalize, out can be normals
+	static void SkinNormals(const float *normals, const float *weights, const UINT *indices, UINT count,
+		const D3DXMATRIX *bones, UINT numBones, float *out);
+
+	// bone matrices of each frame influence of a mesh, from the last SDKMesh::TransformMesh
+	static void GetBones(SDKMesh *mesh, UINT meshID, std::vector<D3DXMATRIX>& bones);
+};
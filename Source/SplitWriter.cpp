@@ -0,0 +1,332 @@
+#include "SplitWriter.h"
+#include "OBJWriter.h"
+#include "OutputSink.h"
+#include "JSONWriter.h"
+#include "ParallelFor.h"
+#include "Arena.h"
+#include "CStringImp.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <set>
+
+using namespace Skylicht;
+
+// a fixed size name field as a file name part: letters, digits, '-', '_' and '.', the rest as '_'
+static std::string GetFileNamePart(const char *name, size_t size)
+{
+	std::string part;
+	for (size_t i = 0; i < size && name[i] != 0; i++)
+	{
+		char c = name[i];
+		bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+			c == '-' || c == '_' || c == '.';
+		part += valid ? c : '_';
+	}
+	return part.empty() ? "part" : part;
+}
+
+SplitWriter::SplitWriter(SDKMesh *mesh, SPLIT_MODE mode)
+	:m_sdkMesh(mesh),
+	m_processor(NULL),
+	m_mode(mode),
+	m_attributes(VA_ALL),
+	m_transform(NULL)
+{
+}
+
+SplitWriter::~SplitWriter()
+{
+}
+
+bool SplitWriter::ParseMode(const char *name, SPLIT_MODE *mode)
+{
+	if (strcmp(name, "mesh") == 0)
+		*mode = SPLIT_MESH;
+	else if (strcmp(name, "subset") == 0)
+		*mode = SPLIT_SUBSET;
+	else if (strcmp(name, "material") == 0)
+		*mode = SPLIT_MATERIAL;
+	else
+		return false;
+	return true;
+}
+
+const char* SplitWriter::GetModeName(SPLIT_MODE mode)
+{
+	switch (mode)
+	{
+	case SPLIT_MESH:
+		return "mesh";
+	case SPLIT_SUBSET:
+		return "subset";
+	case SPLIT_MATERIAL:
+		return "material";
+	default:
+		break;
+	}
+	return "";
+}
+
+void SplitWriter::Plan(const char *output)
+{
+	m_parts.clear();
+
+	UINT numMeshes = m_sdkMesh->GetNumMeshes();
+	UINT numMaterials = m_sdkMesh->GetNumMaterials();
+
+	// a part per material, the subsets without a valid material in the last one
+	if (m_mode == SPLIT_MATERIAL)
+	{
+		m_parts.resize(numMaterials + 1);
+		for (UINT i = 0; i < numMaterials; ++i)
+			m_parts[i].Name = GetFileNamePart(m_sdkMesh->GetMaterial(i)->Name, MAX_MATERIAL_NAME);
+		m_parts[numMaterials].Name = "default";
+	}
+
+	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	{
+		SDKMESH_MESH *mesh = m_sdkMesh->GetMesh(meshIdx);
+		UINT numSubsets = m_sdkMesh->GetNumSubsets(meshIdx);
+
+		if (m_mode == SPLIT_MESH && numSubsets > 0)
+		{
+			m_parts.push_back(SplitPart());
+			m_parts.back().Name = GetFileNamePart(mesh->Name, MAX_MESH_NAME);
+		}
+
+		for (UINT i = 0; i < numSubsets; ++i)
+		{
+			SDKMESH_SUBSET *subset = m_sdkMesh->GetSubset(meshIdx, i);
+
+			SplitPart *part;
+			if (m_mode == SPLIT_MATERIAL)
+			{
+				part = &m_parts[subset->MaterialID < numMaterials ? subset->MaterialID : numMaterials];
+			}
+			else if (m_mode == SPLIT_SUBSET)
+			{
+				m_parts.push_back(SplitPart());
+				part = &m_parts.back();
+				part->Name = GetFileNamePart(mesh->Name, MAX_MESH_NAME) + "_" + GetFileNamePart(subset->Name, MAX_SUBSET_NAME);
+			}
+			else
+			{
+				part = &m_parts.back();
+			}
+
+			part->Subsets.push_back(meshIdx);
+			part->Subsets.push_back(i);
+		}
+	}
+
+	// unused materials have no file
+	size_t numParts = 0;
+	for (size_t i = 0; i < m_parts.size(); i++)
+	{
+		if (!m_parts[i].Subsets.empty())
+			std::swap(m_parts[numParts++], m_parts[i]);
+	}
+	m_parts.resize(numParts);
+
+	// OUTPUT_NAME.obj, a repeated name gets the part number (or the next free one)
+	std::set<std::string> paths;
+
+	for (size_t i = 0; i < m_parts.size(); i++)
+	{
+		SplitPart& part = m_parts[i];
+		part.Success = false;
+		part.Triangles = 0;
+
+		for (size_t j = 0; j < part.Subsets.size(); j += 2)
+			part.Triangles += m_sdkMesh->GetSubset(part.Subsets[j], part.Subsets[j + 1])->IndexCount / 3;
+
+		char path[MAX_PATH];
+		std::string ext = "_" + part.Name + ".obj";
+		strcpy(path, output);
+		CStringImp::replacePathExt(path, ext.c_str());
+
+		// the file systems of the engine may ignore the case
+		std::string key = path;
+		CStringImp::toLower(&key[0]);
+
+		// a part may be named like the numbered name of another one: "A", "A", "A_1"
+		for (int number = (int)i; paths.find(key) != paths.end(); number++)
+		{
+			ext = "_" + part.Name + "_" + std::to_string(number) + ".obj";
+			strcpy(path, output);
+			CStringImp::replacePathExt(path, ext.c_str());
+
+			key = path;
+			CStringImp::toLower(&key[0]);
+		}
+
+		part.Path = path;
+		paths.insert(key);
+	}
+}
+
+int SplitWriter::Write(const char *input, const char *output, int numThreads, ConvertStats *stats, std::vector<std::string>& files)
+{
+	char material[MAX_PATH];
+	char materialName[MAX_PATH];
+	strcpy(material, output);
+	CStringImp::replacePathExt(material, ".mtl");
+	strcpy(materialName, output);
+	CStringImp::replaceExt(materialName, ".mtl");
+
+	// shared material file, next to the parts
+	remove(material);
+	FILE *mat = fopen(material, "wt");
+	if (mat == NULL)
+	{
+		LogError() << "Can not write: " << material << "\n";
+		return -1;
+	}
+
+	fprintf(mat, "# exported by SDKMesh Expoter\n");
+	for (UINT i = 0, n = m_sdkMesh->GetNumMaterials(); i < n; ++i)
+		OBJWriter::WriteMaterial(mat, m_sdkMesh->GetMaterial(i));
+	fclose(mat);
+
+	files.push_back(material);
+
+	if (numThreads < 1)
+		numThreads = GetDefaultNumThreads();
+
+	// the stats are not shared between threads: one per part
+	m_stats.clear();
+	m_stats.resize(stats != NULL ? m_parts.size() : 0);
+
+	std::atomic<int> errorCount(0);
+
+	ParallelFor(m_parts.size(), numThreads, [&](size_t i, int)
+	{
+		// the chunks & decoders of a part come from the arena of its thread, reused by its next part
+		ArenaScope session(Arena::GetThreadArena());
+
+		if (!WritePart(m_parts[i], materialName, stats != NULL ? &m_stats[i] : NULL))
+			errorCount++;
+	});
+
+	for (size_t i = 0; i < m_stats.size(); i++)
+		stats->AddCounters(m_stats[i]);
+
+	for (size_t i = 0; i < m_parts.size(); i++)
+	{
+		const SplitPart& part = m_parts[i];
+		LogDebug() << " Part " << i << " " << part.Path << ": " << part.Subsets.size() / 2 << " subsets, "
+			<< part.Triangles << " triangles" << (part.Success ? "\n" : " - write error!\n");
+
+		files.push_back(part.Path);
+	}
+
+	char path[MAX_PATH];
+	strcpy(path, output);
+	CStringImp::replacePathExt(path, ".parts.json");
+
+	if (!WriteIndex(path, input, materialName))
+	{
+		LogError() << "Can not write: " << path << "\n";
+		return -1;
+	}
+
+	files.push_back(path);
+
+	LogInfo() << "Split: " << m_parts.size() << " files (" << GetModeName(m_mode) << ") on " << numThreads << " threads, index " << path << "\n";
+
+	return errorCount;
+}
+
+bool SplitWriter::WritePart(SplitPart& part, const char *materialName, ConvertStats *stats)
+{
+	FileSink file;
+	if (!file.Open(part.Path.c_str(), "wt"))
+	{
+		part.Success = false;
+		return false;
+	}
+
+	bool success = true;
+	{
+		OBJWriter writer(m_sdkMesh, &file, NULL, materialName);
+		writer.SetProcessor(m_processor);
+		writer.SetAttributes(m_attributes);
+		writer.SetTransform(m_transform);
+		writer.SetStats(stats);
+
+		const std::vector<UINT>& subsets = part.Subsets;
+		for (size_t i = 0; i < subsets.size(); )
+		{
+			UINT meshIdx = subsets[i];
+			SDKMESH_MESH *mesh = m_sdkMesh->GetMesh(meshIdx);
+
+			// the subsets of this mesh in the part, grouped as in the single OBJ
+			size_t end = i;
+			while (end < subsets.size() && subsets[end] == meshIdx)
+				end += 2;
+
+			bool writeGroup = end - i > 2;
+
+			writer.WriteObject(mesh->Name);
+
+			for (; i < end; i += 2)
+			{
+				SDKMESH_SUBSET *subset = m_sdkMesh->GetSubset(meshIdx, subsets[i + 1]);
+				if (subset->PrimitiveType != PT_TRIANGLE_LIST)
+				{
+					success = false;
+					continue;
+				}
+
+				if (!writer.WriteSubset(meshIdx, subset, writeGroup))
+					success = false;
+			}
+		}
+
+		success = writer.Finish() && success;
+	}
+
+	success = file.Close() && success;
+
+	part.Success = success;
+	return success;
+}
+
+bool SplitWriter::WriteIndex(const char *path, const char *input, const char *materialName)
+{
+	remove(path);
+	FILE *file = fopen(path, "wt");
+	if (file == NULL)
+		return false;
+
+	JSONWriter json(file);
+	json.BeginObject();
+	json.Write("input", input);
+	json.Write("split", GetModeName(m_mode));
+	json.Write("material", materialName);
+
+	json.BeginArray("parts");
+	for (size_t i = 0; i < m_parts.size(); i++)
+	{
+		const SplitPart& part = m_parts[i];
+
+		char fileName[MAX_PATH];
+		CStringImp::getFileName(fileName, part.Path.c_str());
+
+		json.BeginObject();
+		json.Write("name", part.Name.c_str());
+		json.Write("file", fileName);
+		json.Write("subsets", (unsigned int)(part.Subsets.size() / 2));
+		json.Write("triangles", (unsigned long long)part.Triangles);
+		json.Write("success", part.Success);
+		json.EndObject();
+	}
+	json.EndArray();
+
+	json.EndObject();
+	json.Finish();
+
+	bool success = ferror(file) == 0;
+	return fclose(file) == 0 && success;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "ConvertStats.h"
+
+#include <string>
+#include <vector>
+
+class MeshProcessor;
+class VertexTransform;
+
+enum SPLIT_MODE
+{
+	SPLIT_MESH = 0,
+	SPLIT_SUBSET,
+	SPLIT_MATERIAL
+};
+
+// one output file and the subsets it holds
+struct SplitPart
+{
+	std::string Name;
+	std::string Path;
+
+	// mesh & subset index pairs, in mesh order
+	std::vector<UINT> Subsets;
+
+	UINT64 Triangles;
+	bool Success;
+};
+
+// Write one OBJ per mesh, subset or material (-split): OUTPUT_NAME.obj, each with its own
+// 1-based indices, sharing OUTPUT.mtl and listed in OUTPUT.parts.json.
+// The parts are planned from the headers, then written independently on a thread pool.
+class SplitWriter
+{
+protected:
+	SDKMesh *m_sdkMesh;
+	MeshProcessor *m_processor;
+	SPLIT_MODE m_mode;
+	UINT m_attributes;
+	const VertexTransform *m_transform;
+
+	std::vector<SplitPart> m_parts;
+
+	// counters of the parts, merged after the parallel write
+	std::vector<ConvertStats> m_stats;
+
+public:
+	SplitWriter(SDKMesh *mesh, SPLIT_MODE mode);
+
+	virtual ~SplitWriter();
+
+	void SetProcessor(MeshProcessor *processor)
+	{
+		m_processor = processor;
+	}
+
+	// VERTEX_ATTRIBUTE flags of the parts (-attributes)
+	void SetAttributes(UINT attributes)
+	{
+		m_attributes = attributes;
+	}
+
+	// coordinate conversion & winding of the parts (not owned)
+	void SetTransform(const VertexTransform *transform)
+	{
+		m_transform = transform;
+	}
+
+	// the parts of the mode and their paths next to output
+	void Plan(const char *output);
+
+	// the MTL, the parts on numThreads threads and the index; returns the number of failed parts,
+	// -1 if the MTL or the index can not be written. The written paths are added to files.
+	int Write(const char *input, const char *output, int numThreads, ConvertStats *stats, std::vector<std::string>& files);
+
+	UINT GetNumParts()
+	{
+		return (UINT)m_parts.size();
+	}
+
+	const SplitPart& GetPart(UINT i)
+	{
+		return m_parts[i];
+	}
+
+	// mesh, subset or material, false if unknown
+	static bool ParseMode(const char *name, SPLIT_MODE *mode);
+
+	static const char* GetModeName(SPLIT_MODE mode);
+
+protected:
+	bool WritePart(SplitPart& part, const char *materialName, ConvertStats *stats);
+
+	bool WriteIndex(const char *path, const char *input, const char *materialName);
+};
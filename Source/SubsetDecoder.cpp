@@ -0,0 +1,793 @@
+#include "SubsetDecoder.h"
+#include "MeshProcessor.h"
+#include "MemoryBudget.h"
+#include "Skinning.h"
+#include "VertexTransform.h"
+#include "CStringImp.h"
+
+#define INVALID_REMAP ((UINT)-1)
+
+static float HalfToFloat(unsigned short h)
+{
+	unsigned int sign = (h & 0x8000) << 16;
+	unsigned int exponent = (h >> 10) & 0x1F;
+	unsigned int mantissa = h & 0x3FF;
+	unsigned int bits;
+
+	if (exponent == 0)
+	{
+		if (mantissa == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			// denormal
+			exponent = 127 - 15 + 1;
+			while ((mantissa & 0x400) == 0)
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			mantissa &= 0x3FF;
+			bits = sign | (exponent << 23) | (mantissa << 13);
+		}
+	}
+	else if (exponent == 31)
+	{
+		// inf, nan
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+
+	float f;
+	memcpy(&f, &bits, sizeof(float));
+	return f;
+}
+
+static void DecodeElement(BYTE type, const BYTE *data, float *f)
+{
+	f[0] = 0.0f;
+	f[1] = 0.0f;
+	f[2] = 0.0f;
+	f[3] = 1.0f;
+
+	switch (type)
+	{
+	case D3DDECLTYPE_FLOAT4:
+		memcpy(f, data, 16);
+		break;
+	case D3DDECLTYPE_FLOAT3:
+		memcpy(f, data, 12);
+		break;
+	case D3DDECLTYPE_FLOAT2:
+		memcpy(f, data, 8);
+		break;
+	case D3DDECLTYPE_FLOAT1:
+		memcpy(f, data, 4);
+		break;
+	case D3DDECLTYPE_D3DCOLOR:
+		// ARGB dword: B G R A in memory
+		f[0] = data[2] / 255.0f;
+		f[1] = data[1] / 255.0f;
+		f[2] = data[0] / 255.0f;
+		f[3] = data[3] / 255.0f;
+		break;
+	case D3DDECLTYPE_UBYTE4:
+		for (int i = 0; i < 4; i++)
+			f[i] = (float)data[i];
+		break;
+	case D3DDECLTYPE_UBYTE4N:
+		for (int i = 0; i < 4; i++)
+			f[i] = data[i] / 255.0f;
+		break;
+	case D3DDECLTYPE_SHORT2:
+	case D3DDECLTYPE_SHORT4:
+	{
+		const short *s = (const short*)data;
+		int n = type == D3DDECLTYPE_SHORT2 ? 2 : 4;
+		for (int i = 0; i < n; i++)
+			f[i] = (float)s[i];
+		break;
+	}
+	case D3DDECLTYPE_SHORT2N:
+	case D3DDECLTYPE_SHORT4N:
+	{
+		const short *s = (const short*)data;
+		int n = type == D3DDECLTYPE_SHORT2N ? 2 : 4;
+		for (int i = 0; i < n; i++)
+			f[i] = s[i] < -32767 ? -1.0f : s[i] / 32767.0f;
+		break;
+	}
+	case D3DDECLTYPE_USHORT2N:
+	case D3DDECLTYPE_USHORT4N:
+	{
+		const unsigned short *s = (const unsigned short*)data;
+		int n = type == D3DDECLTYPE_USHORT2N ? 2 : 4;
+		for (int i = 0; i < n; i++)
+			f[i] = s[i] / 65535.0f;
+		break;
+	}
+	case D3DDECLTYPE_UDEC3:
+	{
+		DWORD v;
+		memcpy(&v, data, 4);
+		f[0] = (float)(v & 0x3FF);
+		f[1] = (float)((v >> 10) & 0x3FF);
+		f[2] = (float)((v >> 20) & 0x3FF);
+		break;
+	}
+	case D3DDECLTYPE_DEC3N:
+	{
+		DWORD v;
+		memcpy(&v, data, 4);
+		for (int i = 0; i < 3; i++)
+		{
+			int c = (int)((v >> (i * 10)) & 0x3FF);
+			if (c & 0x200)
+				c -= 0x400;
+			f[i] = c < -511 ? -1.0f : c / 511.0f;
+		}
+		break;
+	}
+	case D3DDECLTYPE_FLOAT16_2:
+	case D3DDECLTYPE_FLOAT16_4:
+	{
+		const unsigned short *s = (const unsigned short*)data;
+		int n = type == D3DDECLTYPE_FLOAT16_2 ? 2 : 4;
+		for (int i = 0; i < n; i++)
+			f[i] = HalfToFloat(s[i]);
+		break;
+	}
+	}
+}
+
+static thread_local SubsetRemap s_scratch;
+
+RemapScratch::RemapScratch(SubsetRemap& remap)
+	:m_remap(remap)
+{
+	m_remap.Vertices.swap(s_scratch.Vertices);
+	m_remap.Indices.swap(s_scratch.Indices);
+}
+
+RemapScratch::~RemapScratch()
+{
+	m_remap.Vertices.swap(s_scratch.Vertices);
+	m_remap.Indices.swap(s_scratch.Indices);
+}
+
+SubsetDecoder::SubsetDecoder(SDKMesh *mesh, UINT meshID, MeshProcessor *processor, UINT attributes)
+	:m_sdkMesh(mesh),
+	m_meshID(meshID),
+	m_cache(mesh->GetCache()),
+	m_processor(processor),
+	m_vertexData(NULL),
+	m_indexData(NULL),
+	m_position(NULL),
+	m_normal(NULL),
+	m_texcoord(NULL),
+	m_color(NULL),
+	m_blendWeight(NULL),
+	m_blendIndices(NULL),
+	m_attributes(attributes | VA_POSITION),
+	m_transform(NULL),
+	m_budget(NULL),
+	m_bones(NULL),
+	m_numBones(0)
+{
+	SDKMESH_MESH *sdkMesh = mesh->GetMesh(meshID);
+
+	if (m_cache == NULL)
+	{
+		m_vertexData = mesh->GetRawVerticesAt(sdkMesh->VertexBuffers[0]);
+		m_indexData = mesh->GetRawIndicesAt(sdkMesh->IndexBuffer);
+	}
+
+	m_vertexStride = mesh->GetVertexStride(meshID, 0);
+	m_numVertices = mesh->GetNumVertices(meshID, 0);
+	m_index32 = mesh->GetIndexType(meshID) == IT_32BIT;
+
+	// pick the first element of each usage
+	const D3DVERTEXELEMENT9* declaration = mesh->VBElements(meshID, 0);
+	UINT numInputElements = 0;
+	while (declaration[numInputElements].Stream != 0xFF && numInputElements < MAX_VERTEX_ELEMENTS)
+	{
+		const D3DVERTEXELEMENT9& element9 = declaration[numInputElements];
+
+		if (element9.Usage == D3DDECLUSAGE_POSITION && m_position == NULL && CanDecode(element9.Type, 3))
+			m_position = &element9;
+		else if (element9.Usage == D3DDECLUSAGE_NORMAL && m_normal == NULL && CanDecode(element9.Type, 3))
+			m_normal = &element9;
+		else if (element9.Usage == D3DDECLUSAGE_TEXCOORD && m_texcoord == NULL && CanDecode(element9.Type, 2))
+			m_texcoord = &element9;
+		else if (element9.Usage == D3DDECLUSAGE_COLOR && m_color == NULL && CanDecode(element9.Type, 3))
+			m_color = &element9;
+		else if (element9.Usage == D3DDECLUSAGE_BLENDWEIGHT && m_blendWeight == NULL && CanDecode(element9.Type, 1))
+			m_blendWeight = &element9;
+		else if (element9.Usage == D3DDECLUSAGE_BLENDINDICES && m_blendIndices == NULL && CanDecode(element9.Type, 1))
+			m_blendIndices = &element9;
+
+		numInputElements++;
+	}
+
+	if (m_cache)
+	{
+		UINT flags = m_cache->GetMesh(meshID)->Flags;
+		if ((flags & MCF_NORMAL) == 0)
+			m_normal = NULL;
+		if ((flags & MCF_TEXCOORD) == 0)
+			m_texcoord = NULL;
+		if ((flags & MCF_COLOR) == 0)
+			m_color = NULL;
+
+		// the cache has no blend streams
+		m_blendWeight = NULL;
+		m_blendIndices = NULL;
+	}
+
+	// stripped attributes: only the bytes of the kept elements are touched
+	if ((m_attributes & VA_NORMAL) == 0)
+		m_normal = NULL;
+	if ((m_attributes & VA_TEXCOORD) == 0)
+		m_texcoord = NULL;
+	if ((m_attributes & VA_COLOR) == 0)
+		m_color = NULL;
+
+	if (processor)
+	{
+		UINT numBones = 0;
+		const D3DXMATRIX *bones = processor->GetBones(meshID, &numBones);
+		SetBones(bones, numBones);
+	}
+}
+
+void SubsetDecoder::SetBudget(MemoryBudget *budget)
+{
+	m_budget = budget;
+
+	if (m_budget != NULL && m_vertexData != NULL)
+		m_budget->AdviseRandom(m_vertexData, m_numVertices * m_vertexStride);
+}
+
+const BYTE* SubsetDecoder::GetVertex(UINT vertex)
+{
+	const BYTE *data = m_vertexData + (size_t)vertex * m_vertexStride;
+	if (m_budget != NULL)
+		m_budget->Touch(data, m_vertexStride);
+	return data;
+}
+
+bool SubsetDecoder::Remap(SDKMESH_SUBSET *subset, SubsetRemap& remap)
+{
+	remap.Vertices.clear();
+	remap.Indices.clear();
+
+	if (m_processor)
+	{
+		int i = FindSubset(subset);
+		const SubsetRemap *processed = i >= 0 ? m_processor->GetRemap(m_meshID, (UINT)i) : NULL;
+		if (processed == NULL)
+			return false;
+
+		remap.Vertices = processed->Vertices;
+		remap.Indices = processed->Indices;
+		return true;
+	}
+
+	if (m_cache)
+	{
+		// already remapped, vertices are the ids in the cache streams
+		int i = FindSubset(subset);
+		if (i < 0)
+			return false;
+
+		const MESHCACHE_SUBSET *entry = m_cache->GetSubset(m_meshID, (UINT)i);
+		const UINT *indices = m_cache->GetIndices() + entry->FirstIndex;
+
+		remap.Vertices.resize((size_t)entry->NumVertices);
+		for (size_t j = 0, n = remap.Vertices.size(); j < n; j++)
+			remap.Vertices[j] = (UINT)(entry->FirstVertex + j);
+
+		remap.Indices.assign(indices, indices + entry->NumIndices);
+		return true;
+	}
+
+	remap.Indices.reserve((size_t)subset->IndexCount);
+
+	if (m_lookup.Size() != m_numVertices)
+		ResetLookup();
+
+	bool success = true;
+
+	UINT64 end = subset->IndexStart + subset->IndexCount / 3 * 3;
+	for (UINT64 i = subset->IndexStart; i < end; i++)
+	{
+		UINT index = GetIndex(i);
+		if (index >= m_numVertices)
+		{
+			success = false;
+			break;
+		}
+
+		UINT& m = m_lookup[index];
+		if (m == INVALID_REMAP)
+		{
+			m = (UINT)remap.Vertices.size();
+			remap.Vertices.push_back(index);
+		}
+
+		remap.Indices.push_back(m);
+	}
+
+	// reset the lookup for the next subset
+	for (size_t i = 0, n = remap.Vertices.size(); i < n; i++)
+		m_lookup[remap.Vertices[i]] = INVALID_REMAP;
+
+	return success;
+}
+
+bool SubsetDecoder::RemapWindow(SDKMESH_SUBSET *subset, UINT64 first, UINT64 count, UINT base, SubsetRemap& remap)
+{
+	remap.Vertices.clear();
+	remap.Indices.clear();
+
+	if (!CanRemapWindows())
+		return false;
+
+	if (m_lookup.Size() != m_numVertices)
+		ResetLookup();
+
+	UINT64 numIndices = subset->IndexCount / 3 * 3;
+	if (first >= numIndices)
+		return true;
+
+	UINT64 end = first + count < numIndices ? first + count : numIndices;
+	remap.Indices.reserve((size_t)(end - first));
+
+	// the lookup keeps the numbers of the previous windows
+	for (UINT64 i = subset->IndexStart + first; i < subset->IndexStart + end; i++)
+	{
+		UINT index = GetIndex(i);
+		if (index >= m_numVertices)
+			return false;
+
+		UINT& m = m_lookup[index];
+		if (m == INVALID_REMAP)
+		{
+			m = base + (UINT)remap.Vertices.size();
+			remap.Vertices.push_back(index);
+		}
+
+		remap.Indices.push_back(m);
+	}
+
+	return true;
+}
+
+void SubsetDecoder::EndWindows()
+{
+	// the vertices of the windows are not kept, the whole lookup is reset
+	ResetLookup();
+}
+
+void SubsetDecoder::ResetLookup()
+{
+	m_lookup.Resize((size_t)m_numVertices);
+	for (size_t i = 0, n = m_lookup.Size(); i < n; i++)
+		m_lookup[i] = INVALID_REMAP;
+}
+
+int SubsetDecoder::FindSubset(SDKMESH_SUBSET *subset)
+{
+	UINT numSubsets = m_sdkMesh->GetNumSubsets(m_meshID);
+	for (UINT i = 0; i < numSubsets; i++)
+	{
+		if (m_sdkMesh->GetSubset(m_meshID, i) == subset)
+			return (int)i;
+	}
+	return -1;
+}
+
+const GeneratedNormals* SubsetDecoder::GetGeneratedNormals()
+{
+	if (m_processor == NULL || (m_attributes & VA_NORMAL) == 0)
+		return NULL;
+	return m_processor->GetGeneratedNormals(m_meshID);
+}
+
+const UINT* SubsetDecoder::ResolveVertices(const UINT *vertices, UINT count)
+{
+	const GeneratedNormals *generated = GetGeneratedNormals();
+	if (generated == NULL || generated->Sources.empty())
+		return vertices;
+
+	m_resolved.resize(count);
+	for (UINT i = 0; i < count; i++)
+	{
+		UINT v = vertices[i];
+		m_resolved[i] = v < generated->NumVertices ? v : generated->Sources[v - generated->NumVertices];
+	}
+	return m_resolved.data();
+}
+
+bool SubsetDecoder::Decode(const D3DVERTEXELEMENT9 *element, const UINT *vertices, UINT count, float *out, int numComponents)
+{
+	if (element == NULL)
+		return false;
+
+	vertices = ResolveVertices(vertices, count);
+
+	WORD offset = element->Offset;
+	BYTE type = element->Type;
+
+	if (type == D3DDECLTYPE_FLOAT3 && numComponents == 3)
+	{
+		// fast path
+		for (UINT i = 0; i < count; i++)
+			memcpy(out + i * 3, GetVertex(vertices[i]) + offset, 12);
+		return true;
+	}
+
+	float f[4];
+	for (UINT i = 0; i < count; i++)
+	{
+		DecodeElement(type, GetVertex(vertices[i]) + offset, f);
+		for (int j = 0; j < numComponents; j++)
+			out[i * numComponents + j] = f[j];
+	}
+	return true;
+}
+
+bool SubsetDecoder::DecodeCache(const float *stream, const UINT *vertices, UINT count, float *out, int numComponents)
+{
+	vertices = ResolveVertices(vertices, count);
+
+	for (UINT i = 0; i < count; i++)
+		memcpy(out + i * numComponents, stream + (size_t)vertices[i] * numComponents, sizeof(float) * numComponents);
+	return true;
+}
+
+bool SubsetDecoder::DecodePositions(const UINT *vertices, UINT count, float *out)
+{
+	if (m_cache && m_position)
+	{
+		DecodeCache(m_cache->GetPositions(), vertices, count, out, 3);
+	}
+	else
+	{
+		if (!Decode(m_position, vertices, count, out, 3))
+			return false;
+
+		if (IsSkinned() && DecodeSkin(vertices, count))
+			Skinning::SkinPositions(out, m_weights.data(), m_indices.data(), count, m_bones, m_numBones, out);
+	}
+
+	// the chunk is still in cache, no pass over the whole stream
+	if (m_transform != NULL)
+		m_transform->TransformPositions(out, count);
+
+	return true;
+}
+
+bool SubsetDecoder::DecodeNormals(const UINT *vertices, UINT count, float *out)
+{
+	if (m_cache && m_normal)
+	{
+		DecodeCache(m_cache->GetNormals(), vertices, count, out, 3);
+
+		if (m_transform != NULL)
+			m_transform->TransformNormals(out, count);
+
+		return true;
+	}
+
+	const GeneratedNormals *generated = m_normal ? NULL : GetGeneratedNormals();
+	if (generated)
+	{
+		// indexed by vertex id, split vertices included
+		for (UINT i = 0; i < count; i++)
+			memcpy(out + i * 3, &generated->Normals[(size_t)vertices[i] * 3], sizeof(float) * 3);
+	}
+	else if (!Decode(m_normal, vertices, count, out, 3))
+	{
+		return false;
+	}
+
+	if (IsSkinned() && DecodeSkin(vertices, count))
+		Skinning::SkinNormals(out, m_weights.data(), m_indices.data(), count, m_bones, m_numBones, out);
+
+	if (m_transform != NULL)
+		m_transform->TransformNormals(out, count);
+
+	return true;
+}
+
+bool SubsetDecoder::DecodeTexcoords(const UINT *vertices, UINT count, float *out)
+{
+	// the cache stores texcoords already flipped
+	if (m_cache && m_texcoord)
+		return DecodeCache(m_cache->GetTexcoords(), vertices, count, out, 2);
+
+	if (!Decode(m_texcoord, vertices, count, out, 2))
+		return false;
+
+	for (UINT i = 0; i < count; i++)
+		out[i * 2 + 1] = 1.0f - out[i * 2 + 1];
+
+	return true;
+}
+
+bool SubsetDecoder::DecodeColors(const UINT *vertices, UINT count, float *out)
+{
+	if (m_cache && m_color)
+	{
+		vertices = ResolveVertices(vertices, count);
+
+		const BYTE *colors = m_cache->GetColors();
+		for (UINT i = 0; i < count; i++)
+		{
+			for (int j = 0; j < 4; j++)
+				out[i * 4 + j] = colors[(size_t)vertices[i] * 4 + j] / 255.0f;
+		}
+		return true;
+	}
+
+	return Decode(m_color, vertices, count, out, 4);
+}
+
+bool SubsetDecoder::DecodeSet(const D3DVERTEXELEMENT9 *element, const UINT *vertices, UINT count, float *out)
+{
+	if (element == m_position)
+		return DecodePositions(vertices, count, out);
+	if (element == m_normal)
+		return DecodeNormals(vertices, count, out);
+	if (element == m_texcoord)
+		return DecodeTexcoords(vertices, count, out);
+
+	if (m_vertexData == NULL)
+		return false;
+
+	if (element->Usage == D3DDECLUSAGE_TEXCOORD)
+	{
+		if (!CanDecode(element->Type, 2) || !Decode(element, vertices, count, out, 2))
+			return false;
+
+		for (UINT i = 0; i < count; i++)
+			out[i * 2 + 1] = 1.0f - out[i * 2 + 1];
+		return true;
+	}
+
+	if (!CanDecode(element->Type, 3) || !Decode(element, vertices, count, out, 3))
+		return false;
+
+	bool skinned = IsSkinned() && DecodeSkin(vertices, count);
+
+	if (element->Usage == D3DDECLUSAGE_POSITION)
+	{
+		if (skinned)
+			Skinning::SkinPositions(out, m_weights.data(), m_indices.data(), count, m_bones, m_numBones, out);
+		if (m_transform != NULL)
+			m_transform->TransformPositions(out, count);
+	}
+	else
+	{
+		if (skinned)
+			Skinning::SkinNormals(out, m_weights.data(), m_indices.data(), count, m_bones, m_numBones, out);
+		if (m_transform != NULL)
+			m_transform->TransformNormals(out, count);
+	}
+	return true;
+}
+
+bool SubsetDecoder::DecodeBlendWeights(const UINT *vertices, UINT count, float *out)
+{
+	if (m_blendWeight == NULL)
+		return false;
+
+	if (!Decode(m_blendWeight, vertices, count, out, 4))
+		return false;
+
+	// the last weight is implicit when there are less than 4 components
+	int n = GetNumComponents(m_blendWeight->Type);
+	if (n < 4)
+	{
+		for (UINT i = 0; i < count; i++)
+		{
+			float *w = out + i * 4;
+			float sum = 0.0f;
+			for (int j = 0; j < n; j++)
+				sum += w[j];
+
+			for (int j = n; j < 4; j++)
+				w[j] = 0.0f;
+
+			w[n] = 1.0f - sum;
+		}
+	}
+
+	return true;
+}
+
+bool SubsetDecoder::DecodeBlendIndices(const UINT *vertices, UINT count, UINT *out)
+{
+	if (m_blendIndices == NULL)
+		return false;
+
+	WORD offset = m_blendIndices->Offset;
+	BYTE type = m_blendIndices->Type;
+
+	vertices = ResolveVertices(vertices, count);
+
+	if (type == D3DDECLTYPE_UBYTE4 || type == D3DDECLTYPE_UBYTE4N || type == D3DDECLTYPE_D3DCOLOR)
+	{
+		// raw bytes (a D3DCOLOR is swizzled back by D3DCOLORtoUBYTE4 in the shaders)
+		for (UINT i = 0; i < count; i++)
+		{
+			const BYTE *b = GetVertex(vertices[i]) + offset;
+			for (int j = 0; j < 4; j++)
+				out[i * 4 + j] = b[j];
+		}
+		return true;
+	}
+
+	int n = GetNumComponents(type);
+
+	float f[4];
+	for (UINT i = 0; i < count; i++)
+	{
+		DecodeElement(type, GetVertex(vertices[i]) + offset, f);
+		for (int j = 0; j < 4; j++)
+			out[i * 4 + j] = j < n && f[j] > 0.0f ? (UINT)(f[j] + 0.5f) : 0;
+	}
+	return true;
+}
+
+bool SubsetDecoder::DecodeSkin(const UINT *vertices, UINT count)
+{
+	m_weights.resize((size_t)count * 4);
+	m_indices.resize((size_t)count * 4);
+
+	return DecodeBlendWeights(vertices, count, m_weights.data()) &&
+		DecodeBlendIndices(vertices, count, m_indices.data());
+}
+
+bool SubsetDecoder::ParseAttributes(const char *list, UINT *attributes)
+{
+	std::vector<std::string> names;
+	Skylicht::CStringImp::splitString(list, ",", names);
+
+	*attributes = VA_POSITION;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		const std::string& name = names[i];
+		if (name == "position")
+			*attributes |= VA_POSITION;
+		else if (name == "normal")
+			*attributes |= VA_NORMAL;
+		else if (name == "uv" || name == "texcoord")
+			*attributes |= VA_TEXCOORD;
+		else if (name == "color")
+			*attributes |= VA_COLOR;
+		else if (!name.empty())
+			return false;
+	}
+	return true;
+}
+
+int SubsetDecoder::GetNumComponents(BYTE type)
+{
+	switch (type)
+	{
+	case D3DDECLTYPE_FLOAT1:
+		return 1;
+	case D3DDECLTYPE_FLOAT2:
+	case D3DDECLTYPE_SHORT2:
+	case D3DDECLTYPE_SHORT2N:
+	case D3DDECLTYPE_USHORT2N:
+	case D3DDECLTYPE_FLOAT16_2:
+		return 2;
+	case D3DDECLTYPE_FLOAT3:
+	case D3DDECLTYPE_UDEC3:
+	case D3DDECLTYPE_DEC3N:
+		return 3;
+	}
+	return 4;
+}
+
+bool SubsetDecoder::CanDecode(BYTE type, int numComponents)
+{
+	switch (type)
+	{
+	case D3DDECLTYPE_FLOAT1:
+		return numComponents <= 1;
+	case D3DDECLTYPE_FLOAT2:
+	case D3DDECLTYPE_SHORT2:
+	case D3DDECLTYPE_SHORT2N:
+	case D3DDECLTYPE_USHORT2N:
+	case D3DDECLTYPE_FLOAT16_2:
+		return numComponents <= 2;
+	case D3DDECLTYPE_FLOAT3:
+	case D3DDECLTYPE_UDEC3:
+	case D3DDECLTYPE_DEC3N:
+	case D3DDECLTYPE_FLOAT4:
+	case D3DDECLTYPE_D3DCOLOR:
+	case D3DDECLTYPE_UBYTE4:
+	case D3DDECLTYPE_SHORT4:
+	case D3DDECLTYPE_UBYTE4N:
+	case D3DDECLTYPE_SHORT4N:
+	case D3DDECLTYPE_USHORT4N:
+	case D3DDECLTYPE_FLOAT16_4:
+		return true;
+	}
+	return false;
+}
+
+const char* SubsetDecoder::GetUsageName(BYTE usage)
+{
+	switch (usage)
+	{
+	case D3DDECLUSAGE_POSITION:
+		return "POSITION";
+	case D3DDECLUSAGE_BLENDWEIGHT:
+		return "BLENDWEIGHT";
+	case D3DDECLUSAGE_BLENDINDICES:
+		return "BLENDINDICES";
+	case D3DDECLUSAGE_NORMAL:
+		return "NORMAL";
+	case D3DDECLUSAGE_TEXCOORD:
+		return "TEXCOORD";
+	case D3DDECLUSAGE_TANGENT:
+		return "TANGENT";
+	case D3DDECLUSAGE_BINORMAL:
+		return "BINORMAL";
+	case D3DDECLUSAGE_COLOR:
+		return "COLOR";
+	}
+	return "";
+}
+
+const char* SubsetDecoder::GetFormatName(BYTE type)
+{
+	switch (type)
+	{
+	case D3DDECLTYPE_FLOAT1:
+		return "DXGI_FORMAT_R32_FLOAT";
+	case D3DDECLTYPE_FLOAT2:
+		return "DXGI_FORMAT_R32G32_FLOAT";
+	case D3DDECLTYPE_FLOAT3:
+		return "DXGI_FORMAT_R32G32B32_FLOAT";
+	case D3DDECLTYPE_FLOAT4:
+		return "DXGI_FORMAT_R32G32B32A32_FLOAT";
+	case D3DDECLTYPE_D3DCOLOR:
+		return "DXGI_FORMAT_R8G8B8A8_UNORM";
+	case D3DDECLTYPE_UBYTE4:
+		return "DXGI_FORMAT_R8G8B8A8_UINT";
+	case D3DDECLTYPE_SHORT2:
+		return "DXGI_FORMAT_R16G16_SINT";
+	case D3DDECLTYPE_SHORT4:
+		return "DXGI_FORMAT_R16G16B16A16_SINT";
+	case D3DDECLTYPE_UBYTE4N:
+		return "DXGI_FORMAT_R8G8B8A8_UNORM";
+	case D3DDECLTYPE_SHORT2N:
+		return "DXGI_FORMAT_R16G16_SNORM";
+	case D3DDECLTYPE_SHORT4N:
+		return "DXGI_FORMAT_R16G16B16A16_SNORM";
+	case D3DDECLTYPE_USHORT2N:
+		return "DXGI_FORMAT_R16G16_UNORM";
+	case D3DDECLTYPE_USHORT4N:
+		return "DXGI_FORMAT_R16G16B16A16_UNORM";
+	case D3DDECLTYPE_UDEC3:
+		return "DXGI_FORMAT_R10G10B10A2_UINT";
+	case D3DDECLTYPE_DEC3N:
+		return "DXGI_FORMAT_R10G10B10A2_UNORM";
+	case D3DDECLTYPE_FLOAT16_2:
+		return "DXGI_FORMAT_R16G16_FLOAT";
+	case D3DDECLTYPE_FLOAT16_4:
+		return "DXGI_FORMAT_R16G16B16A16_FLOAT";
+	}
+	return "";
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "SDKMesh.h"
+#include "MeshCache.h"
+#include "Arena.h"
+
+class MeshProcessor;
+class MemoryBudget;
+class VertexTransform;
+struct GeneratedNormals;
+
+// Subset vertices renumbered in first-use order
+struct SubsetRemap
+{
+	// source vertex index (in the mesh vertex buffer) of each output vertex
+	std::vector<UINT> Vertices;
+
+	// triangle list that references the output vertices (0-based)
+	std::vector<UINT> Indices;
+};
+
+// Remap vectors this thread keeps between the conversions: a writer borrows them for its
+// lifetime, so the subsets of the next files reuse their capacity instead of growing new ones
+class RemapScratch
+{
+protected:
+	SubsetRemap& m_remap;
+
+public:
+	RemapScratch(SubsetRemap& remap);
+
+	~RemapScratch();
+
+private:
+	RemapScratch& operator=(const RemapScratch&);
+};
+
+// vertex attributes a writer outputs (-attributes), the positions are always decoded
+enum VERTEX_ATTRIBUTE
+{
+	VA_POSITION = 1,
+	VA_NORMAL = 2,
+	VA_TEXCOORD = 4,
+	VA_COLOR = 8,
+	VA_ALL = VA_POSITION | VA_NORMAL | VA_TEXCOORD | VA_COLOR
+};
+
+// Decode attributes of a mesh vertex buffer into float streams
+// (or read them back from the converted mesh cache the mesh was loaded from)
+class SubsetDecoder
+{
+protected:
+	SDKMesh *m_sdkMesh;
+	UINT m_meshID;
+
+	MeshCache *m_cache;
+	MeshProcessor *m_processor;
+
+	BYTE *m_vertexData;
+	BYTE *m_indexData;
+	UINT m_vertexStride;
+	UINT64 m_numVertices;
+	bool m_index32;
+
+	const D3DVERTEXELEMENT9 *m_position;
+	const D3DVERTEXELEMENT9 *m_normal;
+	const D3DVERTEXELEMENT9 *m_texcoord;
+	const D3DVERTEXELEMENT9 *m_color;
+	const D3DVERTEXELEMENT9 *m_blendWeight;
+	const D3DVERTEXELEMENT9 *m_blendIndices;
+
+	// VERTEX_ATTRIBUTE flags, the other elements are never read
+	UINT m_attributes;
+
+	// coordinate conversion of the decoded positions & normals (not owned), NULL: none
+	const VertexTransform *m_transform;
+
+	// -budget: the vertices are accounted before they are read (not owned), NULL: none
+	MemoryBudget *m_budget;
+
+	// output vertex of each mesh vertex during a remap, in the session arena
+	ArenaArray<UINT> m_lookup;
+
+	// skinning: bone of each frame influence (not owned) and per chunk scratch
+	const D3DXMATRIX *m_bones;
+	UINT m_numBones;
+	std::vector<float> m_weights;
+	std::vector<UINT> m_indices;
+
+	// source vertex of the split vertices of generated normals
+	std::vector<UINT> m_resolved;
+
+public:
+	// with a processor, Remap returns the processed remap of the subset,
+	// the attributes not in 'attributes' are reported missing
+	SubsetDecoder(SDKMesh *mesh, UINT meshID, MeshProcessor *processor = NULL, UINT attributes = VA_ALL);
+
+	bool HasPosition() { return m_position != NULL; }
+
+	// NORMAL element or normals generated by the processor
+	bool HasNormal() { return m_normal != NULL || GetGeneratedNormals() != NULL; }
+
+	bool HasTexcoord() { return m_texcoord != NULL; }
+
+	bool HasColor() { return m_color != NULL; }
+
+	bool HasSkin() { return m_blendWeight != NULL && m_blendIndices != NULL; }
+
+	// bytes read per index & per vertex of the source buffers
+	UINT GetIndexSize() { return m_index32 ? 4 : 2; }
+
+	UINT GetVertexStride() { return m_vertexStride; }
+
+	UINT64 GetNumVertices() { return m_numVertices; }
+
+	// positions & normals are skinned by these bones (one per frame influence of the mesh)
+	void SetBones(const D3DXMATRIX *bones, UINT numBones)
+	{
+		m_bones = bones;
+		m_numBones = numBones;
+	}
+
+	bool IsSkinned() { return m_bones != NULL && m_numBones > 0 && HasSkin(); }
+
+	// applied to each decoded chunk, after the skinning
+	void SetTransform(const VertexTransform *transform)
+	{
+		m_transform = transform;
+	}
+
+	// the vertex buffer is read in random order, each vertex is accounted in the budget
+	void SetBudget(MemoryBudget *budget);
+
+	// read the source vertex index at a position of the mesh index buffer
+	inline UINT GetIndex(UINT64 i)
+	{
+		if (m_index32)
+			return ((DWORD*)m_indexData)[i];
+		return ((unsigned short*)m_indexData)[i];
+	}
+
+	bool Remap(SDKMESH_SUBSET *subset, SubsetRemap& remap);
+
+	// indices [first, first + count) of a subset (no processor, no cache): remap.Vertices gets the vertices
+	// first used in this window, numbered from 'base' (the vertices of the previous windows)
+	// and remap.Indices is numbered from the start of the subset. EndWindows after the last window.
+	bool RemapWindow(SDKMESH_SUBSET *subset, UINT64 first, UINT64 count, UINT base, SubsetRemap& remap);
+
+	void EndWindows();
+
+	bool CanRemapWindows() { return m_processor == NULL && m_cache == NULL; }
+
+	// decode 'count' vertices listed in 'vertices', the out buffers are packed
+	// positions & normals: 3 floats, texcoords: 2 floats (V flipped), colors: 4 floats (RGBA)
+	bool DecodePositions(const UINT *vertices, UINT count, float *out);
+
+	bool DecodeNormals(const UINT *vertices, UINT count, float *out);
+
+	bool DecodeTexcoords(const UINT *vertices, UINT count, float *out);
+
+	bool DecodeColors(const UINT *vertices, UINT count, float *out);
+
+	// a POSITION, NORMAL or TEXCOORD element of the declaration, the other sets of a usage
+	// (a second texcoord set...) are read from the vertex buffer: false when the mesh was
+	// loaded from a cache, it only keeps the first set
+	bool DecodeSet(const D3DVERTEXELEMENT9 *element, const UINT *vertices, UINT count, float *out);
+
+	// 4 weights per vertex (the implicit last weight of FLOAT1..3 is 1 - sum), 4 bone indices per vertex
+	bool DecodeBlendWeights(const UINT *vertices, UINT count, float *out);
+
+	bool DecodeBlendIndices(const UINT *vertices, UINT count, UINT *out);
+
+	// position,normal,uv,color list to VERTEX_ATTRIBUTE flags (VA_POSITION always set), false if a name is unknown
+	static bool ParseAttributes(const char *list, UINT *attributes);
+
+	static bool CanDecode(BYTE type, int numComponents);
+
+	static int GetNumComponents(BYTE type);
+
+	static const char* GetUsageName(BYTE usage);
+
+	static const char* GetFormatName(BYTE type);
+
+protected:
+	void ResetLookup();
+
+	// index of the subset in the mesh, -1 if not found
+	int FindSubset(SDKMESH_SUBSET *subset);
+
+	bool DecodeCache(const float *stream, const UINT *vertices, UINT count, float *out, int numComponents);
+
+	bool Decode(const D3DVERTEXELEMENT9 *element, const UINT *vertices, UINT count, float *out, int numComponents);
+
+	// a vertex of the source buffer, about to be read
+	const BYTE* GetVertex(UINT vertex);
+
+	// decode the blend streams of a chunk into the scratch buffers
+	bool DecodeSkin(const UINT *vertices, UINT count);
+
+	const GeneratedNormals* GetGeneratedNormals();
+
+	// vertex ids to vertex buffer ids (split vertices of the generated normals)
+	const UINT* ResolveVertices(const UINT *vertices, UINT count);
+};
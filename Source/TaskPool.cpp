@@ -0,0 +1,219 @@
+#include "TaskPool.h"
+#include "Arena.h"
+
+static thread_local TaskPool *s_pool = NULL;
+static thread_local int s_worker = -1;
+
+TaskPool::TaskPool(int numThreads)
+	:m_exit(false),
+	m_queued(0),
+	m_steals(0)
+{
+	if (numThreads < 1)
+		numThreads = 1;
+
+	for (int i = 0; i < numThreads; i++)
+		m_workers.push_back(new Worker());
+
+	for (int i = 0; i < numThreads; i++)
+		m_threads.push_back(std::thread(&TaskPool::WorkerLoop, this, i));
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_exit = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); i++)
+		m_threads[i].join();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+		delete m_workers[i];
+}
+
+TaskPool* TaskPool::GetCurrent()
+{
+	return s_pool;
+}
+
+void TaskPool::Run(TaskGroup& group, const Task& task)
+{
+	Entry entry;
+	entry.Func = task;
+	entry.Group = &group;
+
+	group.Pending++;
+	m_queued++;
+
+	if (s_pool == this)
+	{
+		Worker *worker = m_workers[s_worker];
+		std::lock_guard<std::mutex> lock(worker->Lock);
+		worker->Tasks.push_back(entry);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_shared.push_back(entry);
+	}
+
+	// lock so a worker can not miss the wake up between its check and its wait
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+	}
+	m_wake.notify_one();
+}
+
+void TaskPool::Wait(TaskGroup& group)
+{
+	if (s_pool == this)
+	{
+		// only the tasks of this group: an unrelated task could keep the caller busy for long
+		while (group.Pending > 0)
+		{
+			Entry entry;
+			if (FindTask(s_worker, &group, entry))
+				Execute(entry);
+			else
+				std::this_thread::yield();
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		while (group.Pending > 0)
+			m_done.wait(lock);
+	}
+}
+
+void TaskPool::ParallelFor(size_t count, int numRunners, const std::function<void(size_t, int)>& func)
+{
+	std::atomic<size_t> next(0);
+	TaskGroup group;
+
+	// runners pull the items one by one, idle workers steal the runners
+	for (int r = 1; r < numRunners; r++)
+	{
+		Run(group, [&next, &func, count, r]()
+		{
+			size_t i;
+			while ((i = next.fetch_add(1)) < count)
+				func(i, r);
+		});
+	}
+
+	size_t i;
+	while ((i = next.fetch_add(1)) < count)
+		func(i, 0);
+
+	Wait(group);
+}
+
+void TaskPool::WorkerLoop(int id)
+{
+	s_pool = this;
+	s_worker = id;
+
+	while (true)
+	{
+		Entry entry;
+		if (FindTask(id, NULL, entry))
+		{
+			Execute(entry);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_lock);
+		if (m_exit)
+			break;
+
+		if (m_queued == 0)
+			m_wake.wait(lock);
+	}
+
+	s_pool = NULL;
+	s_worker = -1;
+}
+
+bool TaskPool::TakeFront(std::deque<Entry>& tasks, TaskGroup *group, Entry& entry)
+{
+	for (std::deque<Entry>::iterator i = tasks.begin(), end = tasks.end(); i != end; ++i)
+	{
+		if (group == NULL || i->Group == group)
+		{
+			entry = *i;
+			tasks.erase(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TaskPool::FindTask(int id, TaskGroup *group, Entry& entry)
+{
+	// own deque, newest first
+	{
+		Worker *worker = m_workers[id];
+		std::lock_guard<std::mutex> lock(worker->Lock);
+
+		std::deque<Entry>& tasks = worker->Tasks;
+		if (!tasks.empty() && (group == NULL || tasks.back().Group == group))
+		{
+			entry = tasks.back();
+			tasks.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+
+	// shared queue: only the tasks submitted from outside, never a nested group
+	if (group == NULL)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (!m_shared.empty())
+		{
+			entry = m_shared.front();
+			m_shared.pop_front();
+			m_queued--;
+			return true;
+		}
+	}
+
+	// steal the oldest task of the other workers
+	int numWorkers = (int)m_workers.size();
+	for (int k = 1; k < numWorkers; k++)
+	{
+		Worker *victim = m_workers[(id + k) % numWorkers];
+		std::lock_guard<std::mutex> lock(victim->Lock);
+
+		if (TakeFront(victim->Tasks, group, entry))
+		{
+			m_queued--;
+			m_steals++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TaskPool::Execute(Entry& entry)
+{
+	// a stolen task may belong to another conversion than the session of this worker
+	Arena *session = Arena::SetCurrent(NULL);
+	entry.Func();
+	Arena::SetCurrent(session);
+
+	TaskGroup *group = entry.Group;
+	if (--group->Pending == 0)
+	{
+		// the waiting thread checks Pending under the lock
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+		}
+		m_done.notify_all();
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+// Number of unfinished tasks of one batch of work
+struct TaskGroup
+{
+	std::atomic<size_t> Pending;
+
+	TaskGroup()
+		:Pending(0)
+	{
+	}
+};
+
+// Work-stealing thread pool.
+// Each worker owns a deque: it pushes and pops its own tasks at the back (newest first, so nested
+// work stays hot in cache) and steals the oldest task at the front of another deque when it runs out.
+// Tasks submitted from outside the pool go to a shared FIFO queue.
+class TaskPool
+{
+public:
+	typedef std::function<void()> Task;
+
+protected:
+	struct Entry
+	{
+		Task Func;
+		TaskGroup *Group;
+	};
+
+	struct Worker
+	{
+		std::mutex Lock;
+		std::deque<Entry> Tasks;
+	};
+
+	std::vector<Worker*> m_workers;
+	std::vector<std::thread> m_threads;
+
+	// shared queue, sleeping workers and waiting threads
+	std::mutex m_lock;
+	std::deque<Entry> m_shared;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	bool m_exit;
+
+	// tasks in all the queues
+	std::atomic<size_t> m_queued;
+
+	std::atomic<unsigned long long> m_steals;
+
+public:
+	TaskPool(int numThreads);
+
+	virtual ~TaskPool();
+
+	int GetNumThreads()
+	{
+		return (int)m_workers.size();
+	}
+
+	unsigned long long GetNumSteals()
+	{
+		return m_steals;
+	}
+
+	void Run(TaskGroup& group, const Task& task);
+
+	// a worker runs the tasks of the group while it waits, other threads block
+	void Wait(TaskGroup& group);
+
+	// func(index, runner) on numRunners tasks; the calling worker is runner 0
+	void ParallelFor(size_t count, int numRunners, const std::function<void(size_t, int)>& func);
+
+	// pool of the calling worker thread, NULL outside of a pool
+	static TaskPool* GetCurrent();
+
+protected:
+	void WorkerLoop(int id);
+
+	// group NULL takes any task
+	bool FindTask(int id, TaskGroup *group, Entry& entry);
+
+	bool TakeFront(std::deque<Entry>& tasks, TaskGroup *group, Entry& entry);
+
+	void Execute(Entry& entry);
+};
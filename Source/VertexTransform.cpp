@@ -0,0 +1,229 @@
+#include "VertexTransform.h"
+#include "MatrixMath.h"
+#include "CStringImp.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+VertexTransform::VertexTransform()
+	:m_projective(false),
+	m_flipWinding(false)
+{
+	MatrixIdentity(&m_matrix);
+
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+			m_normal[i][j] = i == j ? 1.0f : 0.0f;
+	}
+}
+
+bool VertexTransform::Set(const char *axes, const char *scale, const char *transform, bool flipWinding)
+{
+	D3DXMATRIX m;
+	MatrixIdentity(&m);
+
+	if (axes != NULL && axes[0] != 0)
+	{
+		if (!ParseAxes(axes, &m))
+			return false;
+	}
+
+	if (scale != NULL && scale[0] != 0)
+	{
+		float s[3];
+		int n = ParseValues(scale, s, 3);
+		if (n != 1 && n != 3)
+			return false;
+
+		if (n == 1)
+			s[1] = s[2] = s[0];
+
+		D3DXMATRIX scaling;
+		MatrixScaling(&scaling, s[0], s[1], s[2]);
+		MatrixMultiply(&m, &m, &scaling);
+	}
+
+	if (transform != NULL && transform[0] != 0)
+	{
+		D3DXMATRIX t;
+		if (ParseValues(transform, &t.m[0][0], 16) != 16)
+			return false;
+
+		MatrixMultiply(&m, &m, &t);
+	}
+
+	D3DXMATRIX inverse;
+	if (!MatrixInverse(&inverse, &m))
+		return false;
+
+	m_matrix = m;
+	m_projective = m.m[0][3] != 0.0f || m.m[1][3] != 0.0f || m.m[2][3] != 0.0f || m.m[3][3] != 1.0f;
+
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+			m_normal[i][j] = inverse.m[j][i];
+	}
+
+	// a negative determinant mirrors the mesh
+	float det = m.m[0][0] * (m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1]) -
+		m.m[0][1] * (m.m[1][0] * m.m[2][2] - m.m[1][2] * m.m[2][0]) +
+		m.m[0][2] * (m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0]);
+
+	m_flipWinding = (det < 0.0f) != flipWinding;
+	return true;
+}
+
+bool VertexTransform::ParseAxes(const char *text, D3DXMATRIX *out)
+{
+	std::vector<std::string> axes;
+	Skylicht::CStringImp::splitString(text, ",", axes);
+	if (axes.size() != 3)
+		return false;
+
+	MatrixIdentity(out);
+	out->m[0][0] = out->m[1][1] = out->m[2][2] = 0.0f;
+
+	int used = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const char *a = axes[i].c_str();
+
+		float sign = 1.0f;
+		if (a[0] == '-' || a[0] == '+')
+		{
+			sign = a[0] == '-' ? -1.0f : 1.0f;
+			a++;
+		}
+
+		int source;
+		if (strcmp(a, "x") == 0)
+			source = 0;
+		else if (strcmp(a, "y") == 0)
+			source = 1;
+		else if (strcmp(a, "z") == 0)
+			source = 2;
+		else
+			return false;
+
+		// each source axis once
+		if (used & (1 << source))
+			return false;
+		used |= 1 << source;
+
+		// output axis i = sign * source axis
+		out->m[source][i] = sign;
+	}
+
+	return true;
+}
+
+int VertexTransform::ParseValues(const char *text, float *values, int maxCount)
+{
+	std::vector<std::string> items;
+	Skylicht::CStringImp::splitString(text, ",", items);
+	if ((int)items.size() > maxCount)
+		return -1;
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		const char *begin = items[i].c_str();
+		char *end = NULL;
+		values[i] = (float)strtod(begin, &end);
+		if (end == begin || *end != 0)
+			return -1;
+	}
+
+	return (int)items.size();
+}
+
+void VertexTransform::TransformNormals(float *normals, UINT count) const
+{
+	const float (*r)[3] = m_normal;
+
+	for (UINT i = 0; i < count; i++)
+	{
+		float *v = normals + i * 3;
+
+		float n[3];
+		for (int j = 0; j < 3; j++)
+			n[j] = v[0] * r[0][j] + v[1] * r[1][j] + v[2] * r[2][j];
+
+		float l = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (l > 0.0f)
+		{
+			n[0] /= l;
+			n[1] /= l;
+			n[2] /= l;
+		}
+
+		memcpy(v, n, sizeof(float) * 3);
+	}
+}
+
+#ifdef TRANSFORM_SSE
+
+void VertexTransform::TransformPositions(float *positions, UINT count) const
+{
+	const float *m = &m_matrix.m[0][0];
+	__m128 r0 = _mm_loadu_ps(m);
+	__m128 r1 = _mm_loadu_ps(m + 4);
+	__m128 r2 = _mm_loadu_ps(m + 8);
+	__m128 r3 = _mm_loadu_ps(m + 12);
+
+	float p[4];
+
+	for (UINT i = 0; i < count; i++)
+	{
+		float *v = positions + i * 3;
+
+		// row vector: x * r0 + y * r1 + z * r2 + r3
+		__m128 s = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), r0), _mm_mul_ps(_mm_set1_ps(v[1]), r1)),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[2]), r2), r3));
+
+		_mm_storeu_ps(p, s);
+
+		if (m_projective && p[3] != 0.0f)
+		{
+			p[0] /= p[3];
+			p[1] /= p[3];
+			p[2] /= p[3];
+		}
+
+		memcpy(v, p, sizeof(float) * 3);
+	}
+}
+
+#else
+
+void VertexTransform::TransformPositions(float *positions, UINT count) const
+{
+	const float (*r)[4] = m_matrix.m;
+
+	for (UINT i = 0; i < count; i++)
+	{
+		float *v = positions + i * 3;
+
+		float p[4];
+		for (int j = 0; j < 4; j++)
+			p[j] = v[0] * r[0][j] + v[1] * r[1][j] + v[2] * r[2][j] + r[3][j];
+
+		if (m_projective && p[3] != 0.0f)
+		{
+			p[0] /= p[3];
+			p[1] /= p[3];
+			p[2] /= p[3];
+		}
+
+		memcpy(v, p, sizeof(float) * 3);
+	}
+}
+
+#endif
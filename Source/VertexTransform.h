@@ -0,0 +1,62 @@
+#pragma once
+
+#include "SDKMesh.h"
+
+// Coordinate system conversion of the decoded streams (-axes, -scale, -transform, -flipwinding).
+// The matrix is axes * scale * transform (row vectors, v' = v * M): positions are transformed,
+// normals by the inverse transpose and renormalized. The streams are converted in the decoded
+// chunks, a mirroring matrix reverses the winding so the faces keep their front side.
+class VertexTransform
+{
+protected:
+	D3DXMATRIX m_matrix;
+
+	// the last column is not (0, 0, 0, 1): positions are divided by w
+	bool m_projective;
+
+	// 3x3 inverse transpose, for the normals
+	float m_normal[3][3];
+
+	bool m_flipWinding;
+
+public:
+	VertexTransform();
+
+	// -axes x,y,-z: the source axis (and sign) of each output axis, NULL or empty: none;
+	// -scale S or SX,SY,SZ; -transform with 16 row-major values. False if a value is invalid
+	// or the matrix is singular.
+	bool Set(const char *axes, const char *scale, const char *transform, bool flipWinding);
+
+	const D3DXMATRIX& GetMatrix()
+	{
+		return m_matrix;
+	}
+
+	// the triangles are written in reverse order: mirrored matrix XOR -flipwinding
+	bool FlipsWinding() const
+	{
+		return m_flipWinding;
+	}
+
+	// packed float3 streams, in place
+	void TransformPositions(float *positions, UINT count) const;
+
+	void TransformNormals(float *normals, UINT count) const;
+
+	// reverse a triangle (b & c) when the winding is flipped
+	template<class T>
+	inline void OrderTriangle(T& b, T& c) const
+	{
+		if (m_flipWinding)
+		{
+			T t = b;
+			b = c;
+			c = t;
+		}
+	}
+
+	static bool ParseAxes(const char *text, D3DXMATRIX *out);
+
+	// comma separated numbers, returns how many were read (at most maxCount), -1 if one is invalid
+	static int ParseValues(const char *text, float *values, int maxCount);
+};
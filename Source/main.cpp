@@ -17,146 +17,442 @@ https://github.com/skylicht-lab/skylicht-engine
 !#
 */
 
-#include "SDKMesh.h"
-#include "OBJWriter.h"
+#include "Converter.h"
+#include "BatchConverter.h"
+#include "ConversionCache.h"
+#include "ConversionServer.h"
+#include "MappedFile.h"
+#include "MeshManifest.h"
+#include "MeshInfo.h"
+#include "CStringImp.h"
+#include "CommandLine.h"
+#include "Log.h"
 
-#include <iostream>
-
-std::string getCmdOption(int argc, char* argv[], const std::string& option)
+void parseOptions(int argc, char** argv, ConvertOptions& options)
 {
-	std::string cmd;
-	for (int i = 0; i < argc; ++i)
+	// converted mesh cache: reuse the decoded streams if it is up to date
+	options.Cache = getCmdOption(argc, argv, "-cache");
+
+	// the cache has no blend streams, skinning reads the source mesh
+	options.Skin = hasCmdOption(argc, argv, "-skin");
+	if (options.Skin && !options.Cache.empty())
 	{
-		std::string arg = argv[i];
-		if (0 == arg.find(option))
+		LogError() << "Warning: -cache is ignored with -skin\n";
+		options.Cache.clear();
+	}
+
+	options.NumThreads = atoi(getCmdOption(argc, argv, "-threads").c_str());
+
+	// LOD ratios: -lod 0.5,0.25
+	std::string lod = getCmdOption(argc, argv, "-lod");
+	if (!lod.empty())
+	{
+		std::vector<std::string> ratios;
+		Skylicht::CStringImp::splitString(lod.c_str(), ",", ratios);
+		for (size_t i = 0; i < ratios.size(); i++)
 		{
-			if (i + 1 < argc)
-				cmd = argv[i + 1];
-			return cmd;
+			float ratio = (float)atof(ratios[i].c_str());
+			if (ratio > 0.0f && ratio < 1.0f)
+				options.LODRatios.push_back(ratio);
+			else
+				LogError() << "Warning: skip LOD ratio " << ratios[i] << "\n";
 		}
 	}
-	return cmd;
+
+	options.LODObjects = hasCmdOption(argc, argv, "-lodobjects");
+	options.Optimize = hasCmdOption(argc, argv, "-optimize");
+
+	// skinning: -skin [-anim ANIMATION.sdkmesh_anim -time SECONDS]
+	options.Anim = getCmdOption(argc, argv, "-anim");
+	options.SkinTime = atof(getCmdOption(argc, argv, "-time").c_str());
+
+	// normals of the meshes without NORMAL element, -crease DEGREES splits the sharp edges
+	options.Crease = (float)atof(getCmdOption(argc, argv, "-crease").c_str());
+
+	options.Bounds = hasCmdOption(argc, argv, "-bounds");
+	options.Spheres = hasCmdOption(argc, argv, "-spheres");
+
+	// animated sequence: -sequence [-start SECONDS -end SECONDS]
+	options.Sequence = hasCmdOption(argc, argv, "-sequence");
+	std::string start = getCmdOption(argc, argv, "-start");
+	std::string end = getCmdOption(argc, argv, "-end");
+	options.Start = start.empty() ? 0.0 : atof(start.c_str());
+	options.End = end.empty() ? -1.0 : atof(end.c_str());
+
+	options.Incremental = getCmdOption(argc, argv, "-incremental");
+
+	// -budget MB: bounded memory streaming
+	options.Budget = (UINT64)(atof(getCmdOption(argc, argv, "-budget").c_str()) * 1024 * 1024);
+
+	// selective export: -select mesh:Rock*,material:Stone -exclude subset:*_lod*
+	options.Select = getCmdOption(argc, argv, "-select");
+	options.Exclude = getCmdOption(argc, argv, "-exclude");
+	if ((!options.Select.empty() || !options.Exclude.empty()) && !options.Cache.empty())
+	{
+		LogError() << "Warning: -cache is ignored with -select and -exclude\n";
+		options.Cache.clear();
+	}
+
+	// one OBJ per mesh, subset or material: -split mesh
+	options.Split = getCmdOption(argc, argv, "-split");
+
+	// positions only for collision meshes: -attributes position
+	options.Attributes = getCmdOption(argc, argv, "-attributes");
+
+	// right-handed, Y up, meters: -axes x,y,-z -scale 0.01
+	options.Axes = getCmdOption(argc, argv, "-axes");
+	options.Scale = getCmdOption(argc, argv, "-scale");
+	options.Transform = getCmdOption(argc, argv, "-transform");
+	options.FlipWinding = hasCmdOption(argc, argv, "-flipwinding");
 }
 
-int main(int argc, char** argv)
+// the per-file log of the batch & server conversions is discarded, unless -v
+LOG_LEVEL muteLog()
 {
-	std::string input = getCmdOption(argc, argv, "-i");
-	std::string output = getCmdOption(argc, argv, "-o");
+	LOG_LEVEL level = Log::GetLevel();
+	if (level < LOG_DEBUG)
+		Log::SetLevel(LOG_NONE);
+	return level;
+}
 
-	if (input.empty() || output.empty())
+// -batch LIST|DIR|GLOB -o TEMPLATE [-stats-json FILE]
+int convertBatch(const char *inputs, const char *outputTemplate, const ConvertOptions& options, ConversionCache *cache, int numThreads,
+	const char *statsPath)
+{
+	BatchConverter batch;
+	if (!batch.AddInputs(inputs))
 	{
-		std::cout << "Missing command: SDKMeshObjExporter.exe -i=INPUT.sdkmesh -o=OUTPUT.obj\n";
+		LogError() << "Error: no input found in " << inputs << "\n";
 		return 1;
 	}
 
-	SDKMesh sdkMesh;
-	HRESULT r = sdkMesh.Create(input.c_str());
-	if (r == E_FAIL)
+	if (!batch.SetOutputTemplate(outputTemplate))
 	{
-		std::cout << "Open " << input.c_str() << " failed!\n";
-		return -1;
+		LogError() << "Error: the batch output needs {name} or {path}: " << outputTemplate << "\n";
+		return 1;
 	}
 
-	OBJWriter writer(&sdkMesh, output.c_str());
-	if (writer.CanWrite() == false)
+	LogInfo() << "Batch: " << batch.GetNumItems() << " files\n";
+
+	LOG_LEVEL level = muteLog();
+
+	bool stats = statsPath != NULL;
+
+	UINT numFailed = batch.Run([&options, cache, stats](BatchItem& item)
 	{
-		std::cout << "Can not write: " << output.c_str() << "\n";
-		return -1;
-	}
+		ConvertResult result;
+		result.Stats = stats ? &item.Stats : NULL;
+
+		bool success = convertCached(item.Input.c_str(), item.Output.c_str(), options, cache, result) == 0;
+
+		item.Triangles = result.Triangles;
+		item.Cached = result.Cached;
+		return success;
+	}, numThreads);
+
+	Log::SetLevel(level);
+	batch.PrintStats();
+
+	if (stats && !batch.WriteStats(statsPath))
+		LogError() << "Can not write: " << statsPath << "\n";
+
+	return numFailed > 0 ? 1 : 0;
+}
+
+// -manifest FILE with -i INPUT or -batch LIST|DIR|GLOB: headers only, nothing is converted
+int writeManifest(const char *input, const char *inputs, const char *path)
+{
+	if (input != NULL)
+	{
+		MeshManifest manifest;
+		if (!manifest.Load(input))
+		{
+			LogError() << "Open " << input << " failed!\n";
+			return 1;
+		}
+
+		if (!manifest.Write(path))
+		{
+			LogError() << "Can not write: " << path << "\n";
+			return 1;
+		}
 
-	std::cout << "\n# Material infomations:\n";
+		LogInfo() << "Manifest: " << path << "\n";
+		return 0;
+	}
 
-	UINT numMaterials = sdkMesh.GetNumMaterials();
-	for (UINT i = 0; i < numMaterials; ++i)
+	BatchConverter batch;
+	if (!batch.AddInputs(inputs))
 	{
-		SDKMESH_MATERIAL* mat = sdkMesh.GetMaterial(i);
-		std::cout << "Material: " << mat->Name << std::endl;
-		std::cout << "- DiffuseMapName: " << mat->DiffuseTexture << std::endl;
-		std::cout << "- NormalMapName: " << mat->NormalTexture << std::endl;
+		LogError() << "Error: no input found in " << inputs << "\n";
+		return 1;
+	}
 
-		writer.WriteMaterial(mat);
+	remove(path);
+	FILE *file = fopen(path, "wt");
+	if (file == NULL)
+	{
+		LogError() << "Can not write: " << path << "\n";
+		return 1;
 	}
 
-	int errorCount = 0;
+	std::vector<std::string> failed;
 
-	std::cout << "\n# Mesh infomations:\n";
-	UINT numMeshes = sdkMesh.GetNumMeshes();
-	for (UINT meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+	JSONWriter json(file);
+	json.BeginObject();
+	json.BeginArray("files");
+
+	for (UINT i = 0; i < batch.GetNumItems(); i++)
 	{
-		std::cout << "\n Mesh ID: " << meshIdx << " - ";
+		const std::string& item = batch.GetItem(i).Input;
 
-		// Figure out the index type
-		if (sdkMesh.GetIndexType(meshIdx) == IT_32BIT)
-			std::cout << "32BIT";
+		MeshManifest manifest;
+		if (manifest.Load(item.c_str()))
+			manifest.Write(json);
 		else
-			std::cout << "16BIT";
+			failed.push_back(item);
+	}
 
-		UINT numPrims = static_cast<UINT>(sdkMesh.GetNumIndices(meshIdx) / 3);
-		UINT numVerts = static_cast<UINT>(sdkMesh.GetNumVertices(meshIdx, 0));
+	json.EndArray();
 
-		std::cout << " - Prims: " << numPrims << ", Verts: " << numVerts << std::endl;
+	json.BeginArray("failed");
+	for (size_t i = 0; i < failed.size(); i++)
+		json.Write(NULL, failed[i].c_str());
+	json.EndArray();
 
-		std::cout << " - Vertex buffer elements\n";
-		sdkMesh.PrintVBElements(sdkMesh.VBElements(meshIdx, 0));
+	json.EndObject();
+	json.Finish();
 
-		SDKMESH_MESH* mesh = sdkMesh.GetMesh(meshIdx);
+	bool success = ferror(file) == 0;
+	if (fclose(file) != 0 || !success)
+	{
+		LogError() << "Can not write: " << path << "\n";
+		return 1;
+	}
 
-		// write name
-		writer.WriteObject(mesh->Name);
+	for (size_t i = 0; i < failed.size(); i++)
+		LogError() << "Failed: " << failed[i] << "\n";
 
-		UINT numSubsets = sdkMesh.GetNumSubsets(meshIdx);
+	LogInfo() << "Manifest: " << path << " (" << batch.GetNumItems() - failed.size() << " files)\n";
+	return failed.empty() ? 0 : 1;
+}
 
-		for (UINT i = 0; i < numSubsets; ++i)
+// -info with -i INPUT or -batch LIST|DIR|GLOB [-threads N]: triangle, vertex & subset totals from the headers
+int printInfo(const char *input, const char *inputs, int numThreads)
+{
+	MeshInfo info;
+	if (input != NULL)
+		info.AddFile(input);
+	else
+	{
+		BatchConverter batch;
+		if (!batch.AddInputs(inputs))
 		{
-			SDKMESH_SUBSET* subset = sdkMesh.GetSubset(meshIdx, i);
-
-			int materialID = subset->MaterialID;
-			SDKMESH_MATERIAL* mat = sdkMesh.GetMaterial(materialID);
-
-			int faceStart = static_cast<DWORD>(subset->IndexStart / 3);
-			int faceCount = static_cast<DWORD>(subset->IndexCount / 3);
-
-			int vertexStart = static_cast<DWORD>(subset->VertexStart);
-			int vertexCount = static_cast<DWORD>(subset->VertexCount);
-
-			const char *PrimitiveType[] = {
-				"PT_TRIANGLE_LIST",
-				"PT_TRIANGLE_STRIP",
-				"PT_LINE_LIST",
-				"PT_LINE_STRIP",
-				"PT_POINT_LIST",
-				"PT_TRIANGLE_LIST_ADJ",
-				"PT_TRIANGLE_STRIP_ADJ",
-				"PT_LINE_LIST_ADJ",
-				"PT_LINE_STRIP_ADJ",
-				"PT_QUAD_PATCH_LIST",
-				"PT_TRIANGLE_PATCH_LIST",
-			};
-
-			std::cout << "- Subset: " << i << " " << mat->Name << " - " << PrimitiveType[subset->PrimitiveType] << std::endl;
-			std::cout << "  + Indices start: " << subset->IndexStart << std::endl;
-			std::cout << "  + Indices count: " << subset->IndexCount << std::endl;
-			std::cout << "  + Face count: " << faceCount << std::endl;
-
-			if (subset->PrimitiveType == 0)
-			{
-				if (writer.WriteSubset(meshIdx, mesh, subset, numSubsets > 1) == true)
-					std::cout << "  -> Writed!\n";
-				else
-					std::cout << "  -> Write error!\n";
-			}
-			else
+			LogError() << "Error: no input found in " << inputs << "\n";
+			return 1;
+		}
+
+		for (UINT i = 0; i < batch.GetNumItems(); i++)
+			info.AddFile(batch.GetItem(i).Input);
+	}
+
+	UINT numFailed = info.Run(numThreads);
+	info.PrintStats();
+	return numFailed > 0 ? 1 : 0;
+}
+
+// -serve SOCKET [-jobs N]
+int runServer(const char *path, int numJobs)
+{
+	ConversionServer server(path);
+	LogInfo() << "Listening on " << path << "\n";
+	Log::Flush();
+
+	LOG_LEVEL level = muteLog();
+
+	bool success = server.Run([](const ServerRequest& request, std::vector<BYTE>& buffer, ServerResponse& response)
+	{
+		// the options of the request as a command line
+		std::vector<char*> args;
+		args.push_back((char*)"server");
+		for (size_t i = 0; i < request.Options.size(); i++)
+			args.push_back((char*)request.Options[i].c_str());
+
+		ConvertOptions options;
+		parseOptions((int)args.size(), args.data(), options);
+
+		ConversionCache *cache = NULL;
+		if (!options.Incremental.empty())
+			cache = new ConversionCache(options.Incremental.c_str());
+
+		ConvertResult result;
+		response.Success = MappedFile::CreateFolders(request.Output.c_str()) &&
+			convertCached(request.Input.c_str(), request.Output.c_str(), options, cache, result, &buffer) == 0;
+		response.Triangles = result.Triangles;
+		response.Cached = result.Cached;
+
+		delete cache;
+	}, numJobs);
+
+	Log::SetLevel(level);
+
+	if (!success)
+	{
+		LogError() << "Error: can not listen on " << path << "\n";
+		return 1;
+	}
+
+	LogInfo() << "Stopped\n";
+	return 0;
+}
+
+// -client SOCKET -i INPUT -o OUTPUT [options], or -client SOCKET -stop|-stats
+int runClient(int argc, char** argv, const char *path)
+{
+	std::string request;
+
+	if (hasCmdOption(argc, argv, "-stop"))
+	{
+		request = "shutdown";
+	}
+	else if (hasCmdOption(argc, argv, "-stats"))
+	{
+		request = "stats";
+	}
+	else
+	{
+		std::string input, output, options;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if ((arg == "-client" || arg == "-i" || arg == "-o") && hasValue)
 			{
-				std::cout << "  -> Error: OBJ Exporter just support TRIANGLE_LIST!\n";
-				errorCount++;
+				if (arg == "-i")
+					input = ConversionServer::GetAbsolutePath(argv[i + 1]);
+				else if (arg == "-o")
+					output = ConversionServer::GetAbsolutePath(argv[i + 1]);
+				i++;
+				continue;
 			}
+
+			// the server has its own working folder
+			bool isPath = (arg == "-anim" || arg == "-incremental" || arg == "-cache") && hasValue;
+
+			options += "\t" + arg;
+			if (isPath)
+				options += "\t" + ConversionServer::GetAbsolutePath(argv[++i]);
 		}
+
+		if (input.empty() || output.empty())
+		{
+			LogError() << "Missing command: SDKMeshObjExporter.exe -client SOCKET -i INPUT.sdkmesh -o OUTPUT.obj\n";
+			return 1;
+		}
+
+		request = "convert\t" + input + "\t" + output + options;
 	}
 
-	if (errorCount > 0)
-		std::cout << "Error: " << errorCount;
-	else
-		std::cout << "Finished!\n";
+	std::string answer;
+	if (!ConversionServer::Send(path, request, answer))
+	{
+		LogError() << "Error: no server on " << path << "\n";
+		return 1;
+	}
+
+	std::vector<std::string> fields;
+	ConversionServer::Split(answer, fields);
+
+	if (fields[0] != "ok")
+	{
+		LogError() << "Error: " << (fields.size() > 2 ? fields[2] : answer) << "\n";
+		return 1;
+	}
+
+	if (fields.size() >= 4 && request != "stats")
+		LogInfo() << "Finished! " << fields[1] << " ms, " << fields[2] << " triangles" << (fields[3] == "1" ? " (from cache)" : "") << "\n";
+	else if (fields.size() >= 4)
+		LogInfo() << "Requests: " << fields[1] << ", failed: " << fields[2] << ", time: " << fields[3] << " ms\n";
 
 	return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char** argv)
+{
+	// -q: errors & warnings only, -v: every material, mesh and subset
+	if (hasCmdOption(argc, argv, "-v"))
+		Log::SetLevel(LOG_DEBUG);
+	else if (hasCmdOption(argc, argv, "-q"))
+		Log::SetLevel(LOG_ERROR);
+
+	// persistent server and its client
+	std::string serve = getCmdOption(argc, argv, "-serve");
+	if (!serve.empty())
+		return runServer(serve.c_str(), atoi(getCmdOption(argc, argv, "-jobs").c_str()));
+
+	std::string client = getCmdOption(argc, argv, "-client");
+	if (!client.empty())
+		return runClient(argc, argv, client.c_str());
+
+	std::string input = getCmdOption(argc, argv, "-i");
+	std::string output = getCmdOption(argc, argv, "-o");
+	std::string batch = getCmdOption(argc, argv, "-batch");
+
+	std::string manifest = getCmdOption(argc, argv, "-manifest");
+	if (!manifest.empty() && (!input.empty() || !batch.empty()))
+		return writeManifest(input.empty() ? NULL : input.c_str(), batch.c_str(), manifest.c_str());
+
+	if (hasCmdOption(argc, argv, "-info") && (!input.empty() || !batch.empty()))
+		return printInfo(input.empty() ? NULL : input.c_str(), batch.c_str(), atoi(getCmdOption(argc, argv, "-threads").c_str()));
+
+	if ((input.empty() && batch.empty()) || output.empty())
+	{
+		LogError() << "Missing command: SDKMeshObjExporter.exe -i=INPUT.sdkmesh -o=OUTPUT.obj\n";
+		LogError() << "                 SDKMeshObjExporter.exe -batch=LIST|DIR|GLOB -o=OUTPUT/{name}.obj\n";
+		LogError() << "                 SDKMeshObjExporter.exe -i=INPUT.sdkmesh|-batch=LIST|DIR|GLOB -manifest=MANIFEST.json\n";
+		LogError() << "                 SDKMeshObjExporter.exe -i=INPUT.sdkmesh|-batch=LIST|DIR|GLOB -info\n";
+		return 1;
+	}
+
+	ConvertOptions options;
+	parseOptions(argc, argv, options);
+
+	// per-phase times & counters report
+	std::string statsPath = getCmdOption(argc, argv, "-stats-json");
+
+	// outputs of unchanged sources are reused
+	ConversionCache *cache = NULL;
+	if (!options.Incremental.empty())
+		cache = new ConversionCache(options.Incremental.c_str());
+
+	if (!batch.empty())
+	{
+		// one file per task, the file conversions do not share a cache
+		if (!options.Cache.empty())
+		{
+			LogError() << "Warning: -cache is ignored with -batch\n";
+			options.Cache.clear();
+		}
+
+		// -jobs: workers of the pool, -threads: tasks per parallel stage of a file
+		int numJobs = atoi(getCmdOption(argc, argv, "-jobs").c_str());
+		int r = convertBatch(batch.c_str(), output.c_str(), options, cache, numJobs, statsPath.empty() ? NULL : statsPath.c_str());
+		delete cache;
+		return r;
+	}
+
+	ConvertStats stats;
+	ConvertResult result;
+	if (!statsPath.empty())
+		result.Stats = &stats;
+
+	int r = convertCached(input.c_str(), output.c_str(), options, cache, result);
+	delete cache;
+
+	if (!statsPath.empty() && !stats.WriteReport(statsPath.c_str(), input.c_str(), output.c_str(), r))
+		LogError() << "Can not write: " << statsPath << "\n";
+
+	return r < 0 ? -1 : 0;
+}